@@ -23,30 +23,32 @@
 #define OFF_MOVE (otherColor(onMove))
 
 /* 
- * Function: whitePawnMovesTo
+ * Function: pawnMovesTo
  * Input:    A pointer to an array of moves, a bitboard of squares and a piece.
  * Output:   None.
  * Purpose:  Fills the array and increments the pointer to that array with
- *           white's pawn moves to a bitboard of squares.
+ *           C's pawn moves to a bitboard of squares.
  */
 
-void boardStruct::whitePawnMovesTo(move **m, bitboard possibleTo, piece promote)
+template <color C> void boardStruct::pawnMovesTo(move **m, bitboard possibleTo, piece promote)
    {
-   	
+   const int left = (C == WHITE) ? 7 : 9;
+   const int right = (C == WHITE) ? 9 : 7;
    bitboard to, to2;
    square sq;
 
    /* Step 1: Generate single push moves to the square by shifting the pawn
       bitboard forward one rank */
 
-   to = possibleTo & (pieces[PAWN] & occupied[WHITE]) << ONE_RANK &
+   to = possibleTo & forward<C>(pieces[PAWN] & occupied[C]) &
          ~(occupied[WHITE] | occupied[BLACK]);
 
    /* Step 2: Generate double push moves to the square by shifting moving the
-      pawns forward again and anding off rank other than the 4th */
+      pawns forward again and anding off rank other than the 4th (5th for
+      black) */
 
-   to2 = possibleTo & (to << ONE_RANK) &
-          FOURTH_RANK & ~(occupied[WHITE] | occupied[BLACK]);
+   to2 = possibleTo & forward<C>(to) &
+          doublePushRank<C>() & ~(occupied[WHITE] | occupied[BLACK]);
 
    /* Step 3: Put the pawn moves into the array */
 
@@ -54,111 +56,81 @@ void boardStruct::whitePawnMovesTo(move **m, bitboard possibleTo, piece promote)
       {
       sq = firstSquare(to.data);
       to.unsetSquare(sq);
-      *((*m)++) = move(sq - ONE_RANK, sq, PAWN, promote);
+      *((*m)++) = move(sq - pawnPush<C>(), sq, PAWN, promote);
       }
 
    while (to2.hasBits()) 
       {
       sq = firstSquare(to2.data);
       to2.unsetSquare(sq);
-      *((*m)++) = move(sq - TWO_RANKS, sq, PAWN, promote);
+      *((*m)++) = move(sq - 2 * pawnPush<C>(), sq, PAWN, promote);
       }
 
    /* Step 4: Generate captures to the left by anding off the pawns on the
       a file and shifting the bitboard by a rank minus a file */
 
-   to = (possibleTo & ((pieces[PAWN] & occupied[WHITE] & ~A_FILE) >> 7) &
-         occupied[BLACK]);
+   to = (possibleTo & ((pieces[PAWN] & occupied[C] & ~A_FILE) >> left) &
+         occupied[otherColor(C)]);
   
    while (to.hasBits()) 
       {
       sq = firstSquare(to.data);
       to.unsetSquare(sq);
-      *((*m)++) = move(sq + 7, sq, PAWN, promote);
+      *((*m)++) = move(sq + left, sq, PAWN, promote);
       }
 
    /* Step 5: Generate captures to the right by doing the opposite of
       captures to the left */
 
-   to = (possibleTo & ((pieces[PAWN] & occupied[WHITE] & ~H_FILE) << 9) &
-         occupied[BLACK]);
+   to = (possibleTo & ((pieces[PAWN] & occupied[C] & ~H_FILE) << right) &
+         occupied[otherColor(C)]);
 
    while (to.hasBits()) 
       {
       sq = firstSquare(to.data);
       to.unsetSquare(sq);
-      *((*m)++) = move(sq - 9, sq, PAWN, promote);
+      *((*m)++) = move(sq - right, sq, PAWN, promote);
       }
 
    }
 
 
 /* 
- * Function: blackPawnMovesTo
- * Input:    A pointer to an array of moves, a bitboard of squares and a piece
+ * Function: pawnPushesTo
+ * Input:    A pointer to an array of moves and a bitboard of squares
  * Output:   None.
  * Purpose:  Fills the array and increments the pointer to that array with
- *           black's pawn moves to a bitboard of squares.
+ *           C's pawn pushes to a bitboard of empty squares.  Promotions
+ *           are left to captureMoves().  Unlike pawnMovesTo() the square
+ *           a double push goes through doesn't have to be in possibleTo.
  */
 
-void boardStruct::blackPawnMovesTo(move **m, bitboard possibleTo, piece promote)
+template <color C> void boardStruct::pawnPushesTo(move **m, bitboard possibleTo)
    {
-   bitboard to, to2;
+   bitboard dest, dest2, unoccupied;
    square sq;
 
-   /* Step 1: Generate single push moves to that square by shifting the pawn
-      bitboard forward one rank */
-
-   to = possibleTo & (pieces[PAWN] & occupied[BLACK]) >> ONE_RANK &
-        ~(occupied[WHITE] | occupied[BLACK]);
-
-   /* Step 2: Generate double push moves to the square by shifting moving the
-      pawns forward again and anding off rank other than the 5th */
-
-   to2 = possibleTo & (to >> ONE_RANK) &
-         FIFTH_RANK & ~(occupied[WHITE] | occupied[BLACK]);
+   unoccupied = (~(occupied[WHITE] | occupied[BLACK]));
 
+   dest = forward<C>(pieces[PAWN] & occupied[C]) & ~lastRank<C>() & possibleTo;
 
-   /* Step 3: Put the pawn moves into the array */
+   /* Get the bitboard of double pawn moves */
 
-   while (to.hasBits()) 
-      {
-      sq = firstSquare(to.data);
-      to.unsetSquare(sq);
-      *((*m)++) = move(sq + ONE_RANK, sq, PAWN, promote);
-      }
-
-   while (to2.hasBits()) 
+   dest2 = forward<C>(forward<C>(pieces[PAWN] & occupied[C]) & unoccupied) & 
+           doublePushRank<C>() & possibleTo;
+                        
+   while (dest.hasBits()) 
       {
-      sq = firstSquare(to2.data);
-      to2.unsetSquare(sq);
-      *((*m)++) = move(sq + TWO_RANKS, sq, PAWN, promote);
+      sq = firstSquare(dest.data);
+      dest.unsetSquare(sq);
+      *((*m)++) = move(sq - pawnPush<C>(), sq, PAWN);
       }
 
-   /* Step 4:  Generate captures to the left by anding off the pawns on the
-      a file and shifting the bitboard by a rank minus a file */
-
-   to = (possibleTo & ((pieces[PAWN] & occupied[BLACK] & ~A_FILE) >> 9) &
-         occupied[WHITE]);
-
-   while (to.hasBits()) 
+   while (dest2.hasBits()) 
       {
-      sq = firstSquare(to.data);
-      to.unsetSquare(sq);
-      *((*m)++) = move(sq + 9, sq, PAWN, promote);
-      }
-
-   /* Step 5:  Generate captures to the right by doing the opposite of
-      captures to the left */
-
-   to = (possibleTo & ((pieces[PAWN] & occupied[BLACK] & ~H_FILE) << 7) &
-         occupied[WHITE]);
-
-   while (to.hasBits()) 
-      {
-      sq = firstSquare(to.data);
-      to.unsetSquare(sq);
-      *((*m)++) = move(sq - 7, sq, PAWN, promote);
+      sq = firstSquare(dest2.data);
+      dest2.unsetSquare(sq);
+      *((*m)++) = move(sq - 2 * pawnPush<C>(), sq, PAWN);
       }
    }
 
@@ -195,7 +167,7 @@ void fillMoveArray(move **m, square from, piece p, bitboard dest)
  *           in a bitboard if the knight can not be captured ( its a possible mate ) 
  */
 
-void fillMoveArrayMateTriesKnights (move **m, square from, bitboard dest, sword attacks[COLORS][64], color onMove)
+void fillMoveArrayMateTriesKnights (move **m, square from, bitboard dest, sbyte attacks[COLORS][64], color onMove)
    {
    square to;
   
@@ -216,7 +188,7 @@ void fillMoveArrayMateTriesKnights (move **m, square from, bitboard dest, sword
  *           in a bitboard if the piece can not be captured ( its a possible mate ) 
  */
 
-void fillMoveArrayMateTriesOthers (move **m, square from, piece p, bitboard dest, sword attacks[COLORS][64], color onMove)
+void fillMoveArrayMateTriesOthers (move **m, square from, piece p, bitboard dest, sbyte attacks[COLORS][64], color onMove)
    {
    square to;
   
@@ -232,7 +204,7 @@ void fillMoveArrayMateTriesOthers (move **m, square from, piece p, bitboard dest
   
 /*
  * Function: AIMoves
- * Input:    An array to fill with moves.
+ * Input:    An array to fill with moves and the squares drops may go to.
  * Output:   The number of moves generated.
  * Purpose:  Used by search() to generate moves.  It fills an array
  *           of moves.
@@ -244,27 +216,30 @@ void fillMoveArrayMateTriesOthers (move **m, square from, piece p, bitboard dest
  *           to square and then taking off the bits until the bitboard is empty.
  *			 First the moves to generateToFirst[Piece][Color][dropMove] are created, 
  *			 since they have been better in history.
+ *           C is the side to move.
  */
 
-int boardStruct::aiMoves(move *m)
+template <color C> int boardStruct::aiMoves(move *m, bitboard dropTo)
    {
+   const square backRank = (C == WHITE) ? 0 : 7;
    move *original;
    square sq;
    piece p;
-   bitboard thePieces, dest, dest2, unoccupied, trythose;
+   bitboard thePieces, dest, unoccupied, dropSquares, trythose;
 
    original = m;   
 
    unoccupied = (~(occupied[WHITE] | occupied[BLACK]));
+   dropSquares = unoccupied & dropTo;
 
 
    /* Generate bishop/rook/queen moves bitboard by and-ing the attack bitboard
       with the empty squares */
 
-   trythose = generateToFirst[BISHOP][onMove][0] & unoccupied; 
+   trythose = generateToFirst[BISHOP][C][0] & unoccupied; 
   
    
-   thePieces = pieces[BISHOP] & occupied[onMove];
+   thePieces = pieces[BISHOP] & occupied[C];
    while (thePieces.hasBits()) 
       {
       sq = firstSquare(thePieces.data);
@@ -273,9 +248,9 @@ int boardStruct::aiMoves(move *m)
       fillMoveArray(&m, sq, BISHOP, dest);
       }
 
-   trythose = generateToFirst[ROOK][onMove][0] & unoccupied;
+   trythose = generateToFirst[ROOK][C][0] & unoccupied;
 
-   thePieces = pieces[ROOK] & occupied[onMove];
+   thePieces = pieces[ROOK] & occupied[C];
    while (thePieces.hasBits()) 
       {
       sq = firstSquare(thePieces.data);
@@ -284,9 +259,9 @@ int boardStruct::aiMoves(move *m)
       fillMoveArray(&m, sq, ROOK, dest);
       }
 
-   trythose = generateToFirst[QUEEN][onMove][0] & unoccupied;
+   trythose = generateToFirst[QUEEN][C][0] & unoccupied;
 
-   thePieces = pieces[QUEEN] & occupied[onMove];
+   thePieces = pieces[QUEEN] & occupied[C];
    while (thePieces.hasBits()) 
       {
       sq = firstSquare(thePieces.data);
@@ -297,9 +272,9 @@ int boardStruct::aiMoves(move *m)
 
   /* Generate the knight moves bitboard by using the lookup table */
 
-   trythose = generateToFirst[KNIGHT][onMove][0] & unoccupied;
+   trythose = generateToFirst[KNIGHT][C][0] & unoccupied;
 
-   thePieces = pieces[KNIGHT] & occupied[onMove];
+   thePieces = pieces[KNIGHT] & occupied[C];
    while (thePieces.hasBits()) 
       {
       sq = firstSquare(thePieces.data);
@@ -317,70 +292,27 @@ int boardStruct::aiMoves(move *m)
      spaces on the 4th rank to get double pawn moves.
   */
 
-   trythose = generateToFirst[PAWN][onMove][0] & unoccupied;
-
-   if (onMove == WHITE) 
-      {
-      dest = ((pieces[PAWN] & occupied[WHITE]) << ONE_RANK) & ~EIGHTH_RANK & trythose;
-
-     //* Get the bitboard of double pawn moves 
-
-      dest2 = ((((pieces[PAWN] & occupied[WHITE]) << ONE_RANK) & ~EIGHTH_RANK & unoccupied) << ONE_RANK) & trythose & FOURTH_RANK;
-                        
-      while (dest.hasBits()) 
-         {
-         sq = firstSquare(dest.data);
-         dest.unsetSquare(sq);
-         *(m++) = move(sq - ONE_RANK, sq, PAWN);
-         }
-
-      while (dest2.hasBits()) 
-         {
-         sq = firstSquare(dest2.data);
-         dest2.unsetSquare(sq);
-         *(m++) = move(sq - TWO_RANKS, sq, PAWN);
-         }
-      }
-   else 
-      {
-      dest = ((pieces[PAWN] & occupied[BLACK]) >> ONE_RANK) & ~FIRST_RANK & trythose;
-
-      //* Get the bitboard of double pawn moves
+   trythose = generateToFirst[PAWN][C][0] & unoccupied;
 
-      dest2 = ((((pieces[PAWN] & occupied[BLACK]) >> ONE_RANK) & ~EIGHTH_RANK & unoccupied) >> ONE_RANK) & trythose & FIFTH_RANK;
-
-      while (dest.hasBits()) 
-         {
-         sq = firstSquare(dest.data);
-         dest.unsetSquare(sq);
-         *(m++) = move(sq + ONE_RANK, sq, PAWN);
-         }
-
-      while (dest2.hasBits()) 
-         {
-         sq = firstSquare(dest2.data);
-         dest2.unsetSquare(sq);
-         *(m++) = move(sq + TWO_RANKS, sq, PAWN);
-         }
-      }
+   pawnPushesTo<C>(&m, trythose);
 
 
 
     /* Get the dropping moves, the from square in IN_HAND the to square
       is any unoccupied square (except for the 1st, 8th rank for pawns). */
 
-   if (hand[onMove][PAWN]) 
+   if (hand[C][PAWN]) 
       {
-      trythose = generateToFirst[PAWN][onMove][1] & unoccupied;
+      trythose = generateToFirst[PAWN][C][1] & dropSquares;
 	  dest = trythose & ~(FIRST_RANK | EIGHTH_RANK);
       fillMoveArray(&m, IN_HAND, PAWN, dest);
       }
 
    for (p = ROOK; p <= LAST_PIECE; p = (piece) (p + 1)) 
       {
-      if (hand[onMove][p]) 
+      if (hand[C][p]) 
          {
-		 trythose = generateToFirst[p][onMove][1] & unoccupied;
+		 trythose = generateToFirst[p][C][1] & dropSquares;
          fillMoveArray(&m, IN_HAND, p, trythose);
          }
       }
@@ -390,9 +322,9 @@ int boardStruct::aiMoves(move *m)
    /* Generate bishop/rook/queen moves bitboard by and-ing the attack bitboard
       with the empty squares */
 
-   trythose = ~generateToFirst[BISHOP][onMove][0] & unoccupied;
+   trythose = ~generateToFirst[BISHOP][C][0] & unoccupied;
   
-   thePieces = pieces[BISHOP] & occupied[onMove];
+   thePieces = pieces[BISHOP] & occupied[C];
    while (thePieces.hasBits()) 
       {
       sq = firstSquare(thePieces.data);
@@ -401,9 +333,9 @@ int boardStruct::aiMoves(move *m)
       fillMoveArray(&m, sq, BISHOP, dest);
       }
 
-   trythose = ~generateToFirst[ROOK][onMove][0] & unoccupied;
+   trythose = ~generateToFirst[ROOK][C][0] & unoccupied;
    
-   thePieces = pieces[ROOK] & occupied[onMove];
+   thePieces = pieces[ROOK] & occupied[C];
    while (thePieces.hasBits()) 
       {
       sq = firstSquare(thePieces.data);
@@ -412,9 +344,9 @@ int boardStruct::aiMoves(move *m)
       fillMoveArray(&m, sq, ROOK, dest);
       }
 
-   trythose = ~generateToFirst[QUEEN][onMove][0] & unoccupied;
+   trythose = ~generateToFirst[QUEEN][C][0] & unoccupied;
    
-   thePieces = pieces[QUEEN] & occupied[onMove];
+   thePieces = pieces[QUEEN] & occupied[C];
    while (thePieces.hasBits()) 
       {
       sq = firstSquare(thePieces.data);
@@ -425,9 +357,9 @@ int boardStruct::aiMoves(move *m)
 
   /* Generate the knight moves bitboard by using the lookup table */
 
-   trythose = ~generateToFirst[KNIGHT][onMove][0] & unoccupied;
+   trythose = ~generateToFirst[KNIGHT][C][0] & unoccupied;
    
-   thePieces = pieces[KNIGHT] & occupied[onMove];
+   thePieces = pieces[KNIGHT] & occupied[C];
    while (thePieces.hasBits()) 
       {
       sq = firstSquare(thePieces.data);
@@ -445,70 +377,27 @@ int boardStruct::aiMoves(move *m)
      spaces on the 4th rank to get double pawn moves.
 	 */
 
-   trythose = ~generateToFirst[PAWN][onMove][0] & unoccupied;
-
-   if (onMove == WHITE) 
-      {
-      dest = ((pieces[PAWN] & occupied[WHITE]) << ONE_RANK) & ~EIGHTH_RANK & trythose;
-
-      //* Get the bitboard of double pawn moves 
-
-      dest2 = ((((pieces[PAWN] & occupied[WHITE]) << ONE_RANK) & ~EIGHTH_RANK & unoccupied) << ONE_RANK) & FOURTH_RANK & trythose ;
-                        
-      while (dest.hasBits()) 
-         {
-         sq = firstSquare(dest.data);
-         dest.unsetSquare(sq);
-         *(m++) = move(sq - ONE_RANK, sq, PAWN);
-         }
-
-      while (dest2.hasBits()) 
-         {
-         sq = firstSquare(dest2.data);
-         dest2.unsetSquare(sq);
-         *(m++) = move(sq - TWO_RANKS, sq, PAWN);
-         }
-      }
-   else 
-      {
-      dest = ((pieces[PAWN] & occupied[BLACK]) >> ONE_RANK) & ~FIRST_RANK & trythose;
-
-      //* Get the bitboard of double pawn moves 
-
-      dest2 = ((((pieces[PAWN] & occupied[BLACK]) >> ONE_RANK) & ~FIRST_RANK & unoccupied) >> ONE_RANK) & FIFTH_RANK & trythose;
+   trythose = ~generateToFirst[PAWN][C][0] & unoccupied;
 
-      while (dest.hasBits()) 
-         {
-         sq = firstSquare(dest.data);
-         dest.unsetSquare(sq);
-         *(m++) = move(sq + ONE_RANK, sq, PAWN);
-         }
-
-      while (dest2.hasBits()) 
-         {
-         sq = firstSquare(dest2.data);
-         dest2.unsetSquare(sq);
-         *(m++) = move(sq + TWO_RANKS, sq, PAWN);
-         }
-      }
+   pawnPushesTo<C>(&m, trythose);
 
 
 
     // Get the dropping moves, the from square in IN_HAND the to square
     //  is any unoccupied square (except for the 1st, 8th rank for pawns). 
 
-   if (hand[onMove][PAWN]) 
+   if (hand[C][PAWN]) 
       {
-	  trythose = ~generateToFirst[PAWN][onMove][1] & unoccupied;
+	  trythose = ~generateToFirst[PAWN][C][1] & dropSquares;
       dest = trythose & ~(FIRST_RANK | EIGHTH_RANK);
       fillMoveArray(&m, IN_HAND, PAWN, dest);
       }
 
    for (p = ROOK; p <= LAST_PIECE; p = (piece) (p + 1)) 
       {
-      if (hand[onMove][p]) 
+      if (hand[C][p]) 
          {
-		 trythose = ~generateToFirst[p][onMove][1] & unoccupied;
+		 trythose = ~generateToFirst[p][C][1] & dropSquares;
          fillMoveArray(&m, IN_HAND, p, trythose);
          }
       }
@@ -517,37 +406,26 @@ int boardStruct::aiMoves(move *m)
    
    /* Get king moves.  This is just a lookup table. */
 
-   sq = kingSquare[onMove];
+   sq = kingSquare[C];
    dest = kingAttacks[sq] & unoccupied;
    fillMoveArray(&m, sq, KING, dest);
 
   
    /* See if castle moves are possible by looking in canCastle and making sure
-      the squares in between are okay to go through */
+      the squares in between are okay to go through.  The squares on black's
+      first rank are the ones on white's plus 7 */
   
-   if (onMove == WHITE && !isInCheck(WHITE)) 
+   if (!isInCheck(C)) 
       {
-      if (canCastle[WHITE][KING_SIDE] && position[F1] == NONE && 
-          position[G1] == NONE && attacks[BLACK][F1] == 0 &&
-          attacks[BLACK][G1]== 0)
-         *m++ = move(E1, G1, KING);
-
-      if (canCastle[WHITE][QUEEN_SIDE] && position[D1] == NONE &&
-            position[C1] == NONE && position[B1] == NONE &&
-            attacks[BLACK][D1] == 0 && attacks[BLACK][C1] == 0)
-         *m++ = move(E1, C1, KING);
-      }
-   else if (onMove == BLACK && !isInCheck(BLACK)) 
-      {
-      if (canCastle[BLACK][KING_SIDE] && position[F8] == NONE &&
-             position[G8] == NONE && attacks[WHITE][F8] == 0 &&
-             attacks[WHITE][G8] == 0)
-         *m++ = move(E8, G8, KING);
-    
-      if (canCastle[BLACK][QUEEN_SIDE] && position[D8] == NONE &&
-            position[C8] == NONE && position[B8] == NONE &&
-            attacks[WHITE][D8] == 0 && attacks[WHITE][C8] == 0)
-         *m++ = move(E8, C8, KING);
+      if (canCastle[C][KING_SIDE] && position[F1 + backRank] == NONE && 
+          position[G1 + backRank] == NONE && attacks[otherColor(C)][F1 + backRank] == 0 &&
+          attacks[otherColor(C)][G1 + backRank] == 0)
+         *m++ = move(E1 + backRank, G1 + backRank, KING);
+
+      if (canCastle[C][QUEEN_SIDE] && position[D1 + backRank] == NONE &&
+            position[C1 + backRank] == NONE && position[B1 + backRank] == NONE &&
+            attacks[otherColor(C)][D1 + backRank] == 0 && attacks[otherColor(C)][C1 + backRank] == 0)
+         *m++ = move(E1 + backRank, C1 + backRank, KING);
       }
 
   
@@ -558,6 +436,19 @@ int boardStruct::aiMoves(move *m)
 	
 	  }
 
+/*
+ * Function: aiMoves
+ * Input:    An array to fill with moves and the squares drops may go to.
+ * Output:   The number of moves generated.
+ * Purpose:  Calls aiMoves<C>() for the side to move.
+ */
+
+int boardStruct::aiMoves(move *m, bitboard dropTo)
+   {
+   if (onMove == WHITE) return aiMoves<WHITE>(m, dropTo);
+   return aiMoves<BLACK>(m, dropTo);
+   }
+
 /*
  * Function: mateTries
  * Input:    An array to fill with moves.
@@ -674,26 +565,34 @@ int boardStruct::mateTries(move *m)
  * Purpose:  Generates the underpromotions that aiMoves skips
  */
 
-int boardStruct::skippedMoves(move *m)
+template <color C> int boardStruct::skippedMoves(move *m)
    {
-   bitboard dest;
    move *original;
 
    original = m;
 
-   if (onMove == WHITE) 
-      {
-      dest = EIGHTH_RANK;
-      whitePawnMovesTo(&m, dest, ROOK);
-      whitePawnMovesTo(&m, dest, BISHOP);
-      }
-   else 
-      {
-      dest = FIRST_RANK;
-      blackPawnMovesTo(&m, dest, ROOK);
-      blackPawnMovesTo(&m, dest, BISHOP);
-      }
+   pawnMovesTo<C>(&m, lastRank<C>(), ROOK);
+   pawnMovesTo<C>(&m, lastRank<C>(), BISHOP);
    m->makeBad();
    return m - original;
    }
 
+
+/* 
+ * Function: skippedMoves
+ * Input:    An array to fill with moves.
+ * Output:   The number of moves generated.
+ * Purpose:  Calls skippedMoves<C>() for the side to move.
+ */
+
+int boardStruct::skippedMoves(move *m)
+   {
+   if (onMove == WHITE) return skippedMoves<WHITE>(m);
+   return skippedMoves<BLACK>(m);
+   }
+
+
+/* captureMoves() and checkingMoves() live in other files */
+
+template void boardStruct::pawnMovesTo<WHITE>(move **m, bitboard possibleTo, piece promote);
+template void boardStruct::pawnMovesTo<BLACK>(move **m, bitboard possibleTo, piece promote);
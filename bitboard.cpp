@@ -34,116 +34,11 @@
 #include "interface.h"
 #include "brain.h" 
 
-/* following are lots of arrays for bitboards.  They contain information that
-   can be calculated beforehand and so when the value is needed durring a
-   search all that as to be done is an index to the array.  */
-
-/* a bitboard where just the one bit is set */
-
-qword BitInBB[SQUARES]; 
-
-
-/* Attacks is an array of bitboards of where a short range piece attacks from 
-   each square */
-
-bitboard pawnAttacks[COLORS][SQUARES];
-bitboard contactBishopAttacks[SQUARES];
-bitboard contactRookAttacks[SQUARES];
-bitboard knightAttacks[SQUARES];
-bitboard kingAttacks[SQUARES];
-
-/* squaresTo gives the squares in between the first square and the second
-   square, including the second square (if the squares are a knight move apart
-   then just the second square).  It's used to see what squares a
-   player can block or capture to get out of check with */
-
-bitboard squaresTo[SQUARES][SQUARES];
-
-/* nearSquares are squares 2 or less squares away */
-
-bitboard nearSquares[SQUARES][COLORS];
-
-/* directionPiece either a bishop, rook or none for the piece that can
-   move along a line from one one square to the next. */
-
-piece directionPiece[SQUARES][SQUARES];
-
-/* squaresPast is the squares are after the second square, on the same
-   line as the first */
-
-bitboard squaresPast[SQUARES][SQUARES];
-
-/* urShift and ulShift are to help with the diagonal bitboards.  The square on
-   the up-right diagonal bitboard that corresponds to a normal bitboard is
-   found by indexing urShift.  So square 5 (a6) on a normal bitboard is 24 on
-   the up-right diagonal bitboard (ulShift[5]).  The order of the squares is
-   kind of funky, the only things that are important are that squares of
-   diagonals have adjacent bits and that the 32 bit is the end of one diagonal
-   (so that no diagonals cross 32 bit boundaries and optimizations can be
-   used). */
-
-int ulShift[SQUARES] = 
-   {  
-    0,  2,  5, 13, 18, 24, 31, 39,
-    1,  4, 12, 17, 23, 30, 38, 46,
-    3, 11, 16, 22, 29, 37, 45, 52,
-   10, 15, 21, 28, 36, 44, 51, 57,
-   14, 20, 27, 35, 43, 50, 56,  9,
-   19, 26, 34, 42, 49, 55,  8, 60,
-   25, 33, 41, 48, 54,  7, 59, 62,
-   32, 40, 47, 53,  6, 58, 61, 63 
-   };
-
-int urShift[SQUARES] = 
-   {
-   32, 40, 47, 53,  6, 58, 61, 63,
-   25, 33, 41, 48, 54,  7, 59, 62,
-   19, 26, 34, 42, 49, 55,  8, 60,
-   14, 20, 27, 35, 43, 50, 56,  9,
-   10, 15, 21, 28, 36, 44, 51, 57,
-    3, 11, 16, 22, 29, 37, 45, 52,
-    1,  4, 12, 17, 23, 30, 38, 46,
-    0,  2,  5, 13, 18, 24, 31, 39 
-   };
-
-/* urDiagShift and ulDiagShift are to help with the diagonal bitboards.
-   To get the diagonal of a square on the lowest bits of a bitboard, right 
-   shift it by the amout in the array indexed at the square */
-
-int ulDiagShift[SQUARES] = 
-   {
-    0,  1,  3, 10, 14, 19, 25, 32,
-    1,  3, 10, 14, 19, 25, 32, 40,
-    3, 10, 14, 19, 25, 32, 40, 47,
-   10, 14, 19, 25, 32, 40, 47, 53,
-   14, 19, 25, 32, 40, 47, 53,  6,
-   19, 25, 32, 40, 47, 53,  6, 58,
-   25, 32, 40, 47, 53,  6, 58, 61,
-   32, 40, 47, 53,  6, 58, 61, 63
-   };
-
-int urDiagShift[SQUARES] = 
-   {
-   32, 40, 47, 53,  6, 58, 61, 63,
-   25, 32, 40, 47, 53,  6, 58, 61,
-   19, 25, 32, 40, 47, 53,  6, 58,
-   14, 19, 25, 32, 40, 47, 53,  6,
-   10, 14, 19, 25, 32, 40, 47, 53,
-    3, 10, 14, 19, 25, 32, 40, 47,
-    1,  3, 10, 14, 19, 25, 32, 40,
-    0,  1,  3, 10, 14, 19, 25, 32
-   };
-
-
-
-/* *AttacksArray[square][info_on_a_line] gives where a piece can attacks on a line
-   based on where the piece is on the board, and what squares are occupied
-   along the line */
-
-bitboard rankAttacksArray[SQUARES][256];
-bitboard fileAttacksArray[SQUARES][256];
-bitboard diagURAttacksArray[SQUARES][256];
-bitboard diagULAttacksArray[SQUARES][256];
+/* The tables the bitboards are looked up in (BitInBB, the attacks of the
+   pieces, squaresTo, squaresPast, nearSquares, directionPiece and the
+   AttacksArrays of the lines with the shifts for the diagonal bitboards)
+   are made by gentables.cpp when Sunsetter is built, and are constant in
+   tables.cpp.  See board.h for what they are. */
 
 
 /* 
@@ -369,373 +264,6 @@ bitboard boardStruct::blockedAttacks(color c, square where)
    }
 
 
-/* 
- * Function: initBitboards
- * Input:    None
- * Output:   None
- * Purpose:  Used to set up all of the tables used in the bit boards.
- */
-
-void initBitboards()
-{
-   int leftborder, rightborder, upperborder, lowerborder; 
-   int n, o, i;
-   bitboard bb, bb2;
-   square sq;
-
-
-   /* First generate the Square -> Bitboard with only that square set 
-      Lookup table, makes setting / unsetting squares MUCH faster */
-	
-	for (sq = 0; sq < SQUARES; sq++) 
-		BitInBB[sq] = (qword(1) << sq);
-
-   /* Generate the attacks of short range pieces.  Just make sure that the
-      attacks dont wrap around the board */
-
-   for (sq = 0; sq < SQUARES; sq++) 
-      {
-	  
-      pawnAttacks[WHITE][sq] = pawnAttacks[BLACK][sq] = qword(0);
-      if (file(sq) == 0) 
-         {
-         pawnAttacks[WHITE][sq].setSquare(sq + ONE_FILE + ONE_RANK);
-         pawnAttacks[BLACK][sq].setSquare(sq + ONE_FILE - ONE_RANK);
-		 
-		 
-         } 
-      else if (file(sq) == 7) 
-         {
-         pawnAttacks[WHITE][sq].setSquare(sq - ONE_FILE + ONE_RANK);
-         pawnAttacks[BLACK][sq].setSquare(sq - ONE_FILE - ONE_RANK);
-		 
-		 
-         } 
-      else 
-         {
-         if (sq+ONE_FILE+ONE_RANK < 65)  pawnAttacks[WHITE][sq].setSquare(sq + ONE_FILE + ONE_RANK);
-         if (sq-ONE_FILE+ONE_RANK < 65)  pawnAttacks[WHITE][sq].setSquare(sq - ONE_FILE + ONE_RANK);
-         if (sq+ONE_FILE-ONE_RANK >= 0)  pawnAttacks[BLACK][sq].setSquare(sq + ONE_FILE - ONE_RANK);
-         if (sq-ONE_FILE-ONE_RANK >= 0)  pawnAttacks[BLACK][sq].setSquare(sq - ONE_FILE - ONE_RANK);		 
-		}
-
-
-
-	  leftborder = rightborder = upperborder = lowerborder = 0; 
-	  if (file(sq) == 0) leftborder = 1; 
-	  if (file(sq) == 7) rightborder = 1; 
-	  if (rank(sq) == 0) lowerborder = 1; 
-	  if (rank(sq) == 7) upperborder = 1; 
-
-	  if ((!leftborder) && (!lowerborder)) contactBishopAttacks[sq].setSquare(sq - ONE_FILE - ONE_RANK);
-	  if ((!rightborder) && (!lowerborder)) contactBishopAttacks[sq].setSquare(sq + ONE_FILE - ONE_RANK);
-	  if ((!leftborder) && (!upperborder)) contactBishopAttacks[sq].setSquare(sq - ONE_FILE + ONE_RANK);
-	  if ((!rightborder) && (!upperborder)) contactBishopAttacks[sq].setSquare(sq + ONE_FILE + ONE_RANK);
-	 
-	  if (!leftborder) contactRookAttacks[sq].setSquare(sq-ONE_FILE); 
-	  if (!rightborder) contactRookAttacks[sq].setSquare(sq+ONE_FILE); 
-	  if (!lowerborder) contactRookAttacks[sq].setSquare(sq-ONE_RANK); 
-	  if (!upperborder) contactRookAttacks[sq].setSquare(sq+ONE_RANK); 
-
-
-      kingAttacks[sq] = 0;
-      for (n = -1; n <= 1; n++)
-         for (o = -1; o <= 1; o++) 
-            {
-            if (n == 0 && o == 0) 
-               continue;
-            if (rank(sq) + n >= 0 && rank(sq) + n <= 7 &&
-                file(sq) + o >= 0 && file(sq) + o <= 7)
-               kingAttacks[sq].setSquare(sq + n * ONE_RANK + o * ONE_FILE);
-            }
-    
-      knightAttacks[sq] = 0;
-      for (n = -2; n <= 2; n++) 
-         {
-         if (n == 0) 
-            continue;
-         if (file(sq) + n <= 7 && file(sq) + n >=0 &&
-             rank(sq) + (3 - abs(n)) <= 7 && rank(sq) + (3 - abs(n)) >= 0)
-            knightAttacks[sq].setSquare(sq + n * ONE_FILE + (3 - abs(n))*ONE_RANK);
-    
-         if (file(sq) + n <= 7 && file(sq) + n >=0 &&
-             rank(sq) + (abs(n) - 3) <= 7 && rank(sq) + (abs(n) - 3) >= 0)
-            knightAttacks[sq].setSquare(sq + n * ONE_FILE + (abs(n) - 3)*ONE_RANK);
-         }
-      }
-
-   for (sq = 0; sq < SQUARES; sq++) 
-      {
- 
-      /* Set up all of the attack bitboards.  The general formula to do this is
-         to start on the square the piece is on.  Then add bits in every 
-         direction until a piece or the edge is hit */
-
-      for (o = 0; o < 256; o++) 
-         {
-         bb = 0;
-
-         if (file(sq) < 7) 
-            {
-            for (i = ONE_FILE; ((1 << file(sq + i)) & o) == 0 && file(sq + i) < 7;
-                 i += ONE_FILE)
-               bb.setSquare(sq + i);
-            bb.setSquare(sq + i);
-            }
-      
-         if (file(sq) > 0) 
-            {
-            for (i = ONE_FILE; ((1 << file(sq - i)) & o) == 0 && file(sq - i) > 0;
-                 i += ONE_FILE)
-               bb.setSquare(sq - i);
-            bb.setSquare(sq - i);
-            }
-
-         fileAttacksArray[sq][o] = bb;
-         }
-    
-      for (o = 0; o < 256; o++) 
-         {
-         bb = 0;
-
-         if (rank(sq) < 7) 
-            {
-            for (i = ONE_RANK; ((1 << rank(sq + i)) & o) == 0 && rank(sq + i) < 7;
-                 i += ONE_RANK)
-               bb.setSquare(sq + i);
-            bb.setSquare(sq + i);
-            }
-
-         if (rank(sq) > 0) 
-            {
-            for (i = ONE_RANK; ((1 << rank(sq - i)) & o) == 0 && rank(sq - i) > 0;
-                 i += ONE_RANK)
-               bb.setSquare(sq - i);
-            bb.setSquare(sq - i);
-            }
-
-         rankAttacksArray[sq][o] = bb;
-         }
-
-      for (o = 0; o < 256; o++) 
-         {
-         bb = 0;
-
-         if (file(sq) < 7 && rank(sq) < 7) 
-            {
-            for (i = ONE_FILE + ONE_RANK;
-                  ((1 << (urShift[sq + i] - urDiagShift[sq + i])) & o) == 0 &&
-                  file(sq + i) < 7 && rank(sq + i) < 7;
-                  i += ONE_FILE + ONE_RANK)
-               bb.setSquare(sq + i);
-            bb.setSquare(sq + i);
-            }
-
-         if (file(sq) > 0 && rank(sq) > 0) 
-            {
-            for (i = ONE_FILE + ONE_RANK;
-                  ((1 << (urShift[sq - i] - urDiagShift[sq - i])) & o) == 0 &&
-                  file(sq - i) > 0 && rank(sq - i) > 0;
-                  i += ONE_FILE + ONE_RANK)
-               bb.setSquare(sq - i);
-            bb.setSquare(sq - i);
-            }
-
-         diagURAttacksArray[sq][o] = bb;
-         }
-
-      for (o = 0; o < 256; o++) 
-         {
-         bb = 0;
-
-         if (rank(sq) < 7 && file(sq) > 0) 
-            {
-            for (i = ONE_RANK - ONE_FILE;
-                  ((1 << (ulShift[sq + i] - ulDiagShift[sq + i])) & o) == 0 && 
-                  rank(sq + i) < 7 && file(sq + i) > 0; 
-                  i += ONE_RANK - ONE_FILE)
-               bb.setSquare(sq + i);
-            bb.setSquare(sq + i);
-            }
-
-         if (rank(sq) > 0 && file(sq) < 7) 
-            {
-            for (i = ONE_RANK - ONE_FILE;
-                  ((1 << (ulShift[sq - i] - ulDiagShift[sq - i])) & o) == 0 &&
-                  rank(sq - i) > 0 && file(sq - i) < 7; 
-                  i += ONE_RANK - ONE_FILE)
-               bb.setSquare(sq - i);
-            bb.setSquare(sq - i);
-            }
-
-      diagULAttacksArray[sq][o] = bb;
-      }
-   }
-
-    /* Get the squaresTo, squaresPast and directionPiece array.  See if the
-       from square is along the same line as to to square, if it is then set
-       all of the squares between them on the squaresTo and all the bits past
-       in squaresPast and set directionPiece to be the piece that moves like
-       that. */
-
-   for (n = 0; n < SQUARES; n++) 
-      {
-      for (o = 0; o < SQUARES; o++) 
-         {
-         bb = 0;
-         if (n == o) 
-            {
-            squaresTo[n][o] = 0;
-            squaresPast[n][o] = 0;
-            directionPiece[n][o] = NONE;
-            }
-         else if (file(n) == file(o)) 
-            {
-            directionPiece[n][o] = ROOK;
-            sq = n;
-            do 
-               {
-               if (rank(o) > rank(sq)) 
-                  sq += ONE_RANK;
-               else 
-                  sq -= ONE_RANK;
-               bb.setSquare(sq);
-               } while(sq != o);
-            squaresTo[n][o] = bb;
-
-            bb = 0;
-            if (rank(sq) != 0 && rank(sq) != 7) 
-               {
-               do 
-                  {
-                  if (rank(o) > rank(n)) 
-                     sq += ONE_RANK;
-                  else 
-                     sq -= ONE_RANK;
-                  bb.setSquare(sq);
-                  } while(rank(sq) != 0 && rank(sq) != 7);
-            }
-         squaresPast[n][o] = bb;
-         } 
-      else if (rank(n) == rank(o)) 
-         {
-         directionPiece[n][o] = ROOK;
-         sq = n;
-         do 
-            {
-            if (file(o) > file(sq)) 
-               sq += ONE_FILE;
-            else 
-               sq -= ONE_FILE;
-            bb.setSquare(sq);
-            } while(sq != o);
-         squaresTo[n][o] = bb;
-
-         bb = 0;
-         if (file(sq) != 0 && file(sq) != 7) 
-            {
-            do 
-               {
-               if (file(o) > file(n)) 
-                  sq += ONE_FILE;
-               else 
-                  sq -= ONE_FILE;
-               bb.setSquare(sq);
-               } while(file(sq) != 0 && file(sq) != 7);
-            }
-         squaresPast[n][o] = bb;
-      } 
-   else if (rank(o) - rank(n) == file(o) - file(n)) 
-      {
-      directionPiece[n][o] = BISHOP;
-      sq = n;
-      do 
-         {
-         if (rank(o) > rank(sq)) 
-            sq += ONE_FILE + ONE_RANK;
-         else 
-            sq -= ONE_FILE + ONE_RANK;
-         bb.setSquare(sq);
-         } while(sq != o);
-      squaresTo[n][o] = bb;
-
-      bb = 0;
-      if (file(sq) != 0 && file(sq) != 7 &&
-         rank(sq) != 0 && rank(sq) != 7) 
-         {
-         do 
-            {
-            if (file(o) > file(n)) 
-               sq += ONE_FILE + ONE_RANK;
-            else 
-               sq -= ONE_FILE + ONE_RANK;
-            bb.setSquare(sq);
-            } while(file(sq) != 0 && file(sq) != 7 &&
-         rank(sq) != 0 && rank(sq) != 7);
-         }
-      squaresPast[n][o] = bb;
-      } 
-   else if (rank(o) - rank(n) == -(file(o) - file(n))) 
-      {
-      directionPiece[n][o] = BISHOP;
-      sq = n;
-      do {
-         if (rank(o) > rank(sq)) 
-            sq += ONE_RANK - ONE_FILE;
-         else 
-            sq -= ONE_RANK - ONE_FILE;
-         bb.setSquare(sq);
-         } while(sq != o);
-      squaresTo[n][o] = bb;
-
-      bb = 0;
-      if (file(sq) != 0 && file(sq) != 7 &&
-            rank(sq) != 0 && rank(sq) != 7) 
-         {
-         do 
-            {
-            if (rank(o) > rank(n)) 
-               sq += ONE_RANK - ONE_FILE;
-            else 
-               sq -= ONE_RANK - ONE_FILE;
-            bb.setSquare(sq);
-            } while (file(sq) != 0 && file(sq) != 7 &&
-                     rank(sq) != 0 && rank(sq) != 7);
-         }
-      
-      squaresPast[n][o] = bb;
-      }
-   else if (knightAttacks[n].squareIsSet(o)) 
-      {
-      squaresPast[n][o] = 0;
-      squaresTo[n][o] = qword(1) << o;
-      } 
-   else 
-      {
-      squaresPast[n][o] = squaresTo[n][o] = 0;
-      }
-    }
-  }
-
-   /* Set up the near squares, these are squares that are no more than two
-      squares away */
-  
-   for (sq = 0; sq < SQUARES; sq++) 
-   {
-		nearSquares[sq][WHITE] = (qword) 0;
-		nearSquares[sq][WHITE] |= kingAttacks[sq];
-		if (sq + ONE_RANK < SQUARES) nearSquares[sq][WHITE] |= kingAttacks[sq+ONE_RANK];
-      
-		nearSquares[sq][BLACK] = (qword) 0;
-		nearSquares[sq][BLACK] |= kingAttacks[sq];
-		if (sq - ONE_RANK >= 0) nearSquares[sq][BLACK] |= kingAttacks[sq-ONE_RANK];
-
-   }
-
-   return;
-}
-
-
 /* 
  * Function: popCount
  * Input:    None
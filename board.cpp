@@ -17,6 +17,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <new>
 
 #include "board.h"
 #include "brain.h"
@@ -25,11 +26,12 @@
 #include "bughouse.h"
 #include "variables.h"
 #include "notation.h"
+#include "nnue.h"
 
 #define OFF_MOVE otherColor(onMove)
 
-boardStruct gameBoard;
-int hashMoveCircle = 0;
+SEARCH_LOCAL boardStruct gameBoard;
+SEARCH_LOCAL int hashMoveCircle = 0;	/* Each thread counts its own moves */
 
 #ifdef GAMETREE
 /*
@@ -71,7 +73,7 @@ char * boardStruct::getLineText()
 	strcpy(buf, onMove==WHITE ? "W":"B");
 	for (n=1; n<moveNum; n++){
 		strcat(buf, " ");
-		DBMoveToRawAlgebraicMove(moveHistory[n], tbuf);
+		DBMoveToRawAlgebraicMove(history[n].played, tbuf);
 		strcat(buf, tbuf);
 	}
 	return buf;
@@ -206,8 +208,8 @@ void boardStruct::movePiece(color c, piece p, square from, square to, int hash,
 {
    if (attack)
    {
-		moveAttackedSomething[moveNum+1] = ~  (removePiece(c, p, from, hash, attack));
-		moveAttackedSomething[moveNum+1] &= addPiece(c, p, to, hash, attack);		   
+		history[moveNum+1].attackedSomething = ~  (removePiece(c, p, from, hash, attack));
+		history[moveNum+1].attackedSomething &= addPiece(c, p, to, hash, attack);		   
    }
    else
    {
@@ -258,6 +260,11 @@ bitboard boardStruct::replacePiece(color oldc, piece oldp, color newc, piece new
       {
       addToHash(oldc, oldp, sq);
       addToHash(newc, newp, sq);
+      if (nnueActive)
+         {
+         nnueRemovePiece(oldc, oldp, sq);
+         nnueAddPiece(newc, newp, sq);
+         }
       }
 
    return bb;
@@ -299,7 +306,10 @@ bitboard boardStruct::removePiece(color c, piece p, square sq, int hash, int att
    }
 
    if (hash) 
+      {
       addToHash(c, p, sq);
+      if (nnueActive) nnueRemovePiece(c, p, sq);
+      }
 
    return bb;
 }
@@ -339,7 +349,11 @@ bitboard boardStruct::addPiece(color c, piece p, square sq, int hash, int attack
    }
    addToBitboards(c, p, sq);
    
-   if (hash) addToHash(c, p, sq);
+   if (hash) 
+      {
+      addToHash(c, p, sq);
+      if (nnueActive) nnueAddPiece(c, p, sq);
+      }
 
    return bb; 
 }
@@ -382,26 +396,13 @@ void boardStruct::getEval(char *buf)
               playing == WHITE ? material : -material,
 			  playing == WHITE ? development : -development,            
 			  playing == WHITE ? boardControlEval() : -boardControlEval(),
-			  playing == WHITE ? (-kingSafetyEval(WHITE)*getMaterialInHand(BLACK) ): (kingSafetyEval(WHITE)*getMaterialInHand(BLACK)),
-			  playing == WHITE ? (kingSafetyEval(BLACK)*getMaterialInHand(WHITE) ): (-kingSafetyEval(BLACK)*getMaterialInHand(WHITE)));
+			  playing == WHITE ? (-kingSafetyEval<WHITE>()*getMaterialInHand(BLACK) ): (kingSafetyEval<WHITE>()*getMaterialInHand(BLACK)),
+			  playing == WHITE ? (kingSafetyEval<BLACK>()*getMaterialInHand(WHITE) ): (-kingSafetyEval<BLACK>()*getMaterialInHand(WHITE)));
     }    
   
 }
 
 
-/* 
- * Function: otherColor
- * Input:    A color.
- * Output:   The other color.
- * Purpose:  Used to get the other color.
- */
-
-color otherColor(color c)
-{
-   return (color) (BLACK - c);
-}
-
-
 /* 
  * Function: addPieceToHand
  * Input:    A color, a piece and if the hash value of the position
@@ -419,7 +420,10 @@ void boardStruct::addPieceToHand(color c, piece p, int hash)
    else 
       material -= pValue[p];
    if (hash) 
+      {
       addToInHandHash(c, p);
+      if (nnueActive) nnueAddToHand(c, p);
+      }
 
 }
 
@@ -441,7 +445,10 @@ void boardStruct::removePieceFromHand(color c, piece p, int hash)
    else 
       material += pValue[p];
    if (hash) 
+      {
       subtractFromInHandHash(c, p);
+      if (nnueActive) nnueRemoveFromHand(c, p);
+      }
 
 }
 
@@ -455,17 +462,24 @@ void boardStruct::removePieceFromHand(color c, piece p, int hash)
 
 void boardStruct::setPieceInHand(color c, piece p, int num)
 {
-   int n;
-
-   for (n = 0; n < hand[c][p]; n++)
-      subtractFromInHandHash(c, p);
-   for (n = 0; n < num; n++)
-      addToInHandHash(c, p);
    if (c == WHITE)
       material += (num - hand[WHITE][p]) * pValue[p];
    else
       material -= (num - hand[BLACK][p]) * pValue[p];
-   hand[c][p] = num;
+
+   /* The hash numbers are by how many there are, so go one at a time */
+
+   while (hand[c][p] > num)
+      {
+      hand[c][p]--;
+      subtractFromInHandHash(c, p);
+      }
+   while (hand[c][p] < num)
+      {
+      hand[c][p]++;
+      addToInHandHash(c, p);
+      }
+   nnueRefresh();
 }
 
 
@@ -550,7 +564,7 @@ void boardStruct::setColorOnMove(color c)
 
 void boardStruct::setCheckHistory(int check)
 {
-	checkHistory[moveNum] = check;
+	history[moveNum].check = check;
 }
 
 /*
@@ -588,6 +602,7 @@ void boardStruct::resetBoard()
 
    custom = false;
    moveNum = 1;
+   growHistory(moveNum + 2);
    onMove = WHITE;
    development = 0;
    
@@ -614,7 +629,7 @@ assert ((hashMoveCircle >= 0) && (hashMoveCircle <= 7));
    {
       for(p = PAWN; p <= QUEEN; p = (piece) (p + 1))
 	  {
-         gameBoard.setPieceInHand(c, p, 0);
+         setPieceInHand(c, p, 0);
 	  }
    }
  
@@ -644,6 +659,7 @@ assert ((hashMoveCircle >= 0) && (hashMoveCircle <= 7));
 
    material = 0; 
    initHash();
+   nnueRefresh();
 
 
 
@@ -675,6 +691,7 @@ void boardStruct::setBoard(const char *fen, const char *turn, const char *castle
     stats_overallsearches = stats_overallqsearches = stats_overallticks = 0;
     firstBigValue = 0;
     moveNum = 1;
+    growHistory(moveNum + 2);
     custom = 1;
 
     material = 0;
@@ -770,6 +787,7 @@ void boardStruct::setBoard(const char *fen, const char *turn, const char *castle
     }
 
     initHash();
+    nnueRefresh();
     lastMoveTime = getSysMilliSecs();
 }
 
@@ -788,11 +806,175 @@ void boardStruct::setLastMoveNow()
 
 void boardStruct::copy(boardStruct *dest)
 {
-   memcpy(dest, this, sizeof(boardStruct));
+   historyEntry *destHistory = dest->history;
+   int destHistorySize = dest->historySize;
+   nnueAccumulator *destNnueStack = dest->nnueStack;
+   int destNnueStackSize = dest->nnueStackSize;
+   int n;
+
+   memcpy((void *) dest, this, sizeof(boardStruct));
+
+   /* dest keeps its own history stack, only the moves of the game so far
+      are copied into it */
+
+   dest->history = destHistory;
+   dest->historySize = destHistorySize;
+   dest->growHistory(moveNum + 2);
+   for (n = 0; n <= moveNum; n++) dest->history[n] = history[n];
+
+   dest->nnueStack = destNnueStack;
+   dest->nnueStackSize = destNnueStackSize;
+   dest->nnueRefresh();
    return;
 }
 
 
+/*
+ * Function: freeStacks
+ * Input:    None.
+ * Output:   None.
+ * Purpose:  Frees what copy() and clone() allocate for the board.  The 
+ *           globals keep theirs, libsunsetter.cpp needs it for its boards
+ *           and the ones of the threads that call it.
+ */
+
+void boardStruct::freeStacks()
+{
+   delete [] history;
+   history = NULL;
+   historySize = 0;
+
+   free(nnueStack);
+   nnueStack = NULL;
+   nnueStackSize = 0;
+}
+
+
+/*
+ * Function: clone
+ * Input:    A pointer to the board to clone the board to.
+ * Output:   None
+ * Purpose:  Like copy(), but only the last CLONE_HISTORY half-moves of the
+ *           history are copied.  The search never takes back moves played
+ *           before its root and only looks a couple of half-moves back
+ *           (see standpatCondition()), so this is all a board used for
+ *           searching needs.  It takes the same time however long the
+ *           game is.
+ */
+
+void boardStruct::clone(boardStruct *dest)
+{
+   historyEntry *destHistory = dest->history;
+   int destHistorySize = dest->historySize;
+   nnueAccumulator *destNnueStack = dest->nnueStack;
+   int destNnueStackSize = dest->nnueStackSize;
+   int n, first;
+
+   memcpy((void *) dest, this, sizeof(boardStruct));
+
+   dest->history = destHistory;
+   dest->historySize = destHistorySize;
+   dest->growHistory(moveNum + 2);
+
+   first = max(0, moveNum + 1 - CLONE_HISTORY);
+   for (n = first; n <= moveNum; n++) dest->history[n] = history[n];
+
+   dest->nnueStack = destNnueStack;
+   dest->nnueStackSize = destNnueStackSize;
+   dest->nnueRefresh();
+}
+
+
+/*
+ * Function: pack
+ * Input:    Room for PACKED_BOARD_SIZE bytes.
+ * Output:   How many bytes were written.
+ * Purpose:  Writes the board and the end of its history like clone(), for
+ *           a worker process of split.cpp.  The worker is a fork() of this
+ *           program, so the bytes mean the same there.
+ */
+
+int boardStruct::pack(char *buf)
+{
+   int first;
+
+   memcpy(buf, this, sizeof(boardStruct));
+
+   first = max(0, moveNum + 1 - CLONE_HISTORY);
+   memcpy(buf + sizeof(boardStruct), history + first,
+          (moveNum + 1 - first) * sizeof(historyEntry));
+
+   return sizeof(boardStruct) + (moveNum + 1 - first) * sizeof(historyEntry);
+}
+
+
+/*
+ * Function: unpack
+ * Input:    What pack() wrote.
+ * Output:   None.
+ * Purpose:  Makes the board a clone() of the one that was packed, keeping
+ *           its own history and network stacks.
+ */
+
+void boardStruct::unpack(const char *buf)
+{
+   historyEntry *ownHistory = history;
+   int ownHistorySize = historySize;
+   nnueAccumulator *ownNnueStack = nnueStack;
+   int ownNnueStackSize = nnueStackSize;
+   int first;
+
+   memcpy((void *) this, buf, sizeof(boardStruct));
+
+   history = ownHistory;
+   historySize = ownHistorySize;
+   growHistory(moveNum + 2);
+
+   first = max(0, moveNum + 1 - CLONE_HISTORY);
+   memcpy((void *) (history + first), buf + sizeof(boardStruct),
+          (moveNum + 1 - first) * sizeof(historyEntry));
+
+   nnueStack = ownNnueStack;
+   nnueStackSize = ownNnueStackSize;
+   nnueRefresh();
+}
+
+
+/*
+ * Function: growHistory
+ * Input:    How many half-moves the history has to have room for.
+ * Output:   None.
+ * Purpose:  Makes the history stack bigger if needed.  It starts with room
+ *           for MAX_GAME_LENGTH half-moves and doubles from there, so long
+ *           games don't run off the end.  historyEntry has moves and 
+ *           bitboards in it, which have constructors, so the stack is made
+ *           with new and the entries are copied one by one.
+ */
+
+void boardStruct::growHistory(int needed)
+{
+   historyEntry *bigger;
+   int n, size;
+
+   if (needed <= historySize) return;
+
+   size = historySize ? historySize : MAX_GAME_LENGTH;
+   while (size < needed) size *= 2;
+
+   bigger = new (std::nothrow) historyEntry[size]();
+   if (!bigger)
+      {
+      output("Not enough memory for the game history\n");
+      exit(1);
+      }
+   for (n = 0; n < historySize; n++) bigger[n] = history[n];
+
+   delete [] history;
+   history = bigger;
+   historySize = size;
+}
+
+
 /*
  * Function: playMove
  * Input:    A move pointer and whether to give the move to Xboard
@@ -821,7 +1003,7 @@ int boardStruct::playMove(move m, int report)
 			promotedPawns.unsetSquare(m.to());
 		}
     
-      if (promotedPawns.squareIsSet(m.from()))
+      if (m.from() != IN_HAND && promotedPawns.squareIsSet(m.from()))
          {
          promotedPawns.unsetSquare(m.from());
          promotedPawns.setSquare(m.to());
@@ -886,7 +1068,7 @@ assert ((hashMoveCircle >= 0) && (hashMoveCircle <= 7));
 
 move boardStruct::getMoveHistory (int ply)
 {
-	return moveHistory[gameBoard.getMoveNum()+ply];
+	return history[gameBoard.getMoveNum()+ply].played;
 }
 
 #endif
@@ -899,13 +1081,15 @@ move boardStruct::getMoveHistory (int ply)
 
 void boardStruct::makeNullMove()
 {
-		takeBackHistory[moveNum].oldep = enPassant;
+		if (moveNum + 3 > historySize) growHistory(moveNum + 3);
+
+		history[moveNum].takeBack.oldep = enPassant;
 		enPassant = OFF_BOARD;
 
 		onMove = OFF_MOVE;    
 		moveNum++;
 
-		moveAttackedSomething[moveNum] = qword (0); 
+		history[moveNum].attackedSomething = qword (0); 
 
 }
 
@@ -923,7 +1107,7 @@ void boardStruct::unmakeNullMove()
 
 		onMove = OFF_MOVE; 	
 	
-		enPassant = takeBackHistory[moveNum].oldep;
+		enPassant = history[moveNum].takeBack.oldep;
 }
 
 
@@ -937,8 +1121,7 @@ void boardStruct::unmakeNullMove()
 
 void boardStruct::playBughouse()
 {
-   currentChangeBoard = &boardStruct::bugChangeBoard;
-   currentUnchangeBoard = &boardStruct::bugUnchangeBoard;
+   variant = BUGHOUSE;
 }
 
 
@@ -951,8 +1134,7 @@ void boardStruct::playBughouse()
 
 void boardStruct::playCrazyhouse()
 {
-   currentChangeBoard = &boardStruct::ZHChangeBoard;
-   currentUnchangeBoard = &boardStruct::ZHUnchangeBoard;
+   variant = CRAZYHOUSE;
 }
 
 
@@ -965,11 +1147,13 @@ void boardStruct::playCrazyhouse()
  *           if a move is legal.  Also it doesn't tell Xboard the move.
  *           This is just a wrapper function that calls whichever changeBoard
  *           that we're curently using (either the bughouse or crazyhouse one)
+ *           The search uses changeBoard<R>() from board.h instead.
  */
 
 void boardStruct::changeBoard(move m)
 {
-	(this->*currentChangeBoard)(m);
+	if (variant == CRAZYHOUSE) ZHChangeBoard(m);
+	else bugChangeBoard(m);
 }
 
 
@@ -985,7 +1169,8 @@ void boardStruct::changeBoard(move m)
 
 void boardStruct::unchangeBoard()
 {
-	(this->*currentUnchangeBoard)();   
+	if (variant == CRAZYHOUSE) ZHUnchangeBoard();
+	else bugUnchangeBoard();
 }
 
 
@@ -999,19 +1184,23 @@ void boardStruct::unchangeBoard()
 void boardStruct::bugChangeBoard(move m)
 {
 
+   if (moveNum + 3 > historySize) growHistory(moveNum + 3);
+   if (nnueActive) nnuePush();
+
    /* Save the information needed for when
       unchangeBoard() has to restore the position. 
       (capture has to be done after the check to move the pawn back because
       of en passant) */  
 
-   memcpy(takeBackHistory[moveNum].oldCastle, canCastle, sizeof(takeBackHistory[moveNum].oldCastle));
-   memcpy(takeBackHistory[moveNum].attacks,attacks,  sizeof(attacks));
+   memcpy(history[moveNum].takeBack.oldCastle, canCastle, sizeof(history[moveNum].takeBack.oldCastle));
+   memcpy(history[moveNum].takeBack.attacks,attacks,  sizeof(attacks));
   
-   takeBackHistory[moveNum].oldep = enPassant;
-   takeBackHistory[moveNum].oldHash = hashValue;
+   history[moveNum].takeBack.oldep = enPassant;
+   history[moveNum].takeBack.oldHash = hashValue;
+   history[moveNum].takeBack.oldHandKey = handKey;
 
 #ifdef DEBUG_HASH
-   takeBackHistory[moveNum].oldHashT = hashValueT; 
+   history[moveNum].takeBack.oldHashT = hashValueT; 
 #endif
    
 
@@ -1034,13 +1223,13 @@ void boardStruct::bugChangeBoard(move m)
          }
       }
 
-   takeBackHistory[moveNum].captured = position[m.to()]; 
+   history[moveNum].takeBack.captured = position[m.to()]; 
 
    /* Handle drop moves */
 
    if (m.from() == IN_HAND) 
       {
-      moveAttackedSomething[moveNum+1] = addPiece(onMove, m.moved(), m.to(), 1, 1);
+      history[moveNum+1].attackedSomething = addPiece(onMove, m.moved(), m.to(), 1, 1);
       removePieceFromHand(onMove, m.moved(), 1);
 
       /* en passant is not possible after a drop move */
@@ -1049,19 +1238,19 @@ void boardStruct::bugChangeBoard(move m)
       addEnPassantHash(OFF_BOARD);
       enPassant = OFF_BOARD;
       onMove = OFF_MOVE;
-	  moveHistory[moveNum] = m;
+	  history[moveNum].played = m;
 	  moveNum++;
       return;
       }
 
-   if (takeBackHistory[moveNum].captured == NONE) 
+   if (history[moveNum].takeBack.captured == NONE) 
       {
       movePiece(onMove, m.moved(), m.from(), m.to(), 1, 1);
       }
    else 
       {
-      moveAttackedSomething[moveNum+1] = ~(removePiece(onMove, m.moved(), m.from(), 1, 1));
-      moveAttackedSomething[moveNum+1] &= replacePiece(OFF_MOVE, takeBackHistory[moveNum].captured, onMove, m.moved(), m.to(), 1, 1);
+      history[moveNum+1].attackedSomething = ~(removePiece(onMove, m.moved(), m.from(), 1, 1));
+      history[moveNum+1].attackedSomething &= replacePiece(OFF_MOVE, history[moveNum].takeBack.captured, onMove, m.moved(), m.to(), 1, 1);
       }
 
    /* If the move was a pawn promotion then:
@@ -1076,8 +1265,8 @@ void boardStruct::bugChangeBoard(move m)
 	  of what the piece already attacked where it came from. */
 
 
-      moveAttackedSomething[moveNum+1] = ~(removePiece(onMove, PAWN, m.to(), 1, 1));
-      moveAttackedSomething[moveNum+1] &= addPiece(onMove, m.promotion(), m.to(), 1, 1);
+      history[moveNum+1].attackedSomething = ~(removePiece(onMove, PAWN, m.to(), 1, 1));
+      history[moveNum+1].attackedSomething &= addPiece(onMove, m.promotion(), m.to(), 1, 1);
       }
 
 
@@ -1096,12 +1285,12 @@ void boardStruct::bugChangeBoard(move m)
 
    enPassant = OFF_BOARD;
  
-   if (takeBackHistory[moveNum].captured == ROOK &&
+   if (history[moveNum].takeBack.captured == ROOK &&
         m.to() == kingSquare[OFF_MOVE] + THREE_FILES) 
       {
       setCastleOptions(OFF_MOVE, KING_SIDE, 0, 1);
       }
-   else if (takeBackHistory[moveNum].captured == ROOK &&
+   else if (history[moveNum].takeBack.captured == ROOK &&
             m.to() == kingSquare[OFF_MOVE] - FOUR_FILES) 
       {
       setCastleOptions(OFF_MOVE, QUEEN_SIDE, 0, 1);
@@ -1157,7 +1346,7 @@ void boardStruct::bugChangeBoard(move m)
 
    onMove = OFF_MOVE;
   
-   moveHistory[moveNum] = m;
+   history[moveNum].played = m;
    moveNum++;
   
    return;
@@ -1189,6 +1378,9 @@ void boardStruct::ZHChangeBoard(move m)
 
    int capturedPromotedPawn;
 
+   if (moveNum + 3 > historySize) growHistory(moveNum + 3);
+   if (nnueActive) nnuePush();
+
    /* See if we captured or moved a promoted pawn */
 
    if (promotedPawns.squareIsSet(m.to())) 
@@ -1199,7 +1391,7 @@ void boardStruct::ZHChangeBoard(move m)
    else  
       capturedPromotedPawn = 0;
 
-   if (promotedPawns.squareIsSet(m.from())) 
+   if (m.from() != IN_HAND && promotedPawns.squareIsSet(m.from())) 
       {
       promotedPawns.unsetSquare(m.from());
       promotedPawns.setSquare(m.to());
@@ -1208,17 +1400,18 @@ void boardStruct::ZHChangeBoard(move m)
    /* Save the information needed for when
       unchangeBoard() has to restore the position. */
 
-   memcpy(takeBackHistory[moveNum].oldCastle, canCastle, sizeof(takeBackHistory[moveNum].oldCastle));
-   memcpy(takeBackHistory[moveNum].attacks,attacks,  sizeof(attacks));
+   memcpy(history[moveNum].takeBack.oldCastle, canCastle, sizeof(history[moveNum].takeBack.oldCastle));
+   memcpy(history[moveNum].takeBack.attacks,attacks,  sizeof(attacks));
 
-   takeBackHistory[moveNum].oldep = enPassant;
-   takeBackHistory[moveNum].oldHash = hashValue;
+   history[moveNum].takeBack.oldep = enPassant;
+   history[moveNum].takeBack.oldHash = hashValue;
+   history[moveNum].takeBack.oldHandKey = handKey;
 
 #ifdef DEBUG_HASH
-   takeBackHistory[moveNum].oldHashT = hashValueT; 
+   history[moveNum].takeBack.oldHashT = hashValueT; 
 #endif
 
-   takeBackHistory[moveNum].capturedPromotedPawn = byte (capturedPromotedPawn);
+   history[moveNum].takeBack.capturedPromotedPawn = byte (capturedPromotedPawn);
 
    /*  If the move was capturing en passant, then put the captured pawn to 
        where it would be if it only moved one square */
@@ -1244,13 +1437,13 @@ void boardStruct::ZHChangeBoard(move m)
       (capture has to be done after the check to move the pawn back because
       of en passant) */  
 
-   takeBackHistory[moveNum].captured = position[m.to()];
+   history[moveNum].takeBack.captured = position[m.to()];
 
    /* Handle drop moves */
 
    if (m.from() == IN_HAND) 
       {
-      moveAttackedSomething[moveNum+1] = addPiece(onMove, m.moved(), m.to(), 1, 1);
+      history[moveNum+1].attackedSomething = addPiece(onMove, m.moved(), m.to(), 1, 1);
       removePieceFromHand(onMove, m.moved(), 1);
 
       /* en passant is not possible after a drop move */
@@ -1259,31 +1452,33 @@ void boardStruct::ZHChangeBoard(move m)
       addEnPassantHash(OFF_BOARD);
       enPassant = OFF_BOARD;
       onMove = OFF_MOVE;
-	  moveHistory[moveNum] = m;
+	  history[moveNum].played = m;
 	  moveNum++;
       return;
       }
 
    /* See if we moved a promoted pawn */
 
-   if (takeBackHistory[moveNum].captured == NONE) 
+   if (history[moveNum].takeBack.captured == NONE) 
       {
       movePiece(onMove, m.moved(), m.from(), m.to(), 1, 1);
       }
    else 
       {
-      moveAttackedSomething[moveNum+1] = ~(removePiece(onMove, m.moved(), m.from(), 1, 1));
-      moveAttackedSomething[moveNum+1] &= replacePiece(OFF_MOVE, takeBackHistory[moveNum].captured, onMove, m.moved(), m.to(), 1, 1);
+      history[moveNum+1].attackedSomething = ~(removePiece(onMove, m.moved(), m.from(), 1, 1));
+      history[moveNum+1].attackedSomething &= replacePiece(OFF_MOVE, history[moveNum].takeBack.captured, onMove, m.moved(), m.to(), 1, 1);
       
 	  if (!capturedPromotedPawn) 
 	  {
-         hand[onMove][takeBackHistory[moveNum].captured]++;
-		 addToInHandHash(onMove,takeBackHistory[moveNum].captured );
+         hand[onMove][history[moveNum].takeBack.captured]++;
+		 addToInHandHash(onMove,history[moveNum].takeBack.captured );
+		 if (nnueActive) nnueAddToHand(onMove, history[moveNum].takeBack.captured);
 	  }
       else 
 	  {
          hand[onMove][PAWN]++;
 		 addToInHandHash(onMove,PAWN );
+		 if (nnueActive) nnueAddToHand(onMove, PAWN);
 	  }
       }
 
@@ -1300,8 +1495,8 @@ void boardStruct::ZHChangeBoard(move m)
 	  So we AND the bitboard of newly attacked squares with the reverse
 	  of what the piece already attacked where it came from. */
 
-      moveAttackedSomething[moveNum+1] = ~(removePiece(onMove, PAWN, m.to(), 1, 1));
-      moveAttackedSomething[moveNum+1] &= addPiece(onMove, m.promotion(), m.to(), 1, 1);
+      history[moveNum+1].attackedSomething = ~(removePiece(onMove, PAWN, m.to(), 1, 1));
+      history[moveNum+1].attackedSomething &= addPiece(onMove, m.promotion(), m.to(), 1, 1);
       promotedPawns.setSquare(m.to());
       }
 
@@ -1320,12 +1515,12 @@ void boardStruct::ZHChangeBoard(move m)
 
    enPassant = OFF_BOARD;
  
-   if (takeBackHistory[moveNum].captured == ROOK &&
+   if (history[moveNum].takeBack.captured == ROOK &&
       m.to() == kingSquare[OFF_MOVE] + THREE_FILES) 
       {
       setCastleOptions(OFF_MOVE, KING_SIDE, 0, 1);
       } 
-   else if (takeBackHistory[moveNum].captured == ROOK &&
+   else if (history[moveNum].takeBack.captured == ROOK &&
             m.to() == kingSquare[OFF_MOVE] - FOUR_FILES) 
       {
       setCastleOptions(OFF_MOVE, QUEEN_SIDE, 0, 1);
@@ -1380,7 +1575,7 @@ void boardStruct::ZHChangeBoard(move m)
 
    onMove = OFF_MOVE;
 
-   moveHistory[moveNum] = m;
+   history[moveNum].played = m;
    moveNum++;
   
    
@@ -1403,6 +1598,7 @@ void boardStruct::bugUnchangeBoard()
 {
 
     moveNum--;
+    if (nnueActive) nnueIndex--;
 	
 	/* Change the color to move */
 
@@ -1410,70 +1606,72 @@ void boardStruct::bugUnchangeBoard()
 
    /* Handle drop moves */
 
-   if (moveHistory[moveNum].from() == IN_HAND) 
+   if (history[moveNum].played.from() == IN_HAND) 
       {
-      removePiece(onMove, moveHistory[moveNum].moved(), moveHistory[moveNum].to(), 0, 0);
-      position[moveHistory[moveNum].to()] = NONE;
-      addPieceToHand(onMove, moveHistory[moveNum].moved(), 0);
-      enPassant = takeBackHistory[moveNum].oldep;
-      hashValue = takeBackHistory[moveNum].oldHash;
+      removePiece(onMove, history[moveNum].played.moved(), history[moveNum].played.to(), 0, 0);
+      position[history[moveNum].played.to()] = NONE;
+      addPieceToHand(onMove, history[moveNum].played.moved(), 0);
+      enPassant = history[moveNum].takeBack.oldep;
+      hashValue = history[moveNum].takeBack.oldHash;
+      handKey = history[moveNum].takeBack.oldHandKey;
 #ifdef DEBUG_HASH
-	  hashValueT = takeBackHistory[moveNum].oldHashT; 
+	  hashValueT = history[moveNum].takeBack.oldHashT; 
 #endif
 
-	   memcpy(attacks,takeBackHistory[moveNum].attacks,  sizeof(attacks));
+	   memcpy(attacks,history[moveNum].takeBack.attacks,  sizeof(attacks));
 
       return;
       }
 
    /* If the move was castles move the rook back to it's starting square */
 
-   if (moveHistory[moveNum].moved() == KING) 
+   if (history[moveNum].played.moved() == KING) 
       {
-      if (moveHistory[moveNum].to() == moveHistory[moveNum].from() + TWO_FILES) 
+      if (history[moveNum].played.to() == history[moveNum].played.from() + TWO_FILES) 
          {
-         movePiece(onMove, ROOK, moveHistory[moveNum].from() + ONE_FILE,
-         moveHistory[moveNum].from() + THREE_FILES, 0, 0);
+         movePiece(onMove, ROOK, history[moveNum].played.from() + ONE_FILE,
+         history[moveNum].played.from() + THREE_FILES, 0, 0);
          } 
-      else if (moveHistory[moveNum].to() == moveHistory[moveNum].from() - TWO_FILES) 
+      else if (history[moveNum].played.to() == history[moveNum].played.from() - TWO_FILES) 
          {
-         movePiece(onMove, ROOK, moveHistory[moveNum].from() - ONE_FILE,
-         moveHistory[moveNum].from() - FOUR_FILES, 0, 0);
+         movePiece(onMove, ROOK, history[moveNum].played.from() - ONE_FILE,
+         history[moveNum].played.from() - FOUR_FILES, 0, 0);
          }
-      kingSquare[onMove] = moveHistory[moveNum].from();
+      kingSquare[onMove] = history[moveNum].played.from();
       }
 
    /* If the move was a pawn promotion then:
       Remove the promoted piece from the board
       Add the pawn to the board */
  
-   if (moveHistory[moveNum].promotion() != NONE) 
+   if (history[moveNum].played.promotion() != NONE) 
       {
-      removePiece(onMove, moveHistory[moveNum].promotion(), moveHistory[moveNum].to(), 0, 0);
-      addPiece(onMove, PAWN, moveHistory[moveNum].to(), 0, 0);
+      removePiece(onMove, history[moveNum].played.promotion(), history[moveNum].played.to(), 0, 0);
+      addPiece(onMove, PAWN, history[moveNum].played.to(), 0, 0);
       }
-   if (takeBackHistory[moveNum].captured == NONE) 
+   if (history[moveNum].takeBack.captured == NONE) 
       {
-      movePiece(onMove, moveHistory[moveNum].moved(), moveHistory[moveNum].to(), moveHistory[moveNum].from(), 0, 0);
+      movePiece(onMove, history[moveNum].played.moved(), history[moveNum].played.to(), history[moveNum].played.from(), 0, 0);
       } 
    else 
       {
-      replacePiece(onMove, moveHistory[moveNum].moved(), OFF_MOVE, takeBackHistory[moveNum].captured, moveHistory[moveNum].to(), 0, 0);
-      addPiece(onMove, moveHistory[moveNum].moved(), moveHistory[moveNum].from(), 0, 0);
+      replacePiece(onMove, history[moveNum].played.moved(), OFF_MOVE, history[moveNum].takeBack.captured, history[moveNum].played.to(), 0, 0);
+      addPiece(onMove, history[moveNum].played.moved(), history[moveNum].played.from(), 0, 0);
       }
 
    /* Restore the saved information */
 
-   memcpy(attacks,takeBackHistory[moveNum].attacks,  sizeof(attacks));
+   memcpy(attacks,history[moveNum].takeBack.attacks,  sizeof(attacks));
 
-   setCastleOptions(WHITE, KING_SIDE, takeBackHistory[moveNum].oldCastle[WHITE][KING_SIDE], 0);
-   setCastleOptions(WHITE, QUEEN_SIDE, takeBackHistory[moveNum].oldCastle[WHITE][QUEEN_SIDE], 0);
-   setCastleOptions(BLACK, KING_SIDE, takeBackHistory[moveNum].oldCastle[BLACK][KING_SIDE], 0);
-   setCastleOptions(BLACK, QUEEN_SIDE, takeBackHistory[moveNum].oldCastle[BLACK][QUEEN_SIDE], 0);
-   enPassant = takeBackHistory[moveNum].oldep;
-   hashValue = takeBackHistory[moveNum].oldHash;
+   setCastleOptions(WHITE, KING_SIDE, history[moveNum].takeBack.oldCastle[WHITE][KING_SIDE], 0);
+   setCastleOptions(WHITE, QUEEN_SIDE, history[moveNum].takeBack.oldCastle[WHITE][QUEEN_SIDE], 0);
+   setCastleOptions(BLACK, KING_SIDE, history[moveNum].takeBack.oldCastle[BLACK][KING_SIDE], 0);
+   setCastleOptions(BLACK, QUEEN_SIDE, history[moveNum].takeBack.oldCastle[BLACK][QUEEN_SIDE], 0);
+   enPassant = history[moveNum].takeBack.oldep;
+   hashValue = history[moveNum].takeBack.oldHash;
+   handKey = history[moveNum].takeBack.oldHandKey;
 #ifdef DEBUG_HASH
-   hashValueT = takeBackHistory[moveNum].oldHashT; 
+   hashValueT = history[moveNum].takeBack.oldHashT; 
 #endif
 
   
@@ -1481,7 +1679,7 @@ void boardStruct::bugUnchangeBoard()
    /* If the move was capturing en passant then put the pawn back two
       squares advanced */
 
-   if (takeBackHistory[moveNum].captured == PAWN && moveHistory[moveNum].to() == enPassant) 
+   if (history[moveNum].takeBack.captured == PAWN && history[moveNum].played.to() == enPassant) 
       {
       if (onMove == WHITE) 
          {
@@ -1520,6 +1718,7 @@ void boardStruct::ZHUnchangeBoard()
 {  
 		    
     moveNum--;
+    if (nnueActive) nnueIndex--;
 	
 	
 	/* Change the color to move */
@@ -1528,99 +1727,101 @@ void boardStruct::ZHUnchangeBoard()
 
    /* Handle drop moves */
 
-   if (moveHistory[moveNum].from() == IN_HAND) 
+   if (history[moveNum].played.from() == IN_HAND) 
       {
-      removePiece(onMove, moveHistory[moveNum].moved(), moveHistory[moveNum].to(), 0, 0);
-      position[moveHistory[moveNum].to()] = NONE;
-      addPieceToHand(onMove, moveHistory[moveNum].moved(), 0);
-      enPassant = takeBackHistory[moveNum].oldep;
-      hashValue = takeBackHistory[moveNum].oldHash;
+      removePiece(onMove, history[moveNum].played.moved(), history[moveNum].played.to(), 0, 0);
+      position[history[moveNum].played.to()] = NONE;
+      addPieceToHand(onMove, history[moveNum].played.moved(), 0);
+      enPassant = history[moveNum].takeBack.oldep;
+      hashValue = history[moveNum].takeBack.oldHash;
+      handKey = history[moveNum].takeBack.oldHandKey;
 #ifdef DEBUG_HASH
-	  hashValueT = takeBackHistory[moveNum].oldHashT; 
+	  hashValueT = history[moveNum].takeBack.oldHashT; 
 #endif
-	  memcpy(attacks,takeBackHistory[moveNum].attacks,  sizeof(attacks));
+	  memcpy(attacks,history[moveNum].takeBack.attacks,  sizeof(attacks));
       
 	  return;
       }
 
    /* If the move castled move the rook back to it's starting square */
 
-   if (moveHistory[moveNum].moved() == KING) 
+   if (history[moveNum].played.moved() == KING) 
       {
-      if (moveHistory[moveNum].to() == moveHistory[moveNum].from() + TWO_FILES) 
+      if (history[moveNum].played.to() == history[moveNum].played.from() + TWO_FILES) 
          {
-         movePiece(onMove, ROOK, moveHistory[moveNum].from() + ONE_FILE,
-         moveHistory[moveNum].from() + THREE_FILES, 0, 0);
+         movePiece(onMove, ROOK, history[moveNum].played.from() + ONE_FILE,
+         history[moveNum].played.from() + THREE_FILES, 0, 0);
          }
-      else if (moveHistory[moveNum].to() == moveHistory[moveNum].from() - TWO_FILES) 
+      else if (history[moveNum].played.to() == history[moveNum].played.from() - TWO_FILES) 
          {
-         movePiece(onMove, ROOK, moveHistory[moveNum].from() - ONE_FILE,
-         moveHistory[moveNum].from() - FOUR_FILES, 0, 0);
+         movePiece(onMove, ROOK, history[moveNum].played.from() - ONE_FILE,
+         history[moveNum].played.from() - FOUR_FILES, 0, 0);
          }
-      kingSquare[onMove] = moveHistory[moveNum].from();
+      kingSquare[onMove] = history[moveNum].played.from();
       }
 
    /* If the move was a pawn promotion then:
       Remove the promoted piece from the board
       Add the pawn to the board */
  
-   if (moveHistory[moveNum].promotion() != NONE) 
+   if (history[moveNum].played.promotion() != NONE) 
       {
-      removePiece(onMove, moveHistory[moveNum].promotion(), moveHistory[moveNum].to(), 0, 0);
-      addPiece(onMove, PAWN, moveHistory[moveNum].to(), 0, 0);
-      promotedPawns.unsetSquare(moveHistory[moveNum].to());
+      removePiece(onMove, history[moveNum].played.promotion(), history[moveNum].played.to(), 0, 0);
+      addPiece(onMove, PAWN, history[moveNum].played.to(), 0, 0);
+      promotedPawns.unsetSquare(history[moveNum].played.to());
       }
 
    /* See if we moved a promoted pawn */
 
-   if (promotedPawns.squareIsSet(moveHistory[moveNum].to())) 
+   if (promotedPawns.squareIsSet(history[moveNum].played.to())) 
       {
-      promotedPawns.unsetSquare(moveHistory[moveNum].to());
-      promotedPawns.setSquare(moveHistory[moveNum].from());
+      promotedPawns.unsetSquare(history[moveNum].played.to());
+      promotedPawns.setSquare(history[moveNum].played.from());
       }
 
    
    /* Normal Move */
    
-   if (takeBackHistory[moveNum].captured == NONE)
+   if (history[moveNum].takeBack.captured == NONE)
       {
-      movePiece(onMove, moveHistory[moveNum].moved(), moveHistory[moveNum].to(), moveHistory[moveNum].from(), 0, 0);
+      movePiece(onMove, history[moveNum].played.moved(), history[moveNum].played.to(), history[moveNum].played.from(), 0, 0);
       }
    else 
       {
-      replacePiece(onMove, moveHistory[moveNum].moved(), OFF_MOVE, takeBackHistory[moveNum].captured, moveHistory[moveNum].to(), 0, 0);
-      addPiece(onMove, moveHistory[moveNum].moved(), moveHistory[moveNum].from(), 0, 0);
-      if (!takeBackHistory[moveNum].capturedPromotedPawn) 
+      replacePiece(onMove, history[moveNum].played.moved(), OFF_MOVE, history[moveNum].takeBack.captured, history[moveNum].played.to(), 0, 0);
+      addPiece(onMove, history[moveNum].played.moved(), history[moveNum].played.from(), 0, 0);
+      if (!history[moveNum].takeBack.capturedPromotedPawn) 
          {
-         hand[onMove][takeBackHistory[moveNum].captured]--;
+         hand[onMove][history[moveNum].takeBack.captured]--;
          }
       else 
          {
          hand[onMove][PAWN]--;
-         promotedPawns.setSquare(moveHistory[moveNum].to());
+         promotedPawns.setSquare(history[moveNum].played.to());
          }
       }
 
    /* Restore the saved information */
 
    
-   memcpy(attacks,takeBackHistory[moveNum].attacks,  sizeof(attacks));
+   memcpy(attacks,history[moveNum].takeBack.attacks,  sizeof(attacks));
    
-   setCastleOptions(WHITE, KING_SIDE, takeBackHistory[moveNum].oldCastle[WHITE][KING_SIDE], 0);
-   setCastleOptions(WHITE, QUEEN_SIDE, takeBackHistory[moveNum].oldCastle[WHITE][QUEEN_SIDE], 0);
-   setCastleOptions(BLACK, KING_SIDE, takeBackHistory[moveNum].oldCastle[BLACK][KING_SIDE], 0);
-   setCastleOptions(BLACK, QUEEN_SIDE, takeBackHistory[moveNum].oldCastle[BLACK][QUEEN_SIDE], 0);
-
-   enPassant = takeBackHistory[moveNum].oldep;
-   hashValue = takeBackHistory[moveNum].oldHash;
+   setCastleOptions(WHITE, KING_SIDE, history[moveNum].takeBack.oldCastle[WHITE][KING_SIDE], 0);
+   setCastleOptions(WHITE, QUEEN_SIDE, history[moveNum].takeBack.oldCastle[WHITE][QUEEN_SIDE], 0);
+   setCastleOptions(BLACK, KING_SIDE, history[moveNum].takeBack.oldCastle[BLACK][KING_SIDE], 0);
+   setCastleOptions(BLACK, QUEEN_SIDE, history[moveNum].takeBack.oldCastle[BLACK][QUEEN_SIDE], 0);
+
+   enPassant = history[moveNum].takeBack.oldep;
+   hashValue = history[moveNum].takeBack.oldHash;
+   handKey = history[moveNum].takeBack.oldHandKey;
 #ifdef DEBUG_HASH   
-   hashValueT = takeBackHistory[moveNum].oldHashT; 
+   hashValueT = history[moveNum].takeBack.oldHashT; 
 #endif
 
    /* If the move was capturing en passant then put the pawn back two
       squares advanced */
 
-   if (takeBackHistory[moveNum].captured == PAWN && moveHistory[moveNum].to() == enPassant) 
+   if (history[moveNum].takeBack.captured == PAWN && history[moveNum].played.to() == enPassant) 
       {
       if (onMove == WHITE) 
          {
@@ -1856,7 +2057,6 @@ int boardStruct::getMaterial()
 
 #endif
 
-#ifdef DEBUG_HASH
 /*
  * Function: getHashValue
  * Input:    None
@@ -1869,6 +2069,8 @@ qword boardStruct::getHashValue()
    return hashValue;
 }
 
+#ifdef DEBUG_HASH
+
 /* Function: showDebugInfo
  * Input:    None
  * Output:   None.
@@ -113,7 +113,17 @@ enum game_result { WHITE_MATE, BLACK_MATE, WHITE_RESIGNATION, BLACK_RESIGNATION,
                                      there isn't a hash move)
 */
 
-extern qword BitInBB[SQUARES]; 
+/* The tables that are marked TABLE are made by gentables.cpp when Sunsetter
+   is built and are constant in the tables.cpp it writes.  In gentables.cpp
+   itself they are filled in at run time */
+
+#ifdef GENERATING_TABLES
+#define TABLE
+#else
+#define TABLE const
+#endif
+
+extern TABLE qword BitInBB[SQUARES]; 
 
 struct move {
 
@@ -127,7 +137,7 @@ struct move {
                     (mp << 16) | (p << 19); };
   inline move(square f, square t, piece mp) { data = f | (t << 8) | 
 					(mp << 16); };
-  inline move()                    {data=0; makeBad();};
+  inline CONSTEXPR move() : data(1 << 23) { };  /* A bad move */
 
   inline int operator ==(move m)   { return data == m.data; };
   inline int operator !=(move m)   { return data != m.data; };
@@ -149,13 +159,13 @@ struct bitboard {
   public:
   qword data;
    
-  inline bitboard(qword d) { data = d; };
-  inline bitboard()        {data = 0; };
+  inline CONSTEXPR bitboard(qword d) : data(d) { };
+  inline CONSTEXPR bitboard() : data(0) { };
 
   int popCount();                  
   // destroys the bitboard and tells how many bits were set 
 
-  inline int moreThanOne() { return (data & (data - 1)) != 0; };
+  inline int moreThanOne() const { return (data & (data - 1)) != 0; };
   inline void setBits(qword d) { data |= d; };
   inline void setBits(bitboard b) { data |= b.data; };
   inline void unsetBits(qword d) { data ^= d; }; 
@@ -169,24 +179,24 @@ struct bitboard {
 
   inline void setSquare(square sq) {  data |= (BitInBB[sq]); };
   inline void unsetSquare(square sq) {  data ^= BitInBB[sq]; }; 
-  inline int bitIsSet(square s) { return (data & s) != 0; };
-  inline int squareIsSet(square s) { return (data & BitInBB[s]) != 0; };
-  inline int hasBits() { return data != 0; };
+  inline int bitIsSet(square s) const { return (data & s) != 0; };
+  inline int squareIsSet(square s) const { return (data & BitInBB[s]) != 0; };
+  inline int hasBits() const { return data != 0; };
   inline bitboard operator =(qword d) { data = d; return *this; };
   inline bitboard operator =(bitboard b) { data = b.data; return *this; };
-  inline int operator ==(bitboard b) { return data == b.data; };
-  inline int operator !=(bitboard b) { return data != b.data; };  
+  inline int operator ==(bitboard b) const { return data == b.data; };
+  inline int operator !=(bitboard b) const { return data != b.data; };  
 
-  inline bitboard operator |(qword b) { return bitboard(data | b); };
-  inline bitboard operator |(bitboard b) { return bitboard(data | b.data); };
+  inline bitboard operator |(qword b) const { return bitboard(data | b); };
+  inline bitboard operator |(bitboard b) const { return bitboard(data | b.data); };
   inline bitboard operator |=(bitboard b) { data |= b.data; return *this; };
 
-  inline bitboard operator &(qword b) { return bitboard(data & b); };
-  inline bitboard operator &(bitboard b) { return bitboard(data & b.data); };
+  inline bitboard operator &(qword b) const { return bitboard(data & b); };
+  inline bitboard operator &(bitboard b) const { return bitboard(data & b.data); };
   inline bitboard operator &=(bitboard b) { data &= b.data; return *this; };
-  inline bitboard operator <<(int i) {  return bitboard(data << i); };
-  inline bitboard operator >>(int i) {  return bitboard(data >> i); };  
-  inline duword operator >(int i) { return (i < 32 ? ((duword) data) >> i :
+  inline bitboard operator <<(int i) const {  return bitboard(data << i); };
+  inline bitboard operator >>(int i) const {  return bitboard(data >> i); };  
+  inline duword operator >(int i) const { return (i < 32 ? ((duword) data) >> i :
                 ((duword) (data >> 32)) >> (i - 32)); };
 
   /* The '>' operator is split shift right, an idea borrowed from crafty.  It
@@ -195,7 +205,7 @@ struct bitboard {
      doing 64 bit shifts and is much quicker to user then the normal shift
      right.  It should be used when only the bottom 32 bits are needed */
 
-  inline bitboard operator ~(void) { return bitboard(~data); };
+  inline bitboard operator ~(void) const { return bitboard(~data); };
 };
 
 /* Function: firstSquare
@@ -277,39 +287,85 @@ int firstSquare (qword a)
 
 /* *Attacks is where a piece attacks from a square */
 
-extern bitboard pawnAttacks[COLORS][SQUARES];
-extern bitboard contactBishopAttacks[SQUARES]; 
-extern bitboard contactRookAttacks[SQUARES];
-extern bitboard knightAttacks[SQUARES];
-extern bitboard kingAttacks[SQUARES];
+extern TABLE bitboard pawnAttacks[COLORS][SQUARES];
+extern TABLE bitboard contactBishopAttacks[SQUARES]; 
+extern TABLE bitboard contactRookAttacks[SQUARES];
+extern TABLE bitboard knightAttacks[SQUARES];
+extern TABLE bitboard kingAttacks[SQUARES];
 
 /* squaresTo is the squares from the first square to the second.  Including
    the second square, but not including the first */
 
-extern bitboard squaresTo[SQUARES][SQUARES];
+extern TABLE bitboard squaresTo[SQUARES][SQUARES];
 
 /* squaresPast is the squares are after the second square, one the same
    line as the first */
 
-extern bitboard squaresPast[SQUARES][SQUARES];
+extern TABLE bitboard squaresPast[SQUARES][SQUARES];
 
 /* nearSquares are squares 2 or less squares away */
 
-extern bitboard nearSquares[SQUARES][COLORS];
+extern TABLE bitboard nearSquares[SQUARES][COLORS];
 
 /* directionPiece is a bishop, rook or none, depending on what line moving
    piece can move from the first square to the second */
 
-extern piece directionPiece[SQUARES][SQUARES];
+extern TABLE piece directionPiece[SQUARES][SQUARES];
+
+/* ulShift and urShift are where a square is on the diagonal bitboards, the 
+   DiagShifts how far to shift them to get its diagonal on the lowest bits.
+   The AttacksArrays are where a piece attacks along a line, for each square
+   and what is occupied on the line (see bitboard.cpp) */
+
+extern TABLE int ulShift[SQUARES];
+extern TABLE int urShift[SQUARES];
+extern TABLE int ulDiagShift[SQUARES];
+extern TABLE int urDiagShift[SQUARES];
+
+extern TABLE bitboard rankAttacksArray[SQUARES][256];
+extern TABLE bitboard fileAttacksArray[SQUARES][256];
+extern TABLE bitboard diagURAttacksArray[SQUARES][256];
+extern TABLE bitboard diagULAttacksArray[SQUARES][256];
+
+/* The random numbers the hash values are made of */
+
+extern TABLE qword hashNumbers[COLORS][PIECES][64];
+extern TABLE qword hashHandNumbers[COLORS][PIECES][17];
+extern TABLE qword hashCastleNumbers[COLORS][2];
+extern TABLE qword hashEnPassantNumbers[66];  /* 66 to include room for OFF_BOARD */
+
+#ifdef DEBUG_HASH
+extern TABLE qword hashNumbersT[COLORS][PIECES][64];
+extern TABLE qword hashHandNumbersT[COLORS][PIECES][17];
+extern TABLE qword hashCastleNumbersT[COLORS][2];
+extern TABLE qword hashEnPassantNumbersT[66];
+#endif
+
+/* materialEntry holds the eval terms that only depend on what the players
+   have in hand.  They are kept in a small table indexed by the handKey of
+   the position, see probeMaterial() */
+
+#define MATERIAL_TABLE_SIZE 4096  /* Must be a power of 2 */
+
+struct materialEntry {
+  qword key;                     /* handKey of the hands this entry is for */
+  sword sitMalus[COLORS];        /* Value of the pieces a color would have
+                                    to sit for in bughouse */
+  sbyte pressure[COLORS];        /* getMaterialInHand() for each color */
+  byte filled;
+};
+
+struct nnueAccumulator;          /* see nnue.h */
 
 /* takeBackInfo has stuff to take back a move */
 
 struct takeBackInfo {
-  sword attacks[COLORS][64];
+  sbyte attacks[COLORS][64];
   piece captured;
   byte oldCastle[COLORS][2];
   square oldep; 
   qword oldHash;
+  qword oldHandKey;
 
 #ifdef DEBUG_HASH
   qword oldHashT; 
@@ -318,6 +374,35 @@ struct takeBackInfo {
   byte capturedPromotedPawn; /* Only used in crazyhouse */
 };
 
+/* How many half-moves of history clone() copies */
+
+#define CLONE_HISTORY 4
+
+/* historyEntry is what the board remembers about each half-move of the 
+   game.  They are kept on a stack that grows with the game, away from the
+   position itself, see growHistory() */
+
+struct historyEntry {
+  bitboard attackedSomething;    /* Which squares the move directly attacked */
+  takeBackInfo takeBack;         /* Information to take back the move */
+  move played;                   /* The move that was played */
+  int check;                     /* Whether we were in check on that move */
+  int bestCaptureGain;           /* The best possible capture at that move,
+									because of this we need to make sure 
+									that orderCaptures is used on _every_
+									node */
+};
+
+/* checkInfo has what is needed to see if a move of the side to move gives
+   check without making the move, see setCheckInfo() */
+
+struct checkInfo {
+  square kingSquare;             /* The king that would be in check */
+  bitboard checkSquares[PIECES]; /* Where each piece gives check from */
+  bitboard discovered;           /* Pieces that uncover a check when they
+                                    leave the line to the king */
+};
+
 							/* transpositionEntry is what the transposition 
 							tables are built on */
 
@@ -349,7 +434,6 @@ struct transpositionEntry {
 void dumpBoardInfo(); 
          
 
-void initBitboards();       // Must be called durring initialization 
 void initializeEval();  
 
 void initializeHistory();	// Used to create the "good" moves in aimoves first. 
@@ -357,12 +441,13 @@ void updateHistory(move m, int depth);
 void makeHistoryOld(); 
 
 
-color otherColor(color c);
+inline color otherColor(color c) { return (color) (BLACK - c); };
 int isInHand(square sq);
 int rank(square sq);
 int file(square sq);
 
 void zapHashValues();
+int swapTranspositionTable(transpositionEntry *other[COLORS]);
 
 
 								/* The board structure. */
@@ -370,13 +455,13 @@ void zapHashValues();
 struct boardStruct {
   private:
 
-  piece position[64];            /* What piece is on each square */
+  /* The position.  It is kept small and together at the start of the
+     board, so what the search touches on every move is in a few cache
+     lines.  The game history is on a separate stack */
+
+  byte position[64];             /* What piece is on each square */
 	  
   bitboard occupied[COLORS];     /* What squares are occupied by each color */
-
-  bitboard moveAttackedSomething[MAX_GAME_LENGTH];
-								 /* Which squares the last move directly attacked */
-
   bitboard occupiedMirror;       /* What squares are occupied, but with the
 									file and rank bits switched */
   bitboard occupiedUR;           /* What squares are occupied, organized by
@@ -384,65 +469,69 @@ struct boardStruct {
   bitboard occupiedUL;           /* What squares are occupied, organized by
                                     diagonals going up and to the left */
   bitboard pieces[PIECES];       /* What squares are occupied by each piece */
+  bitboard promotedPawns;        /* Where promotedPawns are */
+
+  qword hashValue;               /* The hash value for the position, used for
+									the transposition table. */
+#ifdef DEBUG_HASH
+  qword hashValueT; 
+#endif
+  qword handKey;                 /* The part of the hash value that comes
+                                    from the hands, indexes the material
+                                    table */
+
+  sbyte attacks[COLORS][64];     /* How well each color attacks a square */
+  sbyte hand[COLORS][PIECES];    /* What is in the player's hands */
+  byte canCastle[COLORS][2];     /* If the players can castle on either side */
 
   square kingSquare[COLORS];     /* Where each king is */
+  color onMove;                  /* The color on the move */
+  square enPassant;              /* The square, if any, a pawn passed over */
+  int moveNum;                   /* What half-move the position is on. */
+
+  /* Members used by eval() */  
+
+  int material;                 /* The relative material with positive 
+									 meaning white is up in material */
+  int development;              /* The relative delelopment */
+
+  /* The game history, indexed by moveNum.  It has room for historySize
+     half-moves, which is always at least moveNum + 2 */
+
+  historyEntry *history;
+  int historySize;
+
+  void growHistory(int needed);
+
+  /* The accumulators of the network eval, one for every half-move made
+     since the last nnueRefresh(), only used if nnueActive */
+
+  nnueAccumulator *nnueStack;
+  int nnueStackSize;
+  int nnueIndex;
+
+  /* Things that change once per move in the game */
 
-  sword attacks[COLORS][64];       /* How well each color attacks a square */
-  int hand[COLORS][PIECES];      /* What is in the player's hands */
   int whiteTime;                 /* Time in 1/100th seconds on white's clock */
   int blackTime;                 /* Time in 1/100th seconds on black's clock */
   int timeTaken;                 /* Time in 1/100th seconds of how long the
 									player thought on the last move */
 
-
-
-
   double lastMoveTime;		     /* When the last move was played */ 
   color playing;                 /* The color the computer in playing */
-  color onMove;                  /* The color on the move */
-  byte canCastle[COLORS][2];     /* If the players can castle on either side */
-  square enPassant;              /* The square, if any, a pawn passed over */
-  bitboard promotedPawns;        /* Where promotedPawns are */
-  move moveHistory[MAX_GAME_LENGTH]; 
-								 /* What moves were played. */
-  takeBackInfo takeBackHistory[MAX_GAME_LENGTH]; 
-								 /* Information to take back
-									the moves played (hopefully no more than MAX_GAME_LENGTH)*/
-  int checkHistory[MAX_GAME_LENGTH];
-								 /* whether we were in check on that move */
-
-  int bestCaptureGain[MAX_GAME_LENGTH];
-								 /* the best possible capture at that move,
-								    because of this we need to make sure 
-									that orderCaptures is used on _every_
-									node */
-
-  int moveNum;                   /* What half-move the position is on. */
-
-  qword hashValue;               /* The hash value for the position, used for
-									the transposition table. */
-#ifdef DEBUG_HASH
-  qword hashValueT; 
-#endif
 
   /* changeBoard changes depending on if we're playing bug or crazyhouse.
-     To handle this it calls the function pointed to by currentChangeBoard.
+     The search calls changeBoard<R>() which picks the right one at compile
+     time, everybody else goes through changeBoard() which looks at variant.
      Ditto for unchangeBoard */
 
-  void (boardStruct::*currentChangeBoard)(move m);
-  void (boardStruct::*currentUnchangeBoard)();
+  rules variant;
 
   void bugChangeBoard(move m);
   void bugUnchangeBoard();
   void ZHChangeBoard(move m);
   void ZHUnchangeBoard();
 
-  /* Members used by eval() */  
-
-  int material;                 /* The relative material with positive 
-									 meaning white is up in material */
-  int development;              /* The relative delelopment */
-
   public:                       /* Primitives to access the variables */
  	  
   /* Some primitives to change the board */
@@ -460,15 +549,25 @@ struct boardStruct {
   void setCheckHistory(int check); 
 
   void copy(boardStruct *dest);        
+  void clone(boardStruct *dest);		/* copy() with only the end of the
+									history, for the search */
 								/* Copies itself to another board,
 									the other board must already
 									have been init()ed */
+  void freeStacks();			/* Frees the history and network 
+									stacks of a board that goes away */
+  int pack(char *buf);			/* Writes clone() to PACKED_BOARD_SIZE
+									bytes, to give it to another 
+									process, see split.cpp */
+  void unpack(const char *buf);	/* Makes the board what pack() wrote */
 
   void resetBoard();            /* Sets the pieces to the original
 									position and does the other
 									things needed to start a 
 									game.*/
   void setBoard(const char *pieces, const char *turn, const char *castles, const char *ep);
+  void nnueRefresh();           /* Sets up the network eval for the
+									position from scratch */
 
   void resetBitboards();        /* resets the bitboards for a new
 									game */
@@ -484,6 +583,13 @@ struct boardStruct {
   void unchangeBoard();			/* Takes back the last move made
 									by changeBoard() */
 
+  template <rules R> inline void changeBoard(move m)
+	{ if (R == CRAZYHOUSE) ZHChangeBoard(m); else bugChangeBoard(m); };
+  template <rules R> inline void unchangeBoard()
+	{ if (R == CRAZYHOUSE) ZHUnchangeBoard(); else bugUnchangeBoard(); };
+								/* The same for a variant known at
+									compile time, used by the search */
+
   void makeNullMove();			/* Make and unmake NullMoves, see search() */
   void unmakeNullMove(); 
 
@@ -518,9 +624,7 @@ struct boardStruct {
   piece pieceOnSquare(square sq);
   bool isPieceOnSquare(square sq, piece p, color c);
 
-#ifdef DEBUG_HASH
   qword getHashValue();
-#endif
 
   move rawAlgebraicMoveToDBMove(const char *notation);
   move algebraicMoveToDBMove(const char *notation);
@@ -532,6 +636,10 @@ struct boardStruct {
   int isLegal(move m);                /* returns TRUE if the move is legal,
 									 FALSE if not */
 
+  int isPseudoLegal(move m);          /* returns TRUE if the move could be
+									 generated in the position, it 
+									 may still leave the king in check */
+
   int isInCheck(color side);         /* returns 1 if side is in check,
 									 2 if side is in double check */
 
@@ -541,12 +649,19 @@ struct boardStruct {
   int cantBlock();                    /* returns TRUE if the side to move
 									can't block a check */
 
-  int aiMoves(move *m);               /* AIMoves() fills an array of 
-									with moves in the position */
+  int aiMoves(move *m, bitboard dropTo = ~qword(0));
+									/* AIMoves() fills an array of 
+									with moves in the position, the
+									drops only go to dropTo */
 
   int captureMoves(move *m);          /* captureMoves fills an array of 
 									moves with the captures in a 
 									position. */
+
+  template <color C> int aiMoves(move *m, bitboard dropTo);
+												/* The same for the side */
+  template <color C> int captureMoves(move *m);	/* to move known at compile
+													time */
   int captureGain(color c, move m);			/* How much material a move gains */
 
   move *orderCaptures(move *m);				/* Orders captures based on material gain*/
@@ -561,12 +676,23 @@ struct boardStruct {
 
   int checkEvasionOthers(move *m);
 
+  void setCheckInfo(checkInfo *ci);		/* Finds the check squares against
+												the other side's king */
+
+  int givesCheck(move m, checkInfo *ci);	/* returns TRUE if the move gives
+												check, without making it */
+
+  int checkingMoves(move *m, checkInfo *ci);	/* fills an array of moves with
+												the checks that aren't captures */
+  template <color C> int checkingMoves(move *m, checkInfo *ci);
+
   int eval();                  /* eval() evaluates the position and
 								 returns the value */
+  template <rules R> int eval();	/* eval() for a known variant */
 
 
-  int bughouseSitForEval();		/* Malus in Bughouse if we'd have to sit for a piece */
-  int bughouseMateEval();		/* see above, for mates */ 
+  template <rules R> int bughouseSitForEval();	/* Malus in Bughouse if we'd have to sit for a piece */
+  template <rules R> int bughouseMateEval();	/* see above, for mates */ 
 
   int highestAttacked(square moveTo);	/* Razor full search conditions */
   int escapingAttack(square movedFrom, square moveTo);
@@ -575,6 +701,8 @@ struct boardStruct {
 
   int standpatCondition();				
 
+  int futilityCondition();
+
 
   #ifdef GAMETREE  // needed when outputing a game tree in html 
 
@@ -660,6 +788,7 @@ struct boardStruct {
   bitboard contactAttacksFrom(piece p, square sq); 
   bitboard attacksTo(square sq);
   bitboard blockedAttacks(color c, square where);
+  bitboard lineBlockers(square ks, color blocker, color slider);
   int isAttacked(color c, square sq);
   bitboard fileAttacks(square sq);
   bitboard rankAttacks(square sq);
@@ -673,17 +802,29 @@ struct boardStruct {
 
   /* These help out eval() */
 
-  int kingSafetyEval(color c); 
+  template <color C> int kingSafetyEval(); 
   int boardControlEval();
   int getMaterialInHand(color c); /* gets the values of material in hand */
+  materialEntry *probeMaterial();  /* the hand terms of this position */
+
+  /* The network eval, see nnue.cpp */
 
-  /* These help out making moves */
+  int nnueEval();
+  void nnueCompute(nnueAccumulator *acc);
+  void nnuePush();
+  void nnueAddPiece(color c, piece p, square sq);
+  void nnueRemovePiece(color c, piece p, square sq);
+  void nnueAddToHand(color c, piece p);
+  void nnueRemoveFromHand(color c, piece p);
 
-  void whitePawnMovesTo(move **m, bitboard possibleTo, piece promote);
-  void blackPawnMovesTo(move **m, bitboard possibleTo, piece promote);
-  void whitePawnCapturesTo(move **m, bitboard possibleTo);
-  void blackPawnCapturesTo(move **m, bitboard possibleTo);
+  /* These help out making moves, they are written once for both colors
+     and the color C is the side to move */
+
+  template <color C> void pawnMovesTo(move **m, bitboard possibleTo, piece promote);
+  template <color C> void pawnCapturesTo(move **m, bitboard possibleTo);
+  template <color C> void pawnPushesTo(move **m, bitboard possibleTo);
   int  skippedMoves(move *m);
+  template <color C> int skippedMoves(move *m);
 
   /* Functions to verify that nothing screwy happened */
 #ifndef NDEBUG
@@ -691,9 +832,14 @@ struct boardStruct {
 #endif
 };
 
+/* The most bytes boardStruct::pack() writes */
+
+#define PACKED_BOARD_SIZE (sizeof(boardStruct) + \
+                           CLONE_HISTORY * sizeof(historyEntry))
+
 /* Externs */
 
-extern boardStruct gameBoard;   /* The main board */
+extern SEARCH_LOCAL boardStruct gameBoard;   /* The main board */
 extern const int adOffset[8];	/* What to add to a square to make a piece
 									move in an attackDirection */
 extern const piece adPiece[8];  /* What piece (other than the queen) moves
@@ -806,5 +952,22 @@ extern const int knightDirection[8];
 #endif
 
 
+/* Pawn move helpers for the color C.  forward<C>() moves the squares of a 
+   bitboard one rank towards the other side, pawnPush<C>() is how much the
+   square number changes when that happens */
+
+template <color C> inline bitboard forward(bitboard b)
+	{ return (C == WHITE) ? (b << ONE_RANK) : (b >> ONE_RANK); };
+
+template <color C> inline int pawnPush()
+	{ return (C == WHITE) ? ONE_RANK : -ONE_RANK; };
+
+template <color C> inline qword lastRank()
+	{ return (C == WHITE) ? EIGHTH_RANK : FIRST_RANK; };
+
+template <color C> inline qword doublePushRank()
+	{ return (C == WHITE) ? FOURTH_RANK : FIFTH_RANK; };
+
+
 #endif
 
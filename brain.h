@@ -25,6 +25,11 @@
 /* Various search value definitions.  These kind of random, but also kind of
    interlinked so don't change 'em */
 
+/* math.h has its own INFINITY, the search uses this one */
+#ifdef INFINITY
+#undef INFINITY
+#endif
+
 #define INFINITY    32000
 #define MATE        20000 /* If a move is mate it will be at least this */
 #define MATE_IN_ONE 30000 /* The value of mate in one, mate in 2 will be 
@@ -50,6 +55,17 @@
 /* Stuff for search extensions.  These can be in fractions of one ply.  */
 #define ONE_PLY               4
 
+/* Futility pruning is not done when a king is in this much danger
+   (kingSafetyEval() times the material the other side holds) */
+#define FUTILITY_KING_DANGER  120
+
+/* Size of the move number index of the late move reduction table */
+#define LMR_TABLE_MOVES       64
+
+/* The first iteration searchRoot() hands root moves to the workers in, the
+   ones before are too quick to be worth it */
+#define SPLIT_DEPTH           5
+
 /* Define PrincipalVariation which is a struct to hold the best moves by
    both sides that Sunsetter searched */
 
@@ -66,7 +82,8 @@ struct PrincipalVariation {
 extern char  personalityIni[10][512]; 
 extern int  PERSONALITY; 
 
-extern int  FIXED_DEPTH; 
+extern SEARCH_LOCAL int  FIXED_DEPTH; 
+extern SEARCH_LOCAL int  FIXED_TIME; 
 
 extern int  CHECK_EXTENSION;
 extern int  CAPTURE_EXTENSION;
@@ -77,6 +94,16 @@ extern int  CC_DEPTH;
 
 extern int      NULL_REDUCTION; 
 
+extern int  FUTILITY_MARGIN;
+extern int  FUTILITY_DEPTH;
+
+extern int  LMR_MOVES;
+extern int  LMR_DIVISOR;
+
+extern int  DELTA_MARGIN;
+
+extern int  MATE_NODES;
+
 extern int  NK_FACTOR;  
 extern int  BC_FACTOR;  
 extern int  DE_FACTOR;  
@@ -85,30 +112,36 @@ extern int  DE_FACTOR;
 
 
 extern int pValue[PIECES]; 
+extern int DE_SCALE[PIECES];					/* Percent of the development
+												   table of a piece used */
 
 extern int DevelopmentTable[COLORS][PIECES][64];   /* How good it is to have a
                                                    piece on a square */
+extern TABLE int BaseDevelopmentTable[COLORS][PIECES][64];
+												/* The same before it's
+												   multiplied by DE_FACTOR 
+												   and DE_SCALE */
 
-extern bitboard generateToFirst[PIECES][COLORS][2]; 
+extern SEARCH_LOCAL bitboard generateToFirst[PIECES][COLORS][2]; 
 
-extern int hashMoveCircle;
+extern SEARCH_LOCAL int hashMoveCircle;
 
 
 
 extern int ratingDiff;                          /* The rating difference */
-extern double millisecondsPerMove;              /* How long to think */
-extern int pondering;                           /* If we're pondering */
-extern int tryToPonder;                         /* If we should try to
+extern SEARCH_LOCAL double millisecondsPerMove;              /* How long to think */
+extern SEARCH_LOCAL int pondering;                           /* If we're pondering */
+extern SEARCH_LOCAL int tryToPonder;                         /* If we should try to
                                                    ponder */
 
-extern int learning;							/* If we should use the learn file */
-extern int analyzeMode;							/* If we should not make a move 
+extern SEARCH_LOCAL int learning;							/* If we should use the learn file */
+extern SEARCH_LOCAL int analyzeMode;							/* If we should not make a move 
 												   ever and accept all move input */
-extern int xboardMode;							/* should we send "tellics" stuff */
+extern SEARCH_LOCAL int xboardMode;							/* should we send "tellics" stuff */
 
 /* AIBoard is the board Sunsetter uses to think */
 
-extern boardStruct AIBoard;
+extern SEARCH_LOCAL boardStruct AIBoard;
 
 /* Now some function prototypes */
 
@@ -116,10 +149,26 @@ extern boardStruct AIBoard;
 void findMove(move *rightMove);               /* Called by the main loop to
                                                  find the right move. */
 
+int searchPosition(move *rightMove);          /* Searches gameBoard for 
+                                                 analyzeSearch() */
+void analyzeBoard(boardStruct *board, rules variant);
+                                              /* Sets up gameBoard to be
+                                                 analyzed */
+int analyzeSearch(int depth, int milliseconds, char *moveString, int *value);
+                                              /* Searches it for 
+                                                 libsunsetter.cpp and
+                                                 server.cpp */
+int searchRootMove(move m, int depth, int alpha, int beta, char *pvText);
+                                              /* Searches a move of AIBoard
+                                                 for a worker of split.cpp */
+
 void ponder(void);                            /* Called by the main loop
                                                  when it's Sunsetter's
                                                  opponent's move */
+void handsChanged();                          /* Tells the search the hands
+                                                 changed */
 
+template <rules R>
 int search(int alpha, int beta,
            int depth, int ply, int wasNullMove); /* Uses a recursive alpha-beta
                                                  search to assign a value to
@@ -129,6 +178,16 @@ int search(int alpha, int beta,
 int quiesce(int alpha, int beta, int ply);    
                                               /* evaluates the position with a
                                                  quiescense search*/
+template <rules R>
+int quiesce(int alpha, int beta, int ply);    /* The same, for a variant known
+                                                 at compile time */
+
+void startMateProof();                        /* Looks for a forced mate with
+                                                 checks only next to the
+                                                 search, see mate.cpp */
+int stopMateProof(move *mateMove, int *mateValue);
+                                              /* Stops it, 1 if it proved
+                                                 a mate */
 
 void setpValue(color c, piece p, sword value); 
                                               /* Changes the value
@@ -137,12 +196,17 @@ void sit();                                   /* Commands to make Sunsetter sit*
 void unsit();                                 /* or stop sitting */
 void startSearchOver();                       /* Makes Sunsetter restart
                                                  searching */
+void restartSearch();                         /* The same, but keeps the
+                                                 hash table */
 void analyzeUpdate();                         /* In analyze mode we provide
                                                  updates at least every 4
                                                  seconds. */
 void stopThought();                           /* Called to make Sunsetter
                                                  stop thinking about the move
                                                  and play whatever it has. */
+void checkSpeculation();                      /* Called after input to see 
+                                                 if the hands we sit for 
+                                                 changed */
 void forceDeepBugToMove();                    /* Makes Sunsetter play a move
                                                  even if it gets it mated */
 void doMove(move m);                          /* Makes Sunsetter play a move
@@ -151,8 +215,23 @@ void doMove(move m);                          /* Makes Sunsetter play a move
 void resetAI(void);                           /* Stop all thinking about
                                                  moves */
 
+void initializeReductions();                  /* Fills the late move
+                                                 reduction table */
+
 void saveLearnTableToDisk();                  /* Guess what this does :) */
-void readLearnTableFromDisk(); 
+void readLearnTableFromDisk();
+
+/* The worker processes searchRoot() splits the root moves over, see 
+   split.cpp */
+
+int startWorkers(int count);                  /* Forks count new workers */
+int splitWorkers();                           /* How many there are */
+int splitIdleWorker();                        /* One that isn't searching */
+void splitSend(int worker, int job, move m, int depth, int alpha, int beta);
+                                              /* Has it search a root move */
+int splitReceive(int *job, int *value, int *nodes, char *pvText);
+                                              /* Gets an answer */
+void splitCancel();                           /* Stops the ones searching */ 
 
 
 #endif
@@ -66,29 +66,35 @@
 /* bookMove() should have its own header file, minor todo */
 extern int bookMove(move *rightMove, boardStruct &where);
 
-int sitting;
-int toldpartisit;
-int toldparttosit;
-int parttoldgo; 
-int partsitting;
-int psittinglong; 
+SEARCH_LOCAL int sitting;
+SEARCH_LOCAL int toldpartisit;
+SEARCH_LOCAL int toldparttosit;
+SEARCH_LOCAL int parttoldgo; 
+SEARCH_LOCAL int partsitting;
+SEARCH_LOCAL int psittinglong; 
 
 
 char personalityIni[10][512];
 
 int		PERSONALITY = 0; 
-int		FIXED_DEPTH; 
+SEARCH_LOCAL int		FIXED_DEPTH; 
+SEARCH_LOCAL int		FIXED_TIME; 
 int		CAPTURE_EXTENSION,CHECK_EXTENSION,FORCING_EXTENSION ; 
 int		NK_FACTOR, BC_FACTOR, DE_FACTOR; 
 int		CC_DEPTH, NULL_REDUCTION; 
+int		FUTILITY_MARGIN, FUTILITY_DEPTH; 
+int		LMR_MOVES, LMR_DIVISOR; 
+int		DELTA_MARGIN; 
+int		MATE_NODES; 
 
 int		pValue[PIECES]  = {0, 0, 0, 0, 0, 0, 0 };  
+int		DE_SCALE[PIECES]  = {0, 0, 0, 0, 0, 0, 0 };  
 
-long stats_overallsearches, stats_overallqsearches, stats_overallticks;
+SEARCH_LOCAL long stats_overallsearches, stats_overallqsearches, stats_overallticks;
 
 
 #ifdef DEBUG_STATS
-long  stats_overallDebugA, stats_overallDebugB; 
+SEARCH_LOCAL long  stats_overallDebugA, stats_overallDebugB; 
 #endif
 
 #ifdef DEBUG_HASH
@@ -100,13 +106,13 @@ long tree_positionsSaved;
 #endif
 
 int evaluation;
-int firstBigValue; 
+SEARCH_LOCAL int firstBigValue; 
 
-int gameInProgress;
+SEARCH_LOCAL int gameInProgress;
 
 int soughtGame;
 
-rules currentRules;
+SEARCH_LOCAL rules currentRules;
 
 /* Function:	setDefaultValues
  * Input:		none
@@ -121,6 +127,8 @@ void setDefaultValues()
 CC_DEPTH = 3; 
 
 FIXED_DEPTH=			0;
+FIXED_TIME=				0;		/* Milliseconds per move if not 0, 
+								   only used by libsunsetter.cpp */
 CHECK_EXTENSION=		(ONE_PLY * 3) / 4 ; 
 CAPTURE_EXTENSION=		ONE_PLY / 2;
 FORCING_EXTENSION=		ONE_PLY / 2;
@@ -143,11 +151,40 @@ BC_FACTOR = 5;   /* Factor for Control of Squares near the king.
 					on material in hand as well, and is computed on 
 					every eval() call. */
 
+FUTILITY_MARGIN = 90;  /* Margin per ply for futility pruning in the last
+					  FUTILITY_DEPTH plies of full width search. Quiet moves
+					  that can't bring eval + margin above alpha are skipped,
+					  and eval - margin above beta cuts right away. 
+					  0 turns it off. */
+
+FUTILITY_DEPTH = 1; 
+
+LMR_MOVES = 3;    /* Late move reductions: quiet moves after the first 
+					  LMR_MOVES get reduced by log(plies left) * log(moves 
+					  searched) * 100 / LMR_DIVISOR plies, and searched again
+					  if they come back above alpha. 0 turns it off. */
+
+LMR_DIVISOR = 250; 
+
+MATE_NODES = 20000;  /* How many positions proveMate() may look at before
+					  each search for a move in crazyhouse, it only 
+					  looks at checks and evasions.  0 turns it off. */
+
+DELTA_MARGIN = 150;  /* Captures in quiesce that can't get eval + twice the 
+					  value of the captured piece + DELTA_MARGIN above alpha
+					  are not tried. 0 turns it off. */
+
 DE_FACTOR = 3;   /* Factor for Developement.
 					This is a normal,  static table. 
 					Example: Queens and King in Center malus, 
 					Pawn on g2 bonus ... */
 
+/* How much of the development table of each piece counts, in percent.
+   The "pdefactor" ... "kdefactor" options set them for "sunsetter tune" */
+
+DE_SCALE[PAWN] = DE_SCALE[ROOK] = DE_SCALE[KNIGHT] = DE_SCALE[BISHOP] = 100;
+DE_SCALE[QUEEN] = DE_SCALE[KING] = 100;
+
 
 
 /* There are the values Sunsetter uses to measure pieces, the order is:
@@ -200,6 +237,8 @@ FILE *findFile(const char *name, const char *mode)
  *           for it to start
  */
 
+#ifndef SUNSETTER_LIBRARY	/* libsunsetter has no main loop */
+
 static void
 findZHGame()
 {
@@ -249,6 +288,36 @@ main(int argc, char **argv)
 		return 0;
 	}
 
+	if(argc > 1 && !strcmp(argv[1], "selfplay")) 
+	{    
+	/* If the first argument that Sunsetter is 
+		given is "selfplay" then play a match between
+		two parameter sets, see selfplay.cpp */
+		initialize();
+		selfplay(argc, argv);
+		return 0;
+	}
+
+	if(argc > 1 && !strcmp(argv[1], "tune")) 
+	{    
+	/* If the first argument that Sunsetter is 
+		given is "tune" then fit the eval parameters
+		to the games in the bpgn file, see tune.cpp */
+		initialize();
+		tune(argc, argv);
+		return 0;
+	}
+
+	if(argc > 1 && !strcmp(argv[1], "server")) 
+	{    
+	/* If the first argument that Sunsetter is 
+		given is "server" then play many games at
+		once, see server.cpp.  It initializes
+		Sunsetter itself, to drop what that prints */
+		server(argc, argv);
+		return 0;
+	}
+
 
 	initialize();
 
@@ -281,26 +350,21 @@ main(int argc, char **argv)
 				if(!m.isBad() && gameInProgress && !forceMode && !analyzeMode)
 				gameBoard.playMove(m, 1);
 			}
-			else if (currentRules == BUGHOUSE)
-			{
-				// no pondering in Bug at all  
-
-				millisecondsPerMove = 10000;
-				if (gameBoard.timeToMove() && (!toldparttosit) && (!partsitting)) {
-					toldparttosit =1;
-					output ("tellics ptell sit (my opponent is waiting for something)\n");
-				}
-				millisecondsPerMove = 100000000;
-			}		
 			else if (gameBoard.getMoveNum() != 1 && tryToPonder && !analyzeMode) 
 			{
 				ponder();
 			} 
+			else if (currentRules == BUGHOUSE)
+			{
+				watchOpponent();
+			}		
 		}
 
 #ifdef __EMSCRIPTEN__
         emscripten_sleep_with_yield(30);
 #else
+		flushOutput(1);
+
 		// sleep for 1/100th of a second, avoid hogging the cpu
 #ifdef _WIN32
 		Sleep(10);
@@ -312,6 +376,26 @@ main(int argc, char **argv)
     }
 }
 
+#endif // #ifndef SUNSETTER_LIBRARY
+
+/* Function: watchOpponent
+ * Input:    None.
+ * Output:   None.
+ * Purpose:  In bughouse, if our opponent thinks for 10 seconds he is 
+ *           probably waiting for a piece, so our partner should sit too.
+ *           Called by the main loop and by ponder().
+ */
+
+void watchOpponent()
+{
+	millisecondsPerMove = 10000;
+	if (gameBoard.timeToMove() && (!toldparttosit) && (!partsitting)) {
+		toldparttosit =1;
+		output ("tellics ptell sit (my opponent is waiting for something)\n");
+	}
+	millisecondsPerMove = 100000000;
+}
+
 /* Function: ReadIniFile
  * Input:    char * , the file name 
  * Output:   None.
@@ -353,12 +437,14 @@ void initialize()
 #endif
 
   output(clientLogin);
-  signal(SIGINT, SIG_IGN);
+#ifndef SUNSETTER_LIBRARY
+  signal(SIGINT, SIG_IGN);		/* The program we're linked into decides */
+#endif
   srand(time(NULL) + 2);
 
   setDefaultValues(); 
-  initBitboards();
   initializeEval(); 
+  initializeReductions(); 
   
 
   forceMode = 1;
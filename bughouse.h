@@ -18,29 +18,27 @@
 
 #define VERSION "7g"
 
-enum rules { BUGHOUSE, CRAZYHOUSE };
+extern SEARCH_LOCAL rules currentRules;  /* Are we playing crazyhouse or bug? */
 
-extern rules currentRules;  /* Are we playing crazyhouse or bug? */
+extern SEARCH_LOCAL int forceMode;		/* forceMode is 1 when Sunsetter isn't playing moves of it's own */
 
-extern int forceMode;		/* forceMode is 1 when Sunsetter isn't playing moves of it's own */
 
+extern SEARCH_LOCAL int sitting;         /* If Sunsetter is sitting */
 
-extern int sitting;         /* If Sunsetter is sitting */
+extern SEARCH_LOCAL int toldpartisit;	/* If we decided to sit on our own */
+extern SEARCH_LOCAL int toldparttosit;
+extern SEARCH_LOCAL int parttoldgo;
+extern SEARCH_LOCAL int partsitting;      /* If it told partner to sit  */
+extern SEARCH_LOCAL int psittinglong; 	 /* for how long our part has been sitting on his own */
 
-extern int toldpartisit;	/* If we decided to sit on our own */
-extern int toldparttosit;
-extern int parttoldgo;
-extern int partsitting;      /* If it told partner to sit  */
-extern int psittinglong; 	 /* for how long our part has been sitting on his own */
-
-extern long stats_overallsearches; /* Overall number of searches in one game, for testing */
-extern long stats_overallqsearches;
-extern long stats_overallticks;
+extern SEARCH_LOCAL long stats_overallsearches; /* Overall number of searches in one game, for testing */
+extern SEARCH_LOCAL long stats_overallqsearches;
+extern SEARCH_LOCAL long stats_overallticks;
 
 
 #ifdef DEBUG_STATS
-  extern long  stats_overallDebugA;
-  extern long  stats_overallDebugB;
+  extern SEARCH_LOCAL long  stats_overallDebugA;
+  extern SEARCH_LOCAL long  stats_overallDebugB;
 #endif
 
 #ifdef DEBUG_HASH
@@ -53,21 +51,27 @@ extern long stats_overallticks;
 
 
 extern int evaluation;
-extern int firstBigValue;
+extern SEARCH_LOCAL int firstBigValue;
 
 
-extern int gameInProgress;  /* If a game is going on */
+extern SEARCH_LOCAL int gameInProgress;  /* If a game is going on */
 
 extern int soughtGame;      /* Have we already sought crazyhouse games */
 
 void ReadIniFile(char *filename);
+void watchOpponent();
 
 void initialize();
 void setDefaultValues();
 int makeTranspositionTable(unsigned int size);
+extern char sharedHashName[];	/* See transposition.cpp */
+extern int sharedHashEngines;
 
 int testbpgn(int argc, char **argv);
 int speedtest(int argc, char **argv);
+int selfplay(int argc, char **argv);
+int tune(int argc, char **argv);
+int server(int argc, char **argv);
 
 
 // Those are already defined in some win32 library
@@ -27,72 +27,38 @@
 extern void fillMoveArray(move **m, square from, piece p,bitboard dest);
 
 /* 
- * Function: whitePawnCapturesTo
+ * Function: pawnCapturesTo
  * Input:    A pointer to and array of moves.
  * Output:   None.
  * Purpose:  Fills the array and increments the pointer to that array with
- *           whites's capures moves to a certain square.
+ *           C's capures moves to a certain square.
  *           This function is very specific.  It assumes it is passed a valid
- *           set of squares (ones that white can do captures on) and doesn't work
+ *           set of squares (ones that C can do captures on) and doesn't work
  *           if there is a promotion involved
  */
 
-void boardStruct::whitePawnCapturesTo(move **m, bitboard possibleTo)
+template <color C> void boardStruct::pawnCapturesTo(move **m, bitboard possibleTo)
    {
+   const int left = (C == WHITE) ? 7 : 9;
+   const int right = (C == WHITE) ? 9 : 7;
    bitboard to;
    square sq;
 
-   to = possibleTo & ((pieces[PAWN] & occupied[WHITE] & ~A_FILE) >> 7);
+   to = possibleTo & ((pieces[PAWN] & occupied[C] & ~A_FILE) >> left);
    while(to.hasBits()) 
       {
       sq = firstSquare(to.data);
       to.unsetSquare(sq);
-      *((*m)++) = move(sq + 7, sq, PAWN);
+      *((*m)++) = move(sq + left, sq, PAWN);
 
       }
 
-   to = possibleTo & ((pieces[PAWN] & occupied[WHITE] & ~H_FILE) << 9);
+   to = possibleTo & ((pieces[PAWN] & occupied[C] & ~H_FILE) << right);
    while(to.hasBits()) 
       {
       sq = firstSquare(to.data);
       to.unsetSquare(sq);
-      *((*m)++) = move(sq - 9, sq, PAWN);
-
-      }
-   }
-
-
-/* 
- * Function: blackPawnCapturesTo
- * Input:    A pointer to and array of moves moves.
- * Output:   None.
- * Purpose:  Fills the array and increments the pointer to that array with
- *           black's capures moves to a certain square.
- *           This function is very specific.  It assumes it is passed a valid
- *           set of squares (ones that black can captures on) and doesn't work
- *           if there is a promotion involved
- */
-
-void boardStruct::blackPawnCapturesTo(move **m, bitboard possibleTo)
-   {
-   bitboard to;
-   square sq;
-
-   to = possibleTo & ((pieces[PAWN] & occupied[BLACK] & ~A_FILE) >> 9);
-   while(to.hasBits()) 
-      {
-      sq = firstSquare(to.data);
-      to.unsetSquare(sq);
-      *((*m)++) = move(sq + 9, sq, PAWN);
-
-      }
-
-   to = possibleTo & ((pieces[PAWN] & occupied[BLACK] & ~H_FILE) << 7);
-   while(to.hasBits()) 
-      {
-      sq = firstSquare(to.data);
-      to.unsetSquare(sq);
-      *((*m)++) = move(sq - 7, sq, PAWN);
+      *((*m)++) = move(sq - right, sq, PAWN);
 
       }
    }
@@ -108,21 +74,22 @@ void boardStruct::blackPawnCapturesTo(move **m, bitboard possibleTo)
  *           fast.  Basically it generates a bitboard of possible captures 
  *           and ands them with what squares are occupied by the opponent.  
  *           The resulting bitboard represents the to squares.
+ *           C is the side to move.
  */
 
-int boardStruct::captureMoves(move *m)
+template <color C> int boardStruct::captureMoves(move *m)
    {
    move *original;
    square from;
    bitboard thePieces, oppOccupied, dest;
 
    original = m;
-   oppOccupied = occupied[otherColor(onMove)];
+   oppOccupied = occupied[otherColor(C)];
 
    /* Generate bishop/rook/queen captures bitboard by anding the attack bitboard
       with the square occupied by the opponent */
   
-   thePieces = pieces[BISHOP] & occupied[onMove];
+   thePieces = pieces[BISHOP] & occupied[C];
    while (thePieces.hasBits()) 
       {
       from = firstSquare(thePieces.data);
@@ -131,7 +98,7 @@ int boardStruct::captureMoves(move *m)
       fillMoveArray(&m, from, BISHOP, dest);
       }
 
-   thePieces = pieces[ROOK] & occupied[onMove];
+   thePieces = pieces[ROOK] & occupied[C];
    while (thePieces.hasBits()) 
       {
       from = firstSquare(thePieces.data);
@@ -140,7 +107,7 @@ int boardStruct::captureMoves(move *m)
       fillMoveArray(&m, from, ROOK, dest);
       }
 
-   thePieces = pieces[QUEEN] & occupied[onMove];
+   thePieces = pieces[QUEEN] & occupied[C];
    while (thePieces.hasBits()) 
       {
       from = firstSquare(thePieces.data);
@@ -152,7 +119,7 @@ int boardStruct::captureMoves(move *m)
    /* Generate the knight moves bitboard by using the lookup table and 
       anding it with the square occupied by the opponent */
 
-   thePieces = pieces[KNIGHT] & occupied[onMove];
+   thePieces = pieces[KNIGHT] & occupied[C];
    while (thePieces.hasBits()) 
       {
       from = firstSquare(thePieces.data);
@@ -163,34 +130,19 @@ int boardStruct::captureMoves(move *m)
 
    /* Generate pawn captures and promotions. */
 
-   if (onMove == WHITE) 
-      {
-      whitePawnMovesTo(&m, EIGHTH_RANK, QUEEN);
+   pawnMovesTo<C>(&m, lastRank<C>(), QUEEN);
 
-      if (enPassant != OFF_BOARD)                                       
-         whitePawnCapturesTo(&m, (occupied[BLACK] | qword(1) << enPassant) &
-			                     ~EIGHTH_RANK);
-      else
-         whitePawnCapturesTo(&m, occupied[BLACK] & ~EIGHTH_RANK);
+   if (enPassant != OFF_BOARD)                                       
+      pawnCapturesTo<C>(&m, (oppOccupied | qword(1) << enPassant) &
+                            ~lastRank<C>());
+   else
+      pawnCapturesTo<C>(&m, oppOccupied & ~lastRank<C>());
 
-      whitePawnMovesTo(&m, EIGHTH_RANK, KNIGHT);
-      }
-   else 
-      {  
-      blackPawnMovesTo(&m, FIRST_RANK, QUEEN);
-
-      if (enPassant != OFF_BOARD)
-         blackPawnCapturesTo(&m, (occupied[WHITE] | qword(1) << enPassant) & 
-			                    ~FIRST_RANK);
-      else
-         blackPawnCapturesTo(&m, occupied[WHITE] & ~FIRST_RANK);
-
-      blackPawnMovesTo(&m, FIRST_RANK, KNIGHT);
-      }  
+   pawnMovesTo<C>(&m, lastRank<C>(), KNIGHT);
     
    /* Get king moves. */
 
-   from = kingSquare[onMove];
+   from = kingSquare[C];
    dest = kingAttacks[from] & oppOccupied;
    fillMoveArray(&m, from, KING, dest);
    m->makeBad();
@@ -198,6 +150,20 @@ int boardStruct::captureMoves(move *m)
    }
 
 
+/* 
+ * Function: captureMoves
+ * Input:    An array to fill with moves
+ * Output:   The number of moves generated.
+ * Purpose:  Calls captureMoves<C>() for the side to move.
+ */
+
+int boardStruct::captureMoves(move *m)
+   {
+   if (onMove == WHITE) return captureMoves<WHITE>(m);
+   return captureMoves<BLACK>(m);
+   }
+
+
 /* 
  * Function: captureGain
  * Input:    A color and A move
@@ -205,6 +171,9 @@ int boardStruct::captureMoves(move *m)
  * Purpose:  Used to see how good a capture is.  It trades off all of the
  *           attackers including the x-ray attackers (pieces that can capture
  *           as soon as one of the other attackers moves out of their way).
+ *           If attacks[][] shows that nothing defends the square, and nothing
+ *           x-rays through the capturing piece, the gain is just the piece
+ *           captured and the exchange is not played out.
  */
 
 int boardStruct::captureGain(color c, move m)
@@ -219,6 +188,17 @@ int boardStruct::captureGain(color c, move m)
    count = 1;
    to = m.to();
    from = m.from();
+
+   /* An undefended piece is simply won.  A piece x-raying through from
+      would attack from itself, so the attacks[][] count on from covers
+      that. */
+
+   if (!this->attacks[otherColor(c)][to] && 
+	   ((directionPiece[from][to] == NONE) || !this->attacks[otherColor(c)][from]))
+      {
+      return pValue[position[to]];
+      }
+
    attacks = attacksTo(to);
   
    /* Step 2: Make the first capture and add the new attackers from x-ray
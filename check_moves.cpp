@@ -6,6 +6,8 @@
  *  Name: check_moves.cc                                                     *
  *  Purpose: Has checkEvasionMoves() which is used to generate moves to get  *
  *  out of check. Note that this does not generate only legal moves !        *
+ *  Also has the check info functions, which tell if a move gives check     *
+ *  without making it and generate the checks that aren't captures.         *
  *                                                                           *
  *************************************************************************** */
 
@@ -208,15 +210,15 @@ int boardStruct::checkEvasionOthers(move *m)
     
       if (onMove == WHITE) 
          {
-         whitePawnMovesTo(&m, possibleTo & ~EIGHTH_RANK, NONE);
-         whitePawnMovesTo(&m, possibleTo & EIGHTH_RANK, QUEEN);
-         whitePawnMovesTo(&m, possibleTo & EIGHTH_RANK, KNIGHT);
+         pawnMovesTo<WHITE>(&m, possibleTo & ~EIGHTH_RANK, NONE);
+         pawnMovesTo<WHITE>(&m, possibleTo & EIGHTH_RANK, QUEEN);
+         pawnMovesTo<WHITE>(&m, possibleTo & EIGHTH_RANK, KNIGHT);
          } 
       else 
          {
-         blackPawnMovesTo(&m, possibleTo & ~FIRST_RANK, NONE);
-         blackPawnMovesTo(&m, possibleTo & FIRST_RANK, QUEEN);
-         blackPawnMovesTo(&m, possibleTo & FIRST_RANK, KNIGHT);
+         pawnMovesTo<BLACK>(&m, possibleTo & ~FIRST_RANK, NONE);
+         pawnMovesTo<BLACK>(&m, possibleTo & FIRST_RANK, QUEEN);
+         pawnMovesTo<BLACK>(&m, possibleTo & FIRST_RANK, KNIGHT);
          }
 
       /* See if a piece can be dropped between the check.  This is every
@@ -253,3 +255,171 @@ int boardStruct::checkEvasionOthers(move *m)
    return m - original;
 }
 
+
+/* 
+ * Function: setCheckInfo
+ * Input:    The checkInfo to fill
+ * Output:   None
+ * Purpose:  Finds the squares from where each piece of the side to move
+ *           would check the other king, and the pieces that give a
+ *           discovered check when they move off the line to that king.
+ */
+
+void boardStruct::setCheckInfo(checkInfo *ci)
+{
+   square ks;
+
+   ks = kingSquare[otherColor(onMove)];
+   ci->kingSquare = ks;
+
+   ci->checkSquares[NONE] = qword(0);
+   ci->checkSquares[PAWN] = pawnAttacksFrom(otherColor(onMove), ks);
+   ci->checkSquares[KNIGHT] = knightAttacks[ks];
+   ci->checkSquares[BISHOP] = attacksFrom(BISHOP, ks);
+   ci->checkSquares[ROOK] = attacksFrom(ROOK, ks);
+   ci->checkSquares[QUEEN] = ci->checkSquares[BISHOP] | ci->checkSquares[ROOK];
+   ci->checkSquares[KING] = qword(0);
+
+   ci->discovered = lineBlockers(ks, onMove, onMove);
+}
+
+
+/* 
+ * Function: givesCheck
+ * Input:    A move and the checkInfo of the position
+ * Output:   Whether the move checks the other king.
+ * Purpose:  Used by the search to find checks without making the move.
+ *           Castling, promotions and en passant move more than one piece,
+ *           those are made and taken back.
+ */
+
+int boardStruct::givesCheck(move m, checkInfo *ci)
+{
+   square from, to;
+   piece p;
+   int check;
+
+   from = m.from();
+   to = m.to();
+   p = m.moved();
+
+   if (m.promotion() != NONE || (p == PAWN && to == enPassant && from != IN_HAND) ||
+       (p == KING && !kingAttacks[from].squareIsSet(to)))
+      {
+      changeBoard(m);
+      check = isInCheck(onMove);
+      unchangeBoard();
+      return check != 0;
+      }
+
+   if (ci->checkSquares[p].squareIsSet(to)) 
+      return 1;
+
+   if (from != IN_HAND && ci->discovered.squareIsSet(from) &&
+       !(squaresTo[ci->kingSquare][from] | squaresPast[ci->kingSquare][from]).squareIsSet(to))
+      return 1;
+
+   return 0;
+}
+
+
+/* 
+ * Function: checkingMoves
+ * Input:    An array to fill with moves and the checkInfo of the position
+ * Output:   The number of moves generated.
+ * Purpose:  Generates the checks that aren't captures: piece moves and drops
+ *           to the check squares and moves of the discovered check pieces
+ *           off their line.  Like aiMoves() it doesn't look at the own 
+ *           king, and it leaves out castling and promotions.
+ *           C is the side to move.
+ */
+
+template <color C> int boardStruct::checkingMoves(move *m, checkInfo *ci)
+{
+   move *original;
+   square sq, ks;
+   piece p;
+   bitboard thePieces, dest, dest2, unoccupied;
+
+   original = m;
+   ks = ci->kingSquare;
+   unoccupied = ~(occupied[WHITE] | occupied[BLACK]);
+
+   /* Pieces, moving to a check square or off the line to the king */
+
+   for (p = ROOK; p <= QUEEN; p = (piece) (p + 1)) 
+      {
+      thePieces = pieces[p] & occupied[C];
+      while (thePieces.hasBits()) 
+         {
+         sq = firstSquare(thePieces.data);
+         thePieces.unsetSquare(sq);
+         dest = ci->checkSquares[p];
+         if (ci->discovered.squareIsSet(sq))
+            dest |= ~(squaresTo[ks][sq] | squaresPast[ks][sq]);
+         dest &= attacksFrom(p, sq) & unoccupied;
+         fillMoveArray(&m, sq, p, dest);
+         }
+      }
+
+   /* Pawn pushes, the same ones aiMoves() generates */
+
+   dest = forward<C>(pieces[PAWN] & occupied[C]) & unoccupied;
+   dest2 = forward<C>(dest) & unoccupied & doublePushRank<C>();
+   dest &= ~lastRank<C>();
+
+   while (dest.hasBits()) 
+      {
+      sq = firstSquare(dest.data);
+      dest.unsetSquare(sq);
+      if (givesCheck(move(sq - pawnPush<C>(), sq, PAWN), ci))
+         *(m++) = move(sq - pawnPush<C>(), sq, PAWN);
+      }
+
+   while (dest2.hasBits()) 
+      {
+      sq = firstSquare(dest2.data);
+      dest2.unsetSquare(sq);
+      if (givesCheck(move(sq - 2 * pawnPush<C>(), sq, PAWN), ci))
+         *(m++) = move(sq - 2 * pawnPush<C>(), sq, PAWN);
+      }
+
+   /* The king can only give a discovered check */
+
+   sq = kingSquare[C];
+   if (ci->discovered.squareIsSet(sq)) 
+      {
+      dest = kingAttacks[sq] & unoccupied & ~(squaresTo[ks][sq] | squaresPast[ks][sq]);
+      fillMoveArray(&m, sq, KING, dest);
+      }
+
+   /* Drops to the check squares */
+
+   if (hand[C][PAWN]) 
+      fillMoveArray(&m, IN_HAND, PAWN, ci->checkSquares[PAWN] & unoccupied & 
+                    ~(FIRST_RANK | EIGHTH_RANK));
+
+   for (p = ROOK; p <= QUEEN; p = (piece) (p + 1)) 
+      {
+      if (hand[C][p]) 
+         fillMoveArray(&m, IN_HAND, p, ci->checkSquares[p] & unoccupied);
+      }
+
+   m->makeBad();
+   return m - original;
+}
+
+
+/* 
+ * Function: checkingMoves
+ * Input:    An array to fill with moves and the checkInfo of the position
+ * Output:   The number of moves generated.
+ * Purpose:  Calls checkingMoves<C>() for the side to move.
+ */
+
+int boardStruct::checkingMoves(move *m, checkInfo *ci)
+{
+   if (onMove == WHITE) return checkingMoves<WHITE>(m, ci);
+   return checkingMoves<BLACK>(m, ci);
+}
+
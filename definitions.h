@@ -37,5 +37,28 @@ typedef signed int sdword;
 	#define qword(target) (unsigned long long)(target##ULL)
 #endif
 
+/* Lets the compiler fill in the tables of tables.cpp, older ones do it
+   when the program starts */
+
+#if (__cplusplus >= 201103L) || (defined(_MSC_VER) && (_MSC_VER >= 1900))
+#define CONSTEXPR constexpr
+#else
+#define CONSTEXPR
+#endif
+
+/* What a search works with.  libsunsetter and the server search in more 
+   than one thread, so every thread has its own.  Older compilers have 
+   one search for the process */
+
+#if (__cplusplus >= 201103L) || (defined(_MSC_VER) && (_MSC_VER >= 1900))
+#define SEARCH_LOCAL thread_local
+#else
+#define SEARCH_LOCAL
+#endif
+
+/* The variant being played.  The search is instantiated once for each */
+
+enum rules { BUGHOUSE, CRAZYHOUSE };
+
 
 #endif
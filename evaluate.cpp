@@ -15,9 +15,10 @@
 
 
 #include <stdlib.h>
+#include <string.h>
 #include "brain.h"
 #include "board.h"
-#include "evaluate.h"
+#include "nnue.h"
 
 
 
@@ -25,6 +26,8 @@
 
 int DevelopmentTable[COLORS][PIECES][SQUARES];
 
+SEARCH_LOCAL materialEntry materialTable[MATERIAL_TABLE_SIZE];
+
 
 /* Function: boardControlEval
  * Input:    None.
@@ -50,12 +53,12 @@ return (control * BC_FACTOR);
 }
 
 /* Function: kingSafetyEval
- * Input:    the color to compute King Safety for.
+ * Input:    the color C to compute King Safety for.
  * Output:   int
  * Purpose:  Returns the King Safety part of the evaluation
  */
 
-int boardStruct::kingSafetyEval(color c)
+template <color C> int boardStruct::kingSafetyEval()
 {
 
 	int escapeSquares = 0;
@@ -63,7 +66,7 @@ int boardStruct::kingSafetyEval(color c)
 
 	int sqcontrol;
 	square sq; 
-	bitboard nearKing = nearSquares[kingSquare[c]][c];  
+	bitboard nearKing = nearSquares[kingSquare[C]][C];  
 
 
 	while (nearKing.hasBits())
@@ -72,20 +75,20 @@ int boardStruct::kingSafetyEval(color c)
 			sq = firstSquare(nearKing.data);
 			nearKing.unsetSquare(sq);  
 
-			sqcontrol = attacks[otherColor(c)][sq] - attacks[c][sq]; 
+			sqcontrol = attacks[otherColor(C)][sq] - attacks[C][sq]; 
 		
 			// Squares we attack more then opp near opps king (excluding his king)
 			// or that are empty and as often defended as attacked  
 
 			if ((position[sq] == NONE) && (sqcontrol > -1) ) takeSquares += ( sqcontrol + 2) + takeSquares / 4;
 			else if (sqcontrol > -1) takeSquares += ( sqcontrol + 1) + takeSquares / 4;
-			else if ((sqcontrol == -1) && (position[sq] == NONE) && (DevelopmentTable[c][KING][sq] + 10 < DevelopmentTable[c][KING][kingSquare[c]]))
+			else if ((sqcontrol == -1) && (position[sq] == NONE) && (DevelopmentTable[C][KING][sq] + 10 < DevelopmentTable[C][KING][kingSquare[C]]))
 				takeSquares += ( sqcontrol + 2) + takeSquares / 4;
 			
 			// Bonus for escape squares near our own king 
 			// squares that are defended by us and not attacked by opp	
 			
-			if ((!attacks[otherColor(c)][sq]) && (attacks[c][sq] > 1) && (position[sq] == NONE)) escapeSquares+= attacks[c][sq]; 
+			if ((!attacks[otherColor(C)][sq]) && (attacks[C][sq] > 1) && (position[sq] == NONE)) escapeSquares+= attacks[C][sq]; 
 			// 2 for a normal one, 3 for a better protected one, 4 will be seldom
 			
 		}
@@ -97,6 +100,11 @@ int boardStruct::kingSafetyEval(color c)
 
 }
 
+/* board.cpp reports the king safety too */
+
+template int boardStruct::kingSafetyEval<WHITE>();
+template int boardStruct::kingSafetyEval<BLACK>();
+
 #ifdef GAMETREE
 
 
@@ -183,20 +191,42 @@ int boardStruct::getPieceDevOnSquare(color c, square sq, piece p)
 /* Function: eval
  * Input:    None.
  * Output:   The value of the position.
- * Purpose:  Returns a static evaluation of the position
+ * Purpose:  Returns a static evaluation of the position, for callers
+ *           outside the search which don't know what variant is played.
  */
 
 int boardStruct::eval()
 
 {
+  if (currentRules == CRAZYHOUSE) return eval<CRAZYHOUSE>();
+  return eval<BUGHOUSE>();
+}
+
+
+/* Function: eval<R>
+ * Input:    None.
+ * Output:   The value of the position.
+ * Purpose:  Returns a static evaluation of the position for variant R
+ */
+
+template <rules R> int boardStruct::eval()
+
+{
+  materialEntry *me;
+
+  /* The network only knows crazyhouse */
+
+  if (R == CRAZYHOUSE && nnueActive) return nnueEval();
+
+  me = probeMaterial();
 
   if (onMove == WHITE) // it is whites turn NOW. 
   {
-    return( material   +  development + boardControlEval() - kingSafetyEval(WHITE) * getMaterialInHand(BLACK)+ kingSafetyEval(BLACK) * getMaterialInHand(WHITE) + bughouseSitForEval());
+    return( material   +  development + boardControlEval() - kingSafetyEval<WHITE>() * me->pressure[BLACK]+ kingSafetyEval<BLACK>() * me->pressure[WHITE] + bughouseSitForEval<R>());
   }
   else // blacks turn
   { 
-    return( -( material + development  + boardControlEval() - kingSafetyEval(WHITE) * getMaterialInHand(BLACK)+ kingSafetyEval(BLACK) * getMaterialInHand(WHITE)+ bughouseSitForEval()));
+    return( -( material + development  + boardControlEval() - kingSafetyEval<WHITE>() * me->pressure[BLACK]+ kingSafetyEval<BLACK>() * me->pressure[WHITE]+ bughouseSitForEval<R>()));
   }
 
  
@@ -209,19 +239,12 @@ int boardStruct::eval()
  *				does not have to wait for a piece. 
  */
 
-int boardStruct::bughouseMateEval()
+template <rules R> int boardStruct::bughouseMateEval()
 
 { 
-  if ((currentRules == CRAZYHOUSE) || (partsitting) || (parttoldgo)) return 0; 
-  
-  int bieval = 0;
-  
-  if (getPieceInHand(OFF_MOVE, ROOK) < 1 ) bieval+=pValue[ROOK];
-  if (getPieceInHand(OFF_MOVE, KNIGHT) < 1 ) bieval+=pValue[KNIGHT];
-  if (getPieceInHand(OFF_MOVE, PAWN) < 1 ) bieval+=pValue[PAWN];
+  if ((R == CRAZYHOUSE) || (partsitting) || (parttoldgo)) return 0; 
   
-
-  return (bieval);
+  return (probeMaterial()->sitMalus[OFF_MOVE]);
 }
 
 
@@ -230,27 +253,27 @@ int boardStruct::bughouseMateEval()
  * Output: A Value, the Malus for Pieces used we would have to wait for in bughouse
  */
  
-int boardStruct::bughouseSitForEval()
+template <rules R> int boardStruct::bughouseSitForEval()
 
 { 
 
-  if ((currentRules == CRAZYHOUSE) || (partsitting) || (parttoldgo)) return 0;
-	
-  int bpeval = 0;   
-  
-  if (getPieceInHand(BLACK, ROOK) < 1 ) bpeval+=pValue[ROOK];
-  if (getPieceInHand(WHITE, ROOK) < 1 ) bpeval-=pValue[ROOK];
+  if ((R == CRAZYHOUSE) || (partsitting) || (parttoldgo)) return 0;
 	
-  if (getPieceInHand(BLACK, KNIGHT) < 1 ) bpeval+=pValue[KNIGHT];
-  if (getPieceInHand(WHITE, KNIGHT) < 1 ) bpeval-=pValue[KNIGHT];
+  materialEntry *me = probeMaterial();
 
-  if (getPieceInHand(BLACK, PAWN) < 1 ) bpeval+=pValue[PAWN];
-  if (getPieceInHand(WHITE, PAWN) < 1 ) bpeval-=pValue[PAWN];
-
-  return (bpeval);
+  return (me->sitMalus[BLACK] - me->sitMalus[WHITE]);
 }
 
 
+/* The search in search.cpp and quiescense.cpp is instantiated for both
+   variants, so make the variant versions of eval here */
+
+template int boardStruct::eval<BUGHOUSE>();
+template int boardStruct::eval<CRAZYHOUSE>();
+template int boardStruct::bughouseMateEval<BUGHOUSE>();
+template int boardStruct::bughouseMateEval<CRAZYHOUSE>();
+
+
 
 /* Function: getMaterialInHand
  * Input: Color
@@ -261,19 +284,50 @@ int boardStruct::bughouseSitForEval()
 int boardStruct::getMaterialInHand(color c)
 
 {
-int mInHand = 0;
-piece p;
+	return probeMaterial()->pressure[c];
+}
+
+
+/* Function: probeMaterial
+ * Input:    None.
+ * Output:   The material table entry for the hands of this position.
+ * Purpose:  The hand pressure and the bughouse sit malus only depend on
+ *           what is in the hands, so they are computed once for every
+ *           combination of hands and then looked up by handKey. 
+ */
+
+materialEntry *boardStruct::probeMaterial()
 
-for (p=FIRST_PIECE; p <= LAST_PIECE; p = (piece)(p + 1) ) 
 {
-	mInHand+= (pValue[p]* hand[c][p]);
-}
+	materialEntry *me = &materialTable[handKey & (MATERIAL_TABLE_SIZE - 1)];
+	color c;
+	piece p;
+	int mInHand;
 
-mInHand /= 80;
-mInHand += 2; 
+	if (me->filled && me->key == handKey) return me;
 
-return min(12, mInHand );
+	for (c = WHITE; c <= BLACK; c = (color) (c + 1))
+	{
+		mInHand = 0;
+		for (p=FIRST_PIECE; p <= LAST_PIECE; p = (piece)(p + 1) ) 
+		{
+			mInHand+= (pValue[p]* hand[c][p]);
+		}
+
+		mInHand /= 80;
+		mInHand += 2; 
+		me->pressure[c] = min(12, mInHand );
+
+		me->sitMalus[c] = 0;
+		if (hand[c][ROOK] < 1 ) me->sitMalus[c] += pValue[ROOK];
+		if (hand[c][KNIGHT] < 1 ) me->sitMalus[c] += pValue[KNIGHT];
+		if (hand[c][PAWN] < 1 ) me->sitMalus[c] += pValue[PAWN];
+	}
+
+	me->key = handKey;
+	me->filled = 1;
 
+	return me;
 }
 
 /* Function: highestAttacked
@@ -291,14 +345,14 @@ int boardStruct::highestAttacked(square moveTo)
 {
 	square sq;
 	
-	if (takeBackHistory[moveNum-1].captured != NONE) return 1;
+	if (history[moveNum-1].takeBack.captured != NONE) return 1;
 	// captured something
 		
 	if ((attacks[onMove][moveTo] > attacks[OFF_MOVE][moveTo])
 		|| ((position[moveTo] == QUEEN) && (attacks[onMove][moveTo]) )) return 0;
 	// piece is probably en prise there 
 	
-	bitboard bb = ( moveAttackedSomething[moveNum] & occupied[onMove] );
+	bitboard bb = ( history[moveNum].attackedSomething & occupied[onMove] );
 	while (bb.hasBits())
 	{
 		sq = firstSquare(bb.data);
@@ -306,11 +360,11 @@ int boardStruct::highestAttacked(square moveTo)
 
 		if ((!attacks[onMove][sq]) 
 			&& (attacks[OFF_MOVE][sq] == 1) 
-			&& (pValue[position[sq]] > bestCaptureGain[moveNum-1] + 20))
+			&& (pValue[position[sq]] > history[moveNum-1].bestCaptureGain + 20))
 			return 1;
 		// we just attacked an undefended piece the first time
 
-		if ((pValue[position[sq]] > pValue[position[moveTo]] + bestCaptureGain[moveNum-1] + 20))
+		if ((pValue[position[sq]] > pValue[position[moveTo]] + history[moveNum-1].bestCaptureGain + 20))
 			return 1;
 		// we just attacked a piece more than it was defended
 
@@ -332,7 +386,8 @@ int boardStruct::escapingAttack(square movedFrom, square moveTo)
 	bitboard bb;
 	square sq;
 	
-	if ( (moveAttackedSomething[moveNum-1].squareIsSet(movedFrom) )
+	if ( movedFrom != IN_HAND
+		&& (history[moveNum-1].attackedSomething.squareIsSet(movedFrom) )
 		&& ((attacks[onMove][movedFrom]-attacks[OFF_MOVE][movedFrom]) 
 		>= (attacks[onMove][moveTo]-attacks[OFF_MOVE][moveTo]))) 
 		return 1; 
@@ -342,7 +397,7 @@ int boardStruct::escapingAttack(square movedFrom, square moveTo)
 	// that defendet mine, to move mine away !
 	
 
-	bb = ( moveAttackedSomething[moveNum-1] & moveAttackedSomething[moveNum] & occupied[OFF_MOVE] );
+	bb = ( history[moveNum-1].attackedSomething & history[moveNum].attackedSomething & occupied[OFF_MOVE] );
 	if (bb.hasBits() 
 		&& (!attacks[onMove][moveTo]))
 	{
@@ -353,7 +408,7 @@ int boardStruct::escapingAttack(square movedFrom, square moveTo)
 		
 		if ( (attacks[OFF_MOVE][sq] == 1) 
 			&& (attacks[onMove][sq] == 1) 
-			&& (pValue[position[sq]] + 20 < pValue[moveHistory[moveNum-1].moved()]))		
+			&& (pValue[position[sq]] + 20 < pValue[history[moveNum-1].played.moved()]))		
 			return 1;
 		
 		}
@@ -377,10 +432,10 @@ int boardStruct::captureExtensionCondition()
 {
 
 
-	if (	(takeBackHistory[moveNum-1].captured != NONE) && 
-			(moveHistory[moveNum-2].to() == moveHistory[moveNum-1].to())  &&
-			( (! attacks[OFF_MOVE][moveHistory[moveNum-1].to()]) ||
-			(checkHistory[moveNum-1] && takeBackHistory[moveNum-2].captured != NONE) ) ) 
+	if (	(history[moveNum-1].takeBack.captured != NONE) && 
+			(history[moveNum-2].played.to() == history[moveNum-1].played.to())  &&
+			( (! attacks[OFF_MOVE][history[moveNum-1].played.to()]) ||
+			(history[moveNum-1].check && history[moveNum-2].takeBack.captured != NONE) ) ) 
 			 return 1;
 
 
@@ -401,8 +456,8 @@ int boardStruct::standpatCondition()
 {
 
 
-	if ((moveHistory[moveNum-1].to() != moveHistory[moveNum-2].to()) || 
-		(pValue[takeBackHistory[moveNum-2].captured] > pValue[takeBackHistory[moveNum-1].captured] - 50 ))
+	if ((history[moveNum-1].played.to() != history[moveNum-2].played.to()) || 
+		(pValue[history[moveNum-2].takeBack.captured] > pValue[history[moveNum-1].takeBack.captured] - 50 ))
 			return 1; 
 
 	return 0;
@@ -410,66 +465,52 @@ int boardStruct::standpatCondition()
 }
 
 
-/* Function: initializeEval
+/* Function: futilityCondition
  * Input:    None
- * Output:   None
- * Purpose:  Sets up the tables that eval() uses.
+ * Output:   int
+ * Purpose:  Tells me whether the static eval can be trusted for futility
+ *           pruning. With a king under attack one drop changes the eval by
+ *           much more than the margin.
  */
 
 
-void initializeEval() 
-{
-
-int sq;
-
-for(sq = 0; sq < SQUARES; sq++) 
+int boardStruct::futilityCondition() 
 {
 
-    DevelopmentTable[BLACK][KING][(sq / 8) * ONE_RANK + (sq % 8) * ONE_FILE] =
-      (kingDevelopmentTable[sq]*DE_FACTOR);
-		
-		
-	DevelopmentTable[BLACK][PAWN][(sq / 8) * ONE_RANK + (sq % 8) * ONE_FILE] =
-     (pawnDevelopmentTable[sq]* DE_FACTOR);
-
+	if ((kingSafetyEval<WHITE>() * getMaterialInHand(BLACK) > FUTILITY_KING_DANGER) ||
+		(kingSafetyEval<BLACK>() * getMaterialInHand(WHITE) > FUTILITY_KING_DANGER))
+			return 0;
 
-    DevelopmentTable[BLACK][BISHOP][(sq / 8) * ONE_RANK + (sq % 8) * ONE_FILE] =
-      (bishopDevelopmentTable[sq]* DE_FACTOR);
+	return 1;
 
-
-    DevelopmentTable[BLACK][ROOK][(sq / 8) * ONE_RANK + (sq % 8) * ONE_FILE] =
-      (rookDevelopmentTable[sq]* DE_FACTOR);
-
-
-    DevelopmentTable[BLACK][KNIGHT][(sq / 8) * ONE_RANK + (sq % 8) * ONE_FILE] =
-     (knightDevelopmentTable[sq]* DE_FACTOR);
-
-
-    DevelopmentTable[BLACK][QUEEN][(sq / 8) * ONE_RANK + (sq % 8) * ONE_FILE] =
-      (queenDevelopmentTable[sq]* DE_FACTOR);
+}
 
 
-	/* Same for white */
+/* Function: initializeEval
+ * Input:    None
+ * Output:   None
+ * Purpose:  Sets up the tables that eval() uses.
+ */
 
-	DevelopmentTable[WHITE][KING][(7- sq / 8) * ONE_RANK + (sq % 8) * ONE_FILE]=
-      (kingDevelopmentTable[sq]*DE_FACTOR);
 
-	DevelopmentTable[WHITE][PAWN][(7- sq / 8) * ONE_RANK + (sq % 8) * ONE_FILE]=
-      (pawnDevelopmentTable[sq]* DE_FACTOR);
+void initializeEval() 
+{
 
-	DevelopmentTable[WHITE][BISHOP][(7- sq / 8) * ONE_RANK + (sq % 8) * ONE_FILE]=
-      (bishopDevelopmentTable[sq]* DE_FACTOR);
+int sq;
+color c;
+piece p;
 
-	DevelopmentTable[WHITE][ROOK][(7- sq / 8) * ONE_RANK + (sq % 8) * ONE_FILE]=
-      (rookDevelopmentTable[sq]* DE_FACTOR);
+/* The material table depends on the piece values */
 
-	DevelopmentTable[WHITE][KNIGHT][(7- sq / 8) * ONE_RANK + (sq % 8) * ONE_FILE]=
-     (knightDevelopmentTable[sq]* DE_FACTOR);
+memset(materialTable, 0, sizeof(materialTable));
 
-	DevelopmentTable[WHITE][QUEEN][(7- sq / 8) * ONE_RANK + (sq % 8) * ONE_FILE] =
-      (queenDevelopmentTable[sq]* DE_FACTOR);
+/* The development tables of evaluate.h are in BaseDevelopmentTable for
+   both colors already, see gentables.cpp */
 
- 
-}
+for(c = FIRST_COLOR; c <= LAST_COLOR; c++)
+  for(p = FIRST_PIECE; p <= LAST_PIECE; p++)
+    for(sq = 0; sq < SQUARES; sq++)
+      DevelopmentTable[c][p][sq] = 
+        BaseDevelopmentTable[c][p][sq] * DE_FACTOR * DE_SCALE[p] / 100;
 
 }
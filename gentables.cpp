@@ -0,0 +1,893 @@
+/* ***************************************************************************
+ *                                Sunsetter                                  *
+ *               (c) Ben Dean-Kawamura, Georg v. Zimmermann                  *
+ *   For license terms, see the file COPYING that came with this program.    *
+ *                                                                           *
+ *  Name: gentables.cpp                                                      *
+ *  Purpose: Writes tables.cpp, the tables Sunsetter looks things up in.     *
+ *                                                                           *
+ *  Comments: It's a program of its own that the Makefile builds and runs    *
+ *            with "gentables tables.cpp" before Sunsetter is compiled.  It  *
+ *            fills in the tables marked TABLE in board.h and brain.h the    *
+ *            way Sunsetter did when it started, and writes them as const    *
+ *            arrays.  They are in the read only data of the program then,   *
+ *            shared by all Sunsetter processes and only read in from the    *
+ *            file when they're used.                                        *
+ *                                                                           *
+ *            The attack tables, the hash numbers and the development tables *
+ *            are made here, so this is the file to change them in.  The     *
+ *            hash numbers must stay the same or the learn files don't work. *
+ *                                                                           *
+ *************************************************************************** */
+
+#define GENERATING_TABLES
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "board.h"
+#include "brain.h"
+#include "evaluate.h"
+
+/* following are lots of arrays for bitboards.  They contain information that
+   can be calculated beforehand and so when the value is needed durring a
+   search all that as to be done is an index to the array.  */
+
+/* a bitboard where just the one bit is set */
+
+qword BitInBB[SQUARES]; 
+
+
+/* Attacks is an array of bitboards of where a short range piece attacks from 
+   each square */
+
+bitboard pawnAttacks[COLORS][SQUARES];
+bitboard contactBishopAttacks[SQUARES];
+bitboard contactRookAttacks[SQUARES];
+bitboard knightAttacks[SQUARES];
+bitboard kingAttacks[SQUARES];
+
+/* squaresTo gives the squares in between the first square and the second
+   square, including the second square (if the squares are a knight move apart
+   then just the second square).  It's used to see what squares a
+   player can block or capture to get out of check with */
+
+bitboard squaresTo[SQUARES][SQUARES];
+
+/* nearSquares are squares 2 or less squares away */
+
+bitboard nearSquares[SQUARES][COLORS];
+
+/* directionPiece either a bishop, rook or none for the piece that can
+   move along a line from one one square to the next. */
+
+piece directionPiece[SQUARES][SQUARES];
+
+/* squaresPast is the squares are after the second square, on the same
+   line as the first */
+
+bitboard squaresPast[SQUARES][SQUARES];
+
+/* urShift and ulShift are to help with the diagonal bitboards.  The square on
+   the up-right diagonal bitboard that corresponds to a normal bitboard is
+   found by indexing urShift.  So square 5 (a6) on a normal bitboard is 24 on
+   the up-right diagonal bitboard (ulShift[5]).  The order of the squares is
+   kind of funky, the only things that are important are that squares of
+   diagonals have adjacent bits and that the 32 bit is the end of one diagonal
+   (so that no diagonals cross 32 bit boundaries and optimizations can be
+   used). */
+
+int ulShift[SQUARES] = 
+   {  
+    0,  2,  5, 13, 18, 24, 31, 39,
+    1,  4, 12, 17, 23, 30, 38, 46,
+    3, 11, 16, 22, 29, 37, 45, 52,
+   10, 15, 21, 28, 36, 44, 51, 57,
+   14, 20, 27, 35, 43, 50, 56,  9,
+   19, 26, 34, 42, 49, 55,  8, 60,
+   25, 33, 41, 48, 54,  7, 59, 62,
+   32, 40, 47, 53,  6, 58, 61, 63 
+   };
+
+int urShift[SQUARES] = 
+   {
+   32, 40, 47, 53,  6, 58, 61, 63,
+   25, 33, 41, 48, 54,  7, 59, 62,
+   19, 26, 34, 42, 49, 55,  8, 60,
+   14, 20, 27, 35, 43, 50, 56,  9,
+   10, 15, 21, 28, 36, 44, 51, 57,
+    3, 11, 16, 22, 29, 37, 45, 52,
+    1,  4, 12, 17, 23, 30, 38, 46,
+    0,  2,  5, 13, 18, 24, 31, 39 
+   };
+
+/* urDiagShift and ulDiagShift are to help with the diagonal bitboards.
+   To get the diagonal of a square on the lowest bits of a bitboard, right 
+   shift it by the amout in the array indexed at the square */
+
+int ulDiagShift[SQUARES] = 
+   {
+    0,  1,  3, 10, 14, 19, 25, 32,
+    1,  3, 10, 14, 19, 25, 32, 40,
+    3, 10, 14, 19, 25, 32, 40, 47,
+   10, 14, 19, 25, 32, 40, 47, 53,
+   14, 19, 25, 32, 40, 47, 53,  6,
+   19, 25, 32, 40, 47, 53,  6, 58,
+   25, 32, 40, 47, 53,  6, 58, 61,
+   32, 40, 47, 53,  6, 58, 61, 63
+   };
+
+int urDiagShift[SQUARES] = 
+   {
+   32, 40, 47, 53,  6, 58, 61, 63,
+   25, 32, 40, 47, 53,  6, 58, 61,
+   19, 25, 32, 40, 47, 53,  6, 58,
+   14, 19, 25, 32, 40, 47, 53,  6,
+   10, 14, 19, 25, 32, 40, 47, 53,
+    3, 10, 14, 19, 25, 32, 40, 47,
+    1,  3, 10, 14, 19, 25, 32, 40,
+    0,  1,  3, 10, 14, 19, 25, 32
+   };
+
+
+
+/* *AttacksArray[square][info_on_a_line] gives where a piece can attacks on a line
+   based on where the piece is on the board, and what squares are occupied
+   along the line */
+
+bitboard rankAttacksArray[SQUARES][256];
+bitboard fileAttacksArray[SQUARES][256];
+bitboard diagURAttacksArray[SQUARES][256];
+bitboard diagULAttacksArray[SQUARES][256];
+
+/* BaseDevelopmentTable is the development tables of evaluate.h for both
+   colors, initializeEval() multiplies it by DE_FACTOR */
+
+int BaseDevelopmentTable[COLORS][PIECES][64];
+
+
+/* Function: rank
+ * Input:    A square
+ * Output:   Its rank
+ * Purpose:  The same as rank() of board.cpp, this program doesn't have it.
+ */
+
+int rank(square sq)
+{
+	return sq & 7;
+}
+
+
+/* Function: file
+ * Input:    A square
+ * Output:   Its file
+ * Purpose:  The same as file() of board.cpp.
+ */
+
+int file(square sq)
+{
+	return (sq & 0x38) >> 3;
+}
+
+
+/* 
+ * Function: initBitboards
+ * Input:    None
+ * Output:   None
+ * Purpose:  Used to set up all of the tables used in the bit boards.
+ */
+
+static void initBitboards()
+{
+   int leftborder, rightborder, upperborder, lowerborder; 
+   int n, o, i;
+   bitboard bb, bb2;
+   square sq;
+
+
+   /* First generate the Square -> Bitboard with only that square set 
+      Lookup table, makes setting / unsetting squares MUCH faster */
+	
+	for (sq = 0; sq < SQUARES; sq++) 
+		BitInBB[sq] = (qword(1) << sq);
+
+   /* Generate the attacks of short range pieces.  Just make sure that the
+      attacks dont wrap around the board */
+
+   for (sq = 0; sq < SQUARES; sq++) 
+      {
+	  
+      pawnAttacks[WHITE][sq] = pawnAttacks[BLACK][sq] = qword(0);
+      if (file(sq) == 0) 
+         {
+         pawnAttacks[WHITE][sq].setSquare(sq + ONE_FILE + ONE_RANK);
+         pawnAttacks[BLACK][sq].setSquare(sq + ONE_FILE - ONE_RANK);
+		 
+		 
+         } 
+      else if (file(sq) == 7) 
+         {
+         pawnAttacks[WHITE][sq].setSquare(sq - ONE_FILE + ONE_RANK);
+         pawnAttacks[BLACK][sq].setSquare(sq - ONE_FILE - ONE_RANK);
+		 
+		 
+         } 
+      else 
+         {
+         if (sq+ONE_FILE+ONE_RANK < 65)  pawnAttacks[WHITE][sq].setSquare(sq + ONE_FILE + ONE_RANK);
+         if (sq-ONE_FILE+ONE_RANK < 65)  pawnAttacks[WHITE][sq].setSquare(sq - ONE_FILE + ONE_RANK);
+         if (sq+ONE_FILE-ONE_RANK >= 0)  pawnAttacks[BLACK][sq].setSquare(sq + ONE_FILE - ONE_RANK);
+         if (sq-ONE_FILE-ONE_RANK >= 0)  pawnAttacks[BLACK][sq].setSquare(sq - ONE_FILE - ONE_RANK);		 
+		}
+
+
+
+	  leftborder = rightborder = upperborder = lowerborder = 0; 
+	  if (file(sq) == 0) leftborder = 1; 
+	  if (file(sq) == 7) rightborder = 1; 
+	  if (rank(sq) == 0) lowerborder = 1; 
+	  if (rank(sq) == 7) upperborder = 1; 
+
+	  if ((!leftborder) && (!lowerborder)) contactBishopAttacks[sq].setSquare(sq - ONE_FILE - ONE_RANK);
+	  if ((!rightborder) && (!lowerborder)) contactBishopAttacks[sq].setSquare(sq + ONE_FILE - ONE_RANK);
+	  if ((!leftborder) && (!upperborder)) contactBishopAttacks[sq].setSquare(sq - ONE_FILE + ONE_RANK);
+	  if ((!rightborder) && (!upperborder)) contactBishopAttacks[sq].setSquare(sq + ONE_FILE + ONE_RANK);
+	 
+	  if (!leftborder) contactRookAttacks[sq].setSquare(sq-ONE_FILE); 
+	  if (!rightborder) contactRookAttacks[sq].setSquare(sq+ONE_FILE); 
+	  if (!lowerborder) contactRookAttacks[sq].setSquare(sq-ONE_RANK); 
+	  if (!upperborder) contactRookAttacks[sq].setSquare(sq+ONE_RANK); 
+
+
+      kingAttacks[sq] = 0;
+      for (n = -1; n <= 1; n++)
+         for (o = -1; o <= 1; o++) 
+            {
+            if (n == 0 && o == 0) 
+               continue;
+            if (rank(sq) + n >= 0 && rank(sq) + n <= 7 &&
+                file(sq) + o >= 0 && file(sq) + o <= 7)
+               kingAttacks[sq].setSquare(sq + n * ONE_RANK + o * ONE_FILE);
+            }
+    
+      knightAttacks[sq] = 0;
+      for (n = -2; n <= 2; n++) 
+         {
+         if (n == 0) 
+            continue;
+         if (file(sq) + n <= 7 && file(sq) + n >=0 &&
+             rank(sq) + (3 - abs(n)) <= 7 && rank(sq) + (3 - abs(n)) >= 0)
+            knightAttacks[sq].setSquare(sq + n * ONE_FILE + (3 - abs(n))*ONE_RANK);
+    
+         if (file(sq) + n <= 7 && file(sq) + n >=0 &&
+             rank(sq) + (abs(n) - 3) <= 7 && rank(sq) + (abs(n) - 3) >= 0)
+            knightAttacks[sq].setSquare(sq + n * ONE_FILE + (abs(n) - 3)*ONE_RANK);
+         }
+      }
+
+   for (sq = 0; sq < SQUARES; sq++) 
+      {
+ 
+      /* Set up all of the attack bitboards.  The general formula to do this is
+         to start on the square the piece is on.  Then add bits in every 
+         direction until a piece or the edge is hit */
+
+      for (o = 0; o < 256; o++) 
+         {
+         bb = 0;
+
+         if (file(sq) < 7) 
+            {
+            for (i = ONE_FILE; ((1 << file(sq + i)) & o) == 0 && file(sq + i) < 7;
+                 i += ONE_FILE)
+               bb.setSquare(sq + i);
+            bb.setSquare(sq + i);
+            }
+      
+         if (file(sq) > 0) 
+            {
+            for (i = ONE_FILE; ((1 << file(sq - i)) & o) == 0 && file(sq - i) > 0;
+                 i += ONE_FILE)
+               bb.setSquare(sq - i);
+            bb.setSquare(sq - i);
+            }
+
+         fileAttacksArray[sq][o] = bb;
+         }
+    
+      for (o = 0; o < 256; o++) 
+         {
+         bb = 0;
+
+         if (rank(sq) < 7) 
+            {
+            for (i = ONE_RANK; ((1 << rank(sq + i)) & o) == 0 && rank(sq + i) < 7;
+                 i += ONE_RANK)
+               bb.setSquare(sq + i);
+            bb.setSquare(sq + i);
+            }
+
+         if (rank(sq) > 0) 
+            {
+            for (i = ONE_RANK; ((1 << rank(sq - i)) & o) == 0 && rank(sq - i) > 0;
+                 i += ONE_RANK)
+               bb.setSquare(sq - i);
+            bb.setSquare(sq - i);
+            }
+
+         rankAttacksArray[sq][o] = bb;
+         }
+
+      for (o = 0; o < 256; o++) 
+         {
+         bb = 0;
+
+         if (file(sq) < 7 && rank(sq) < 7) 
+            {
+            for (i = ONE_FILE + ONE_RANK;
+                  ((1 << (urShift[sq + i] - urDiagShift[sq + i])) & o) == 0 &&
+                  file(sq + i) < 7 && rank(sq + i) < 7;
+                  i += ONE_FILE + ONE_RANK)
+               bb.setSquare(sq + i);
+            bb.setSquare(sq + i);
+            }
+
+         if (file(sq) > 0 && rank(sq) > 0) 
+            {
+            for (i = ONE_FILE + ONE_RANK;
+                  ((1 << (urShift[sq - i] - urDiagShift[sq - i])) & o) == 0 &&
+                  file(sq - i) > 0 && rank(sq - i) > 0;
+                  i += ONE_FILE + ONE_RANK)
+               bb.setSquare(sq - i);
+            bb.setSquare(sq - i);
+            }
+
+         diagURAttacksArray[sq][o] = bb;
+         }
+
+      for (o = 0; o < 256; o++) 
+         {
+         bb = 0;
+
+         if (rank(sq) < 7 && file(sq) > 0) 
+            {
+            for (i = ONE_RANK - ONE_FILE;
+                  ((1 << (ulShift[sq + i] - ulDiagShift[sq + i])) & o) == 0 && 
+                  rank(sq + i) < 7 && file(sq + i) > 0; 
+                  i += ONE_RANK - ONE_FILE)
+               bb.setSquare(sq + i);
+            bb.setSquare(sq + i);
+            }
+
+         if (rank(sq) > 0 && file(sq) < 7) 
+            {
+            for (i = ONE_RANK - ONE_FILE;
+                  ((1 << (ulShift[sq - i] - ulDiagShift[sq - i])) & o) == 0 &&
+                  rank(sq - i) > 0 && file(sq - i) < 7; 
+                  i += ONE_RANK - ONE_FILE)
+               bb.setSquare(sq - i);
+            bb.setSquare(sq - i);
+            }
+
+      diagULAttacksArray[sq][o] = bb;
+      }
+   }
+
+    /* Get the squaresTo, squaresPast and directionPiece array.  See if the
+       from square is along the same line as to to square, if it is then set
+       all of the squares between them on the squaresTo and all the bits past
+       in squaresPast and set directionPiece to be the piece that moves like
+       that. */
+
+   for (n = 0; n < SQUARES; n++) 
+      {
+      for (o = 0; o < SQUARES; o++) 
+         {
+         bb = 0;
+         if (n == o) 
+            {
+            squaresTo[n][o] = 0;
+            squaresPast[n][o] = 0;
+            directionPiece[n][o] = NONE;
+            }
+         else if (file(n) == file(o)) 
+            {
+            directionPiece[n][o] = ROOK;
+            sq = n;
+            do 
+               {
+               if (rank(o) > rank(sq)) 
+                  sq += ONE_RANK;
+               else 
+                  sq -= ONE_RANK;
+               bb.setSquare(sq);
+               } while(sq != o);
+            squaresTo[n][o] = bb;
+
+            bb = 0;
+            if (rank(sq) != 0 && rank(sq) != 7) 
+               {
+               do 
+                  {
+                  if (rank(o) > rank(n)) 
+                     sq += ONE_RANK;
+                  else 
+                     sq -= ONE_RANK;
+                  bb.setSquare(sq);
+                  } while(rank(sq) != 0 && rank(sq) != 7);
+            }
+         squaresPast[n][o] = bb;
+         } 
+      else if (rank(n) == rank(o)) 
+         {
+         directionPiece[n][o] = ROOK;
+         sq = n;
+         do 
+            {
+            if (file(o) > file(sq)) 
+               sq += ONE_FILE;
+            else 
+               sq -= ONE_FILE;
+            bb.setSquare(sq);
+            } while(sq != o);
+         squaresTo[n][o] = bb;
+
+         bb = 0;
+         if (file(sq) != 0 && file(sq) != 7) 
+            {
+            do 
+               {
+               if (file(o) > file(n)) 
+                  sq += ONE_FILE;
+               else 
+                  sq -= ONE_FILE;
+               bb.setSquare(sq);
+               } while(file(sq) != 0 && file(sq) != 7);
+            }
+         squaresPast[n][o] = bb;
+      } 
+   else if (rank(o) - rank(n) == file(o) - file(n)) 
+      {
+      directionPiece[n][o] = BISHOP;
+      sq = n;
+      do 
+         {
+         if (rank(o) > rank(sq)) 
+            sq += ONE_FILE + ONE_RANK;
+         else 
+            sq -= ONE_FILE + ONE_RANK;
+         bb.setSquare(sq);
+         } while(sq != o);
+      squaresTo[n][o] = bb;
+
+      bb = 0;
+      if (file(sq) != 0 && file(sq) != 7 &&
+         rank(sq) != 0 && rank(sq) != 7) 
+         {
+         do 
+            {
+            if (file(o) > file(n)) 
+               sq += ONE_FILE + ONE_RANK;
+            else 
+               sq -= ONE_FILE + ONE_RANK;
+            bb.setSquare(sq);
+            } while(file(sq) != 0 && file(sq) != 7 &&
+         rank(sq) != 0 && rank(sq) != 7);
+         }
+      squaresPast[n][o] = bb;
+      } 
+   else if (rank(o) - rank(n) == -(file(o) - file(n))) 
+      {
+      directionPiece[n][o] = BISHOP;
+      sq = n;
+      do {
+         if (rank(o) > rank(sq)) 
+            sq += ONE_RANK - ONE_FILE;
+         else 
+            sq -= ONE_RANK - ONE_FILE;
+         bb.setSquare(sq);
+         } while(sq != o);
+      squaresTo[n][o] = bb;
+
+      bb = 0;
+      if (file(sq) != 0 && file(sq) != 7 &&
+            rank(sq) != 0 && rank(sq) != 7) 
+         {
+         do 
+            {
+            if (rank(o) > rank(n)) 
+               sq += ONE_RANK - ONE_FILE;
+            else 
+               sq -= ONE_RANK - ONE_FILE;
+            bb.setSquare(sq);
+            } while (file(sq) != 0 && file(sq) != 7 &&
+                     rank(sq) != 0 && rank(sq) != 7);
+         }
+      
+      squaresPast[n][o] = bb;
+      }
+   else if (knightAttacks[n].squareIsSet(o)) 
+      {
+      squaresPast[n][o] = 0;
+      squaresTo[n][o] = qword(1) << o;
+      } 
+   else 
+      {
+      squaresPast[n][o] = squaresTo[n][o] = 0;
+      }
+    }
+  }
+
+   /* Set up the near squares, these are squares that are no more than two
+      squares away */
+  
+   for (sq = 0; sq < SQUARES; sq++) 
+   {
+		nearSquares[sq][WHITE] = (qword) 0;
+		nearSquares[sq][WHITE] |= kingAttacks[sq];
+		if (sq + ONE_RANK < SQUARES) nearSquares[sq][WHITE] |= kingAttacks[sq+ONE_RANK];
+      
+		nearSquares[sq][BLACK] = (qword) 0;
+		nearSquares[sq][BLACK] |= kingAttacks[sq];
+		if (sq - ONE_RANK >= 0) nearSquares[sq][BLACK] |= kingAttacks[sq-ONE_RANK];
+
+   }
+
+   return;
+}
+
+
+/* hashNumbers is an array of random numbers for generating a hash value. */
+
+qword hashNumbers[COLORS][PIECES][64];
+qword hashHandNumbers[COLORS][PIECES][17];
+qword hashCastleNumbers[COLORS][2];
+qword hashEnPassantNumbers[66];  /* 66 to include room for OFF_BOARD */
+
+#ifdef DEBUG_HASH
+qword hashNumbersT[COLORS][PIECES][64];
+qword hashHandNumbersT[COLORS][PIECES][17];
+qword hashCastleNumbersT[COLORS][2];
+qword hashEnPassantNumbersT[66];  /* 66 to include room for OFF_BOARD */
+#endif
+
+static duword ssrandom(void);
+
+/* State of the additive feedback generator behind ssrandom() */
+
+static duword randomState[34];
+static int randomIndex;
+
+/* Function: ssrandomSeed
+ * Input:    A seed.
+ * Output:   None.
+ * Purpose:  Seeds ssrandom().  The generator is the same one glibc uses 
+ *           for rand(), so the keys match the ones older Linux builds 
+ *           wrote into their learn files, but now they are the same on 
+ *           every platform.
+ */
+
+static void ssrandomSeed(duword seed)
+{
+	int n;
+	sdword hi, lo, word;
+
+	if (!seed) seed = 1; 
+	randomState[0] = seed;
+
+	for (n = 1; n < 31; n++)
+	{
+		/* 16807 * state % (2^31 - 1) without overflowing 32 bits */
+
+		hi = randomState[n - 1] / 127773;
+		lo = randomState[n - 1] % 127773;
+		word = 16807 * lo - 2836 * hi;
+		if (word < 0) word += 2147483647;
+		randomState[n] = word;
+	}
+
+	for (n = 31; n < 34; n++)
+		randomState[n] = randomState[n - 31];
+
+	randomIndex = 34;
+
+	/* Throw away the first numbers, they are not very random */
+
+	for (n = 0; n < 310; n++) ssrandom();
+}
+
+
+/* Function: ssrandom
+ * Input:    None.
+ * Output:   A random 31 bit number.
+ * Purpose:  Portable replacement for rand(), r[i] = r[i-3] + r[i-31].
+ */
+
+static duword ssrandom(void)
+{
+	duword r;
+
+	r = randomState[(randomIndex + 31) % 34] + randomState[(randomIndex + 3) % 34];
+	randomState[randomIndex % 34] = r;
+	randomIndex = (randomIndex + 1) % 34;
+
+	return r >> 1;
+}
+
+
+/* Function: ssrandom64
+ * Input:    None.
+ * Output:   A random 64 bit number.
+ * Purpose:  Used for the Zobrist hashing. 
+ *
+ */
+
+static qword ssrandom64(void) {
+  
+ 	return (((qword) (ssrandom() & 0xFFFF)) |         
+		    ((qword) (ssrandom() & 0xFFFF) << 16) |   
+		    ((qword) (ssrandom() & 0xFFFF) << 32) |   
+		    ((qword) (ssrandom() & 0xFFFF) << 48)); 
+
+}
+
+
+/* Function: initHashNumbers
+ * Input:    None.
+ * Output:   None.
+ * Purpose:  Makes the random numbers of the hash values.
+ */
+
+static void initHashNumbers()
+{
+  color c;
+  piece p;
+  int n;
+
+	 /* Use one seed, else the simple learning can't work. */ 
+	  
+	 ssrandomSeed(80180);
+    
+	 /* Generate the random numbers in the hash tables */
+    
+
+    for(c = FIRST_COLOR; c <= LAST_COLOR; c = (color) (c + 1)) 
+	{
+      for(p = FIRST_PIECE; p <= LAST_PIECE; p = (piece) (p + 1)) 
+	  {
+		for(n = 0; n < 64; n++)
+		{
+		hashNumbers[c][p][n] = ssrandom64();
+
+#ifdef DEBUG_HASH
+		hashNumbersT[c][p][n] = ssrandom64();
+#endif
+		}
+      }
+    }
+	
+	for(c = FIRST_COLOR; c <= LAST_COLOR; c = (color) (c + 1)) 
+	{
+      for(p = FIRST_PIECE; p <= LAST_PIECE; p = (piece) (p + 1)) 
+	  {
+		for(n = 0; n < 17; n++)
+		{
+		hashHandNumbers[c][p][n] = ssrandom64();
+
+#ifdef DEBUG_HASH
+		hashHandNumbersT[c][p][n] = ssrandom64();
+#endif
+		}
+      }
+    }
+    
+	for(n = 0; n < 66; n++) 
+	{
+		hashEnPassantNumbers[n] = ssrandom64();
+
+#ifdef DEBUG_HASH
+		hashEnPassantNumbersT[n] = ssrandom64();
+#endif
+	}
+    
+	
+	hashCastleNumbers[WHITE][KING_SIDE] = ssrandom64();
+    hashCastleNumbers[WHITE][QUEEN_SIDE] = ssrandom64();
+    hashCastleNumbers[BLACK][KING_SIDE] = ssrandom64();
+    hashCastleNumbers[BLACK][QUEEN_SIDE] = ssrandom64();
+
+#ifdef DEBUG_HASH
+	hashCastleNumbersT[WHITE][KING_SIDE] = ssrandom64();
+    hashCastleNumbersT[WHITE][QUEEN_SIDE] = ssrandom64();
+    hashCastleNumbersT[BLACK][KING_SIDE] = ssrandom64();
+    hashCastleNumbersT[BLACK][QUEEN_SIDE] = ssrandom64();
+#endif
+}
+
+
+/* Function: initDevelopment
+ * Input:    None.
+ * Output:   None.
+ * Purpose:  Puts the development tables of evaluate.h in BaseDevelopmentTable,
+ *           they are from white's point of view with a8 first.
+ */
+
+static void initDevelopment()
+{
+  const int *tables[PIECES] = { NULL, pawnDevelopmentTable, 
+    rookDevelopmentTable, knightDevelopmentTable, bishopDevelopmentTable,
+    queenDevelopmentTable, kingDevelopmentTable };
+  piece p;
+  int sq;
+
+  for (p = FIRST_PIECE; p <= LAST_PIECE; p++)
+  {
+    for (sq = 0; sq < SQUARES; sq++)
+    {
+      BaseDevelopmentTable[BLACK][p][(sq / 8) * ONE_RANK + (sq % 8) * ONE_FILE] =
+        tables[p][sq];
+      BaseDevelopmentTable[WHITE][p][(7 - sq / 8) * ONE_RANK + (sq % 8) * ONE_FILE] =
+        tables[p][sq];
+    }
+  }
+}
+
+
+/* Function: writeArray
+ * Input:    The file, the sizes of the dimensions of the array and how many
+ *           there are, the values in the order they are in memory (moved
+ *           past the ones written) and if they are ints or qwords
+ * Output:   None
+ * Purpose:  Writes the initializer of an array, with braces for every
+ *           dimension.
+ */
+
+static void writeArray(FILE *fout, const int *sizes, int dimensions,
+                       const qword **values, int ints)
+{
+  int n;
+
+  fprintf(fout, "{");
+  for (n = 0; n < sizes[0]; n++)
+  {
+    if (dimensions > 1)
+    {
+      fprintf(fout, "\n");
+      writeArray(fout, sizes + 1, dimensions - 1, values, ints);
+    }
+    else
+    {
+      if (!(n % (ints ? 16 : 4))) fprintf(fout, "\n ");
+
+      if (ints) fprintf(fout, " %d", (int) **values);
+      else fprintf(fout, " qword(0x%08lX%08lX)", 
+        (unsigned long) (**values >> 32), (unsigned long) (**values & 0xFFFFFFFF));
+      (*values)++;
+    }
+    if (n < sizes[0] - 1) fprintf(fout, ",");
+  }
+  fprintf(fout, "}");
+}
+
+
+/* Function: writeTable
+ * Input:    The file, the declaration of the table without the sizes, the 
+ *           sizes (a 0 ends them), the table and what's in it (0 for qwords,
+ *           1 for bitboards, 2 for ints)
+ * Output:   None
+ * Purpose:  Writes a table as a const array.
+ */
+
+static void writeTable(FILE *fout, const char *declaration, const int *sizes,
+                       const void *table, int type)
+{
+  qword *values;
+  const qword *next;
+  int n, count, dimensions;
+
+  count = 1;
+  for (dimensions = 0; sizes[dimensions]; dimensions++)
+    count *= sizes[dimensions];
+
+  values = (qword *) malloc(count * sizeof(qword));
+  if (!values)
+  {
+    fprintf(stderr, "gentables: out of memory\n");
+    exit(1);
+  }
+
+  for (n = 0; n < count; n++)
+  {
+    if (type == 0) values[n] = ((const qword *) table)[n];
+    else if (type == 1) values[n] = ((const bitboard *) table)[n].data;
+    else values[n] = (qword) ((const int *) table)[n];
+  }
+
+  fprintf(fout, "\nconst %s", declaration);
+  for (n = 0; n < dimensions; n++) fprintf(fout, "[%d]", sizes[n]);
+  fprintf(fout, " = ");
+
+  next = values;
+  writeArray(fout, sizes, dimensions, &next, type == 2);
+  fprintf(fout, ";\n");
+
+  free(values);
+}
+
+
+/* Function: main
+ * Input:    The arguments, the file to write
+ * Output:   0, 1 if an error occured
+ * Purpose:  Makes the tables and writes them.
+ */
+
+int main(int argc, char **argv)
+{
+  static const int one[] = { SQUARES, 0 }, colorsSquares[] = { COLORS, SQUARES, 0 },
+    squaresSquares[] = { SQUARES, SQUARES, 0 }, squaresColors[] = { SQUARES, COLORS, 0 },
+    lines[] = { SQUARES, 256, 0 }, hash[] = { COLORS, PIECES, 64, 0 }, 
+    hand[] = { COLORS, PIECES, 17, 0 }, castle[] = { COLORS, 2, 0 }, 
+    enPassant[] = { 66, 0 }, development[] = { COLORS, PIECES, 64, 0 };
+  FILE *fout;
+
+  if (argc != 2)
+  {
+    fprintf(stderr, "Usage: gentables <file to write>\n");
+    return 1;
+  }
+
+  initBitboards();
+  initHashNumbers();
+  initDevelopment();
+
+  fout = fopen(argv[1], "w");
+  if (!fout)
+  {
+    fprintf(stderr, "gentables: can't write %s\n", argv[1]);
+    return 1;
+  }
+
+  fprintf(fout, "/* Written by gentables, change gentables.cpp instead of this file */\n\n");
+  fprintf(fout, "#include \"board.h\"\n#include \"brain.h\"\n");
+
+  writeTable(fout, "qword BitInBB", one, BitInBB, 0);
+  writeTable(fout, "bitboard pawnAttacks", colorsSquares, pawnAttacks, 1);
+  writeTable(fout, "bitboard contactBishopAttacks", one, contactBishopAttacks, 1);
+  writeTable(fout, "bitboard contactRookAttacks", one, contactRookAttacks, 1);
+  writeTable(fout, "bitboard knightAttacks", one, knightAttacks, 1);
+  writeTable(fout, "bitboard kingAttacks", one, kingAttacks, 1);
+  writeTable(fout, "bitboard squaresTo", squaresSquares, squaresTo, 1);
+  writeTable(fout, "bitboard nearSquares", squaresColors, nearSquares, 1);
+  writeTable(fout, "piece directionPiece", squaresSquares, directionPiece, 2);
+  writeTable(fout, "bitboard squaresPast", squaresSquares, squaresPast, 1);
+  writeTable(fout, "int ulShift", one, ulShift, 2);
+  writeTable(fout, "int urShift", one, urShift, 2);
+  writeTable(fout, "int ulDiagShift", one, ulDiagShift, 2);
+  writeTable(fout, "int urDiagShift", one, urDiagShift, 2);
+  writeTable(fout, "bitboard rankAttacksArray", lines, rankAttacksArray, 1);
+  writeTable(fout, "bitboard fileAttacksArray", lines, fileAttacksArray, 1);
+  writeTable(fout, "bitboard diagURAttacksArray", lines, diagURAttacksArray, 1);
+  writeTable(fout, "bitboard diagULAttacksArray", lines, diagULAttacksArray, 1);
+
+  writeTable(fout, "qword hashNumbers", hash, hashNumbers, 0);
+  writeTable(fout, "qword hashHandNumbers", hand, hashHandNumbers, 0);
+  writeTable(fout, "qword hashCastleNumbers", castle, hashCastleNumbers, 0);
+  writeTable(fout, "qword hashEnPassantNumbers", enPassant, hashEnPassantNumbers, 0);
+#ifdef DEBUG_HASH
+  fprintf(fout, "\n#ifdef DEBUG_HASH\n");
+  writeTable(fout, "qword hashNumbersT", hash, hashNumbersT, 0);
+  writeTable(fout, "qword hashHandNumbersT", hand, hashHandNumbersT, 0);
+  writeTable(fout, "qword hashCastleNumbersT", castle, hashCastleNumbersT, 0);
+  writeTable(fout, "qword hashEnPassantNumbersT", enPassant, hashEnPassantNumbersT, 0);
+  fprintf(fout, "#endif\n");
+#endif
+
+  writeTable(fout, "int BaseDevelopmentTable", development, BaseDevelopmentTable, 2);
+
+  if (fclose(fout))
+  {
+    fprintf(stderr, "gentables: can't write %s\n", argv[1]);
+    return 1;
+  }
+  return 0;
+}
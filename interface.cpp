@@ -25,6 +25,7 @@
 	#include <sys/types.h>
 	#include <unistd.h>
 	#include <sys/select.h>
+	#include <limits.h>
 #endif
 
 
@@ -39,6 +40,7 @@
 #include "bughouse.h"
 #include "brain.h"
 #include "board.h"
+#include "nnue.h"
 
 /* This is what is echoed when the user first logs on to Sunsetter in client mode.  */
 
@@ -61,11 +63,18 @@ const char *clientLogin = "Sunsetter " VERSION " (c) Ben Dean-Kawamura, Georg v.
 #endif  // #ifndef __EMSCRIPTEN__
 
 int ratingDiff = 0; 
-int learning = 0;
-int analyzeMode = 0; 
-int forceMode = 0;
+SEARCH_LOCAL int learning = 0;
+SEARCH_LOCAL int analyzeMode = 0; 
+SEARCH_LOCAL int forceMode = 0;
 
-int xboardMode = 0; 
+SEARCH_LOCAL int xboardMode = 0; 
+
+SEARCH_LOCAL int ignoreInput = 0;
+
+extern SEARCH_LOCAL int stats_hashSize;
+
+void (*outputHook)(const char *str) = NULL;
+void (*inputHook)(const char *str) = NULL;
 
 #ifdef LOG
 
@@ -99,7 +108,8 @@ int checkInput() {
     while (!command_queue.empty()) {
         char *c_cmd = command_queue.front();
         command_queue.pop();
-        parseOption(c_cmd);
+        if (inputHook) inputHook(c_cmd);
+        else parseOption(c_cmd);
         free(c_cmd);
 
         wasInput = 1;
@@ -109,8 +119,17 @@ int checkInput() {
 }
 
 void output(const char *str) {
+    if (outputHook) outputHook(str);
+    else printf("%s", str);
+}
+
+void outputToStdout(const char *str) {
     printf("%s", str);
 }
+
+void flushOutput(int wait) {
+    if (wait) fflush(stdout);
+}
 #else
 
 
@@ -238,6 +257,7 @@ void ShutdownInput()
 
 void waitForInput()
 {
+	flushOutput(1);
 	while (!checkInput()){};
 }
 
@@ -264,16 +284,24 @@ int checkInput()
 
    if (analyzeMode && gameInProgress && !xboardMode) analyzeUpdate(); 
 
+	if (ignoreInput) 
+	{
+		flushOutput(0);
+		return 0;
+	}
+
 	if (!hThread)
 	{
 		InitInput();
 	}
-	while (Input(str))
+	while (!ignoreInput && Input(str))
 	{
 		wasInput = 1;
-		parseOption(str);
+		if (inputHook) inputHook(str);
+		else parseOption(str);
 	}
 
+   flushOutput(0);
    return wasInput;
 }
 
@@ -345,6 +373,8 @@ int Input(char *str)
  */
 void waitForInput()
 {
+	flushOutput(1);
+
 	// while no input, sleep for 1/1000 seconds
 	while (!checkInput())usleep(1000);
 }
@@ -371,62 +401,211 @@ int checkInput()
 
    if (analyzeMode && gameInProgress && !xboardMode) analyzeUpdate(); 
 
-   while (Input(str))
+   if (ignoreInput) 
+   {
+      flushOutput(0);
+      return 0;
+   }
+
+   while (!ignoreInput && Input(str))
    {
       wasInput = 1;
-      parseOption(str);
+      if (inputHook) inputHook(str);
+      else parseOption(str);
    }
 
+   flushOutput(0);
    return wasInput;
 }
 
 #endif // not _WIN32
 
 
+/* output() keeps what it prints in outputBuffer until flushOutput() writes
+   it.  The lines printPrincipalVar() and analyzeUpdate() put together from 
+   many pieces go out whole with one write(), and the search doesn't wait
+   for a GUI that is slow to read.  The buffer grows if it has to */
+
+#define OUTPUT_BUFFER_START (64 * 1024)
+
+static char *outputBuffer;
+static int outputLength, outputSize;
+
+
+/*
+ * Function: writeOutput
+ * Input:    What to write, how many bytes and if it may wait
+ * Output:   How many bytes were written.
+ * Purpose:  Writes to stdout and the log file.  If it may not wait it 
+ *           stops when stdout can't take more without blocking, and ends
+ *           what it writes with a whole line if it can.
+ */
+
+static int writeOutput(const char *str, int bytes, int wait)
+{
+   int written = 0, chunk, n, value;
+#ifndef _WIN32
+   fd_set stdout_holder;
+   struct timeval tv;
+#endif
+
+   while (written < bytes)
+   {
+      chunk = bytes - written;
+
+#ifndef _WIN32
+      if (!wait)
+      {
+         FD_ZERO(&stdout_holder);
+         FD_SET(1, &stdout_holder);
+         tv.tv_sec = 0; tv.tv_usec = 0;
+         if (select(2, NULL, &stdout_holder, NULL, &tv) <= 0) break;
+
+         // a pipe that has room takes this much without blocking
+         if (chunk > PIPE_BUF)
+         {
+            chunk = PIPE_BUF;
+            for (n = chunk; n > 0; n--)
+            {
+               if (str[written + n - 1] == '\n' || 
+                   str[written + n - 1] == '\r') break;
+            }
+            if (n) chunk = n;
+         }
+      }
+#endif
+
+      value = write(1, str + written, chunk);
+      if (value < 0 && errno == EINTR) continue;
+      if (value < 0) 
+      {
+         outputLength = 0;
+         perror("output()");
+         exit(1);
+      }
+
+#ifdef LOG
+      static int startOfLine = 1;
+      if (logFile) 
+      {
+         for (n = written; n < written + value; n++)
+         {
+            if (startOfLine) fputs("> ", logFile);
+            fputc(str[n], logFile);
+            startOfLine = (str[n] == '\n');
+         }
+      }
+#endif
+
+      written += value;
+   }
+
+#ifdef LOG
+   if (logFile && written) fflush(logFile);
+#endif
+
+   return written;
+}
+
+
+/*
+ * Function: flushOutput
+ * Input:    If it may wait
+ * Output:   None.
+ * Purpose:  Writes what output() kept.  If it may not wait (the search 
+ *           calls it through checkInput()) only whole lines are written, 
+ *           as many as stdout takes.  If it may, everything is written,
+ *           done when a move is given and when Sunsetter waits for input.
+ */
+
+void flushOutput(int wait)
+{
+   int n;
+
+   if (!outputLength) return;
+
+   if (wait) n = outputLength;
+   else 
+   {
+      for (n = outputLength; n > 0; n--)
+      {
+         if (outputBuffer[n - 1] == '\n' || outputBuffer[n - 1] == '\r') break;
+      }
+      if (!n) return;
+   }
+
+   n = writeOutput(outputBuffer, n, wait);
+
+   memmove(outputBuffer, outputBuffer + n, outputLength - n);
+   outputLength -= n;
+}
+
+
+/*
+ * Function: flushOutputAtExit
+ * Input:    None.
+ * Output:   None.
+ * Purpose:  Given to atexit(), so nothing output() kept is lost.
+ */
+
+static void flushOutputAtExit()
+{
+   flushOutput(1);
+}
+
+
 /* 
  * Function: output
  * Input:    A string
  * Output:   None.
- * Purpose:  Used to print a string to the appropriate place.
+ * Purpose:  Used to print a string to the appropriate place.  That is
+ *           outputHook if it's set (see libsunsetter.cpp), else stdout 
+ *           through outputBuffer.
  */
 
 void output(const char *str)
 {
-   int outputFD, value;
- 
-   outputFD = 1;
-   
-   do {
-      value = write(outputFD, str, strlen(str));
-	} while(value < 0 && errno == EINTR);
+   if (outputHook) outputHook(str);
+   else outputToStdout(str);
+}
 
-	if (value < 0) 
-	{
-		perror("output()");
-		exit(1);
-	}
 
-#ifdef LOG
-	static int startOfLine = 1;
-	if (logFile) 
-	{
-		if (startOfLine) 
-		{
-			fprintf(logFile, "> %s", str);
-			startOfLine = 0;
-		} 
-		else 
-		{
-			fprintf(logFile, "%s", str);
-		}
+/* 
+ * Function: outputToStdout
+ * Input:    A string
+ * Output:   None.
+ * Purpose:  Keeps a string in outputBuffer for stdout, also when 
+ *           outputHook is set.  server.cpp's hook prints with it.
+ */
 
-		if (strchr(str, '\n') != NULL)  
-			startOfLine = 1;
-		fflush(logFile);
-	}
-#endif
+void outputToStdout(const char *str)
+{
+   static int atExit;
+   int length, size;
+   char *bigger;
 
-	return;
+   length = strlen(str);
+
+   if (outputLength + length > outputSize)
+   {
+      if (!atExit) atExit = !atexit(flushOutputAtExit);
+
+      size = outputSize ? outputSize : OUTPUT_BUFFER_START;
+      while (size < outputLength + length) size *= 2;
+
+      bigger = (char *) realloc(outputBuffer, size);
+      if (!bigger)
+      {
+         flushOutput(1);
+         writeOutput(str, length, 1);
+         return;
+      }
+      outputBuffer = bigger;
+      outputSize = size;
+   }
+
+   memcpy(outputBuffer + outputLength, str, length);
+   outputLength += length;
 }
 #endif  // #ifdef __EMSCRIPTEN__
 
@@ -479,6 +658,7 @@ void reportResult(game_result res)
 void parseHolding(const char *str)
 {
    int i, hand[COLORS][PIECES];
+   qword key = gameBoard.getHashValue();
    color c;
    piece p;
 
@@ -522,6 +702,45 @@ void parseHolding(const char *str)
    for (c = WHITE; c <= BLACK; c = (color) (c + 1))
       for(p = PAWN; p <= QUEEN; p = (piece) (p + 1))
          gameBoard.setPieceInHand(c, p, hand[c][p]);
+
+   if (gameBoard.getHashValue() != key) handsChanged();
+}
+
+/* 
+ * Function: parseFEN
+ * Input:    A FEN, the holdings may follow the board as "[Qp]" or after 
+ *           an 8th '/'
+ * Output:   0, -1 if it is no good
+ * Purpose:  Sets up gameBoard for libsunsetter.cpp and server.cpp
+ */
+
+int parseFEN(const char *fen)
+{
+   char pieces[MAX_STRING], turn[MAX_STRING], castles[MAX_STRING];
+   char ep[MAX_STRING], *ch;
+   int kings[COLORS] = { 0, 0 };
+
+   strcpy(turn, "w"); strcpy(castles, "-"); strcpy(ep, "-");
+   if (strlen(fen) >= MAX_STRING ||
+       sscanf(fen, "%s %s %s %s", pieces, turn, castles, ep) < 1)
+      return -1;
+
+   /* setBoard() wants the holdings after a '/' and only knows the 
+      pieces */
+
+   for (ch = pieces; *ch; ch++)
+      {
+      if (*ch == '[') *ch = '/';
+      else if (*ch == ']') *ch = '\0';
+      else if (*ch == 'K') kings[WHITE]++;
+      else if (*ch == 'k') kings[BLACK]++;
+      else if (!strchr("PNBRQpnbrq12345678/~", *ch)) return -1;
+      if (!*ch) break;
+      }
+   if (kings[WHITE] != 1 || kings[BLACK] != 1) return -1;
+
+   gameBoard.setBoard(pieces, turn, castles, ep);
+   return 0;
 }
 
 /*
@@ -586,6 +805,24 @@ void parseOption(const char *str)
 		readLearnTableFromDisk(); 
 		output("Learning is on.\n");
 	}
+	else if (!strcmp(arg[0], "nnue")) 
+	{
+		if (!strcmp(arg[1], "off"))
+		{
+			nnueActive = 0;
+			output("Using the normal eval.\n");
+		}
+		else if (nnueLoad(arg[1]))
+		{
+			nnueActive = 1;
+			gameBoard.nnueRefresh();
+			output("Using the network eval.\n");
+		}
+		else 
+		{
+			output("Could not load the network "); output(arg[1]); output("\n");
+		}
+	}
 	else if (!strcmp(arg[0], "memory")) 
 	{
 		int totalram=atoi(arg[1]);
@@ -774,6 +1011,26 @@ output ("//D: variant parsed, board reset and set to bug or zh \n");
 			makeTranspositionTable(MIN_HASH_SIZE); 
 		 /* There was an error, so make the table the minimum size. */
 	}
+	else if(!strcmp(arg[0], "sharedhash")) 
+	{	  
+		/* sharedhash <name> [megabytes], "off" makes it our own again */
+
+		n = arg[2][0] ? atoi(arg[2]) * 1024 * 1024 : 
+			stats_hashSize * 2 * sizeof(transpositionEntry);
+		strcpy(sharedHashName, strcmp(arg[1], "off") ? arg[1] : "");
+		if (makeTranspositionTable(n) == -1)
+			makeTranspositionTable(MIN_HASH_SIZE); 
+	}
+	else if(!strcmp(arg[0], "workers")) 
+	{	  
+		/* workers <n>, processes to split the root moves over, 0 for 
+		   none.  They get the options set before this one */
+
+		restartSearch();
+		n = startWorkers(max(atoi(arg[1]), 0));
+		sprintf(buf, "%d workers\n", n);
+		output(buf);
+	}
    else if (!strcmp(arg[0], "tellics"))
 	{
 		output("\ntellics "); output(arg[1]); output("\n");
@@ -807,16 +1064,16 @@ output ("//D: variant parsed, board reset and set to bug or zh \n");
 	  { FORCING_EXTENSION = atoi(arg[1]); }
 
    else if(!strcmp(arg[0], "qvalue"))
-	  { pValue[QUEEN] = atoi(arg[1]); }
+	  { pValue[QUEEN] = atoi(arg[1]); initializeEval(); }
    
    else if(!strcmp(arg[0], "rvalue"))
-	  { pValue[ROOK] = atoi(arg[1]); }
+	  { pValue[ROOK] = atoi(arg[1]); initializeEval(); }
 
    else if(!strcmp(arg[0], "bvalue"))
-	  { pValue[BISHOP] = atoi(arg[1]);}	
+	  { pValue[BISHOP] = atoi(arg[1]); initializeEval();}	
    
    else if(!strcmp(arg[0], "nvalue"))
-	  { pValue[KNIGHT] = atoi(arg[1]);}	
+	  { pValue[KNIGHT] = atoi(arg[1]); initializeEval();}	
 
    else if(!strcmp(arg[0], "bcfactor"))
 	  { BC_FACTOR = atoi(arg[1]);}	   
@@ -824,8 +1081,44 @@ output ("//D: variant parsed, board reset and set to bug or zh \n");
    else if(!strcmp(arg[0], "nkfactor"))
 	  { NK_FACTOR = atoi(arg[1]);}	
    
+   else if(!strcmp(arg[0], "futility"))
+	  { FUTILITY_MARGIN = atoi(arg[1]);}	
+
+   else if(!strcmp(arg[0], "futilitydepth"))
+	  { FUTILITY_DEPTH = atoi(arg[1]);}	
+
+   else if(!strcmp(arg[0], "lmr"))
+	  { LMR_MOVES = atoi(arg[1]);}	
+
+   else if(!strcmp(arg[0], "lmrdivisor"))
+	  { LMR_DIVISOR = atoi(arg[1]); initializeReductions();}	
+
+   else if(!strcmp(arg[0], "delta"))
+	  { DELTA_MARGIN = atoi(arg[1]);}	
+
+   else if(!strcmp(arg[0], "matenodes"))
+	  { MATE_NODES = atoi(arg[1]);}	
+
    else if(!strcmp(arg[0], "defactor"))
-	  { DE_FACTOR = atoi(arg[1]);}	
+	  { DE_FACTOR = atoi(arg[1]); initializeEval();}	
+
+   else if(!strcmp(arg[0], "pdefactor"))
+	  { DE_SCALE[PAWN] = atoi(arg[1]); initializeEval();}	
+
+   else if(!strcmp(arg[0], "rdefactor"))
+	  { DE_SCALE[ROOK] = atoi(arg[1]); initializeEval();}	
+
+   else if(!strcmp(arg[0], "ndefactor"))
+	  { DE_SCALE[KNIGHT] = atoi(arg[1]); initializeEval();}	
+
+   else if(!strcmp(arg[0], "bdefactor"))
+	  { DE_SCALE[BISHOP] = atoi(arg[1]); initializeEval();}	
+
+   else if(!strcmp(arg[0], "qdefactor"))
+	  { DE_SCALE[QUEEN] = atoi(arg[1]); initializeEval();}	
+
+   else if(!strcmp(arg[0], "kdefactor"))
+	  { DE_SCALE[KING] = atoi(arg[1]); initializeEval();}	
    
    else if(!strcmp(arg[0], "time"))
       gameBoard.setTime(gameBoard.getDeepBugColor(), atoi(arg[1]) *10);
@@ -904,7 +1197,7 @@ output ("//D: variant parsed, board reset and set to bug or zh \n");
         currentRules = CRAZYHOUSE;
         gameBoard.playCrazyhouse();
         gameBoard.setBoard(arg[1], arg[2], arg[3], arg[4]);
-        zapHashValues();
+        if (!analyzeMode) zapHashValues();
         resetAI();
 
         gameInProgress = 1;
@@ -975,11 +1268,11 @@ output ("//D: variant parsed, board reset and set to bug or zh \n");
 		{
 			stopThought(); /* Interrupt the pondering */
 			if (analyzeMode){
-				extern int stats_positionsSearched;
+				extern SEARCH_LOCAL int stats_positionsSearched;
 				stats_positionsSearched=0;
 				gameBoard.setDeepBugColor(gameBoard.getColorOnMove());
 				gameBoard.setLastMoveNow();
-				startSearchOver();
+				restartSearch();
 			}
 		}
 	}
@@ -996,19 +1289,19 @@ output ("//D: variant parsed, board reset and set to bug or zh \n");
 
 void pollForInput()
 {
-	static int i;
+	static SEARCH_LOCAL int i;
 
 #ifndef __EMSCRIPTEN__
 	if (i++ > 20000)
 	{
-		checkInput();
+		if (checkInput()) checkSpeculation();
 		i = 0;
 	}
 #else
     if (i++ > 20000)
     {
         i = 0;
-        checkInput();
+        if (checkInput()) checkSpeculation();
         emscripten_sleep_with_yield(10);
     }
 #endif  // #ifndef __EMSCRIPTEN__
@@ -1037,6 +1330,7 @@ void giveMove(move m)
 
 	sprintf(buf, "move %s\n", str);
 	output(buf);
+	flushOutput(1);
 
 }
 
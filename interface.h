@@ -38,12 +38,27 @@ extern const char *clientLogin;
 extern int partner;				/* If we have a partner in
 								client mode */
 
+extern SEARCH_LOCAL int ignoreInput;			/* If checkInput() should leave stdin
+								alone, used by the batch modes */
+
 void output(const char *str);              /* output() prints a string to the
 											approprate location */
 
+extern void (*outputHook)(const char *str);	/* If set output() gives
+											the strings to it */
+void outputToStdout(const char *str);	/* Prints to stdout even if
+											outputHook is set */
+void flushOutput(int wait);				/* Writes what output() kept, 
+											see interface.cpp */
+extern void (*inputHook)(const char *str);	/* If set checkInput() gives
+											the lines to it instead of 
+											parseOption() */
+
 
 void parseHolding(const char *str);
 
+int parseFEN(const char *fen);
+
 
 void parseOption(const char *str);         /* parseOption() reads the input
 											that is given to Sunsetter
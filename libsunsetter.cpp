@@ -0,0 +1,328 @@
+/* ***************************************************************************
+ *                                Sunsetter                                  *
+ *               (c) Ben Dean-Kawamura, Georg v. Zimmermann                  *
+ *   For license terms, see the file COPYING that came with this program.    *
+ *                                                                           *
+ *  Name: libsunsetter.cpp                                                   *
+ *  Purpose: Has the functions of the library interface, see libsunsetter.h *
+ *                                                                           *
+ *  Comments: Every call copies the position of its engine to gameBoard and  *
+ * sets the variant, does what the xboard command would do, and copies the   *
+ * position back if it changed.  The searches are done in analyze mode, so   *
+ * nothing is played, reported or put in the hash table as a repetition,    *
+ * and in xboard mode, so output() gives the thinking lines to the engine's  *
+ * info callback.                                                            *
+ *                                                                           *
+ * gameBoard, AIBoard and the rest of what the search works with are         *
+ * SEARCH_LOCAL, so each thread that calls us has its own and the engines of *
+ * different threads search at the same time.  They share the tables, the    *
+ * parameters and the transposition table, whose entries don't age by the    *
+ * moves of one engine (see sharedHashEngines).                              *
+ *                                                                           *
+ *************************************************************************** */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include "libsunsetter.h"
+#include "board.h"
+#include "brain.h"
+#include "bughouse.h"
+#include "notation.h"
+#include "interface.h"
+#include "variables.h"
+
+struct sunsetterEngine {
+	boardStruct board;					/* The position and game history */
+	rules variant;
+
+	sunsetterInfo info;
+	void *infoData;
+	char line[MAX_STRING];				/* The output line so far */
+	int lineLength;
+
+	pthread_mutex_t lock;				/* Held by the call for the engine */
+	volatile int *stop;					/* stopThinking of the thread that
+										   searches for it, or NULL */
+};
+
+static pthread_mutex_t engineLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_rwlock_t tableLock = PTHREAD_RWLOCK_INITIALIZER;
+										/* Written to resize the 
+										   transposition table */
+static int initialized;
+static SEARCH_LOCAL sunsetterEngine *searchingEngine;
+
+extern SEARCH_LOCAL volatile int stopThinking;
+
+
+/* Function: engineOutput
+ * Input:    A string
+ * Output:   None
+ * Purpose:  Is outputHook.  Gives the lines the search prints to the info
+ *           callback of the engine that searches, everything else is
+ *           dropped.
+ */
+
+static void engineOutput(const char *str)
+{
+	sunsetterEngine *engine = searchingEngine;
+
+	if (!engine || !engine->info) return;
+
+	for (; *str; str++)
+	{
+		if (*str == '\n' || *str == '\r')
+		{
+			engine->line[engine->lineLength] = '\0';
+			if (engine->lineLength) engine->info(engine->line, engine->infoData);
+			engine->lineLength = 0;
+		}
+		else if (engine->lineLength < MAX_STRING - 1)
+		{
+			engine->line[engine->lineLength++] = *str;
+		}
+	}
+}
+
+
+/* Function: engineEnter
+ * Input:    The engine a call is for
+ * Output:   None
+ * Purpose:  Waits until the engine is free and sets up this thread's 
+ *           gameBoard and the globals the search looks at for it.
+ */
+
+static void engineEnter(sunsetterEngine *engine)
+{
+	pthread_mutex_lock(&engine->lock);
+	pthread_rwlock_rdlock(&tableLock);
+
+	ignoreInput = 1;
+	analyzeBoard(&engine->board, engine->variant);
+}
+
+
+/* Function: engineLeave
+ * Input:    The engine a call was for, if its position changed
+ * Output:   None
+ * Purpose:  Keeps the position for the engine and lets the next call go.
+ *           The thread may end after the call, so its boards don't keep
+ *           their stacks.
+ */
+
+static void engineLeave(sunsetterEngine *engine, int changed)
+{
+	if (changed) gameBoard.copy(&engine->board);
+
+	gameBoard.freeStacks();
+	AIBoard.freeStacks();
+
+	pthread_rwlock_unlock(&tableLock);
+	pthread_mutex_unlock(&engine->lock);
+}
+
+
+/* Function: sunsetterCreate
+ * Input:    SUNSETTER_CRAZYHOUSE or SUNSETTER_BUGHOUSE
+ * Output:   The new engine, NULL if there is not enough memory
+ * Purpose:  Makes an engine at the start position.  The first one
+ *           initializes Sunsetter.
+ */
+
+sunsetterEngine *sunsetterCreate(int variant)
+{
+	sunsetterEngine *engine;
+
+	engine = (sunsetterEngine *) calloc(1, sizeof(sunsetterEngine));
+	if (!engine) return NULL;
+	engine->variant = (variant == SUNSETTER_BUGHOUSE) ? BUGHOUSE : CRAZYHOUSE;
+	pthread_mutex_init(&engine->lock, NULL);
+
+	pthread_mutex_lock(&engineLock);
+	if (!initialized)
+	{
+		ignoreInput = 1;
+		outputHook = engineOutput;
+		initialize();
+		sharedHashEngines = 1;
+		initialized = 1;
+	}
+	pthread_mutex_unlock(&engineLock);
+
+	/* The engine has no position to copy to gameBoard yet */
+
+	pthread_mutex_lock(&engine->lock);
+	pthread_rwlock_rdlock(&tableLock);
+	gameBoard.resetBoard();
+	if (engine->variant == BUGHOUSE) gameBoard.playBughouse();
+	else gameBoard.playCrazyhouse();
+	engineLeave(engine, 1);
+
+	return engine;
+}
+
+
+/* Function: sunsetterDestroy
+ * Input:    An engine
+ * Output:   None
+ * Purpose:  Frees the engine.
+ */
+
+void sunsetterDestroy(sunsetterEngine *engine)
+{
+	if (!engine) return;
+
+	engine->board.freeStacks();
+	pthread_mutex_destroy(&engine->lock);
+	free(engine);
+}
+
+
+/* Function: sunsetterSetPosition
+ * Input:    An engine and a FEN, NULL for the start position
+ * Output:   0, -1 if the FEN is no good
+ * Purpose:  Sets up a position like xboard's "setboard".  The holdings
+ *           can follow the board as "[Qp]" or after an 8th '/'.
+ */
+
+int sunsetterSetPosition(sunsetterEngine *engine, const char *fen)
+{
+	int result = 0;
+
+	engineEnter(engine);
+	if (engine->variant == BUGHOUSE) gameBoard.playBughouse();
+	else gameBoard.playCrazyhouse();
+	if (fen) result = parseFEN(fen);
+	else gameBoard.resetBoard();
+	engineLeave(engine, !result);
+
+	return result;
+}
+
+
+/* Function: sunsetterSetHoldings
+ * Input:    An engine and the holdings, "[white] [black]"
+ * Output:   0, -1 if they are no good
+ * Purpose:  Sets what is in the hands, like xboard's "holding".
+ */
+
+int sunsetterSetHoldings(sunsetterEngine *engine, const char *holdings)
+{
+	const char *open = strchr(holdings, '[');
+
+	if (!open || !strchr(open + 1, '[') ||
+		holdings[strspn(holdings, "[] PNBRQpnbrq")])
+		return -1;
+
+	engineEnter(engine);
+	parseHolding(holdings);
+	engineLeave(engine, 1);
+
+	return 0;
+}
+
+
+/* Function: sunsetterPlayMove
+ * Input:    An engine and a move
+ * Output:   0, -1 if the move is illegal
+ * Purpose:  Plays a move for the side on move.
+ */
+
+int sunsetterPlayMove(sunsetterEngine *engine, const char *moveString)
+{
+	move m;
+	int illegal;
+
+	engineEnter(engine);
+	m = gameBoard.algebraicMoveToDBMove(moveString);
+	illegal = m.isBad() || gameBoard.playMove(m, 0);
+	engineLeave(engine, !illegal);
+
+	return illegal ? -1 : 0;
+}
+
+
+/* Function: sunsetterSetInfo
+ * Input:    An engine, a function and what to give it
+ * Output:   None
+ * Purpose:  Sets where the lines the engine's searches print go.
+ */
+
+void sunsetterSetInfo(sunsetterEngine *engine, sunsetterInfo info, void *data)
+{
+	pthread_mutex_lock(&engine->lock);
+	engine->info = info;
+	engine->infoData = data;
+	pthread_mutex_unlock(&engine->lock);
+}
+
+
+/* Function: sunsetterSearch
+ * Input:    An engine, the limits, where to put the move and its value
+ * Output:   0 if the move can be played, 1 if it is a drop of a piece we
+ *           would sit for, -1 if there is no legal move
+ * Purpose:  Finds the best move for the side on move.
+ */
+
+int sunsetterSearch(sunsetterEngine *engine, int depth, int milliseconds,
+					char *bestMove, int *value)
+{
+	int result;
+
+	engineEnter(engine);
+
+	engine->lineLength = 0;
+	searchingEngine = engine;
+	pthread_mutex_lock(&engineLock);
+	engine->stop = &stopThinking;
+	pthread_mutex_unlock(&engineLock);
+
+	result = analyzeSearch(depth, milliseconds, bestMove, value);
+
+	pthread_mutex_lock(&engineLock);
+	engine->stop = NULL;
+	pthread_mutex_unlock(&engineLock);
+	searchingEngine = NULL;
+
+	engineLeave(engine, 0);
+
+	return result;
+}
+
+
+/* Function: sunsetterStop
+ * Input:    An engine
+ * Output:   None
+ * Purpose:  If the engine searches it makes it stop.  Doesn't wait for
+ *           the engine's lock, the search holds it.
+ */
+
+void sunsetterStop(sunsetterEngine *engine)
+{
+	pthread_mutex_lock(&engineLock);
+	if (engine->stop) *engine->stop = 1;
+	pthread_mutex_unlock(&engineLock);
+}
+
+
+/* Function: sunsetterSetHashSize
+ * Input:    The size of the transposition table in megabytes
+ * Output:   0, -1 if there is not enough memory
+ * Purpose:  Sets the hash size like xboard's "memory".  Waits for the
+ *           calls that use the table.
+ */
+
+int sunsetterSetHashSize(int megabytes)
+{
+	int result;
+
+	pthread_rwlock_wrlock(&tableLock);
+	result = makeTranspositionTable(megabytes * 1024 * 1024);
+	if (result == -1) makeTranspositionTable(MIN_HASH_SIZE);
+	pthread_rwlock_unlock(&tableLock);
+
+	return result ? -1 : 0;
+}
@@ -0,0 +1,84 @@
+/* ***************************************************************************
+ *                                Sunsetter                                  *
+ *               (c) Ben Dean-Kawamura, Georg v. Zimmermann                  *
+ *   For license terms, see the file COPYING that came with this program.    *
+ *                                                                           *
+ *  Name: libsunsetter.h                                                     *
+ *  Purpose: The C interface of libsunsetter.a ("make libsunsetter.a"),      *
+ *           which lets another program use Sunsetter without talking to    *
+ *           it over a pipe.                                                 *
+ *                                                                           *
+ *  Comments: A program makes one engine for every game.  An engine has its  *
+ * own position, hands, game history and variant.  Every thread has its own  *
+ * search, so engines called from different threads search at the same       *
+ * time.  They share the transposition table and the parameters.  A call     *
+ * for an engine waits until the one before it for that engine is done,      *
+ * only sunsetterStop() can be called while it searches, from any thread.    *
+ * Link with -pthread.                                                       *
+ *                                                                           *
+ * Moves are in Sunsetter's notation, "e2e4", "e7e8q" or "N@f3".  Holdings    *
+ * are "[QNp]" after the board part of a FEN, or "[white] [black]" for     *
+ * sunsetterSetHoldings().                                                   *
+ *                                                                           *
+ *************************************************************************** */
+
+#ifndef _LIBSUNSETTER_
+#define _LIBSUNSETTER_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SUNSETTER_CRAZYHOUSE 0
+#define SUNSETTER_BUGHOUSE 1
+
+#define SUNSETTER_MOVE_SIZE 8     /* Room a move needs, with the 0 */
+
+typedef struct sunsetterEngine sunsetterEngine;
+
+/* Gets the lines the search prints, "depth value centiseconds nodes pv" as
+   in xboard's thinking output.  The value is from white's point of view.
+   Called while the engine searches, so it may only call sunsetterStop() */
+
+typedef void (*sunsetterInfo)(const char *line, void *data);
+
+sunsetterEngine *sunsetterCreate(int variant);
+                                       /* A new engine at the start
+                                          position, NULL if out of memory */
+void sunsetterDestroy(sunsetterEngine *engine);
+
+int sunsetterSetPosition(sunsetterEngine *engine, const char *fen);
+                                       /* NULL is the start position.
+                                          -1 if the FEN is no good */
+int sunsetterSetHoldings(sunsetterEngine *engine, const char *holdings);
+                                       /* -1 if holdings are no good */
+int sunsetterPlayMove(sunsetterEngine *engine, const char *move);
+                                       /* -1 if the move is illegal */
+
+void sunsetterSetInfo(sunsetterEngine *engine, sunsetterInfo info,
+                      void *data);     /* NULL for no info */
+
+int sunsetterSearch(sunsetterEngine *engine, int depth, int milliseconds,
+                    char *bestMove, int *value);
+                                       /* Searches depth plies or the
+                                          time, 0 is no limit.  bestMove
+                                          gets SUNSETTER_MOVE_SIZE chars,
+                                          value is for the side on move.
+                                          0 if the move can be played, 1
+                                          in bughouse if we would sit for
+                                          the piece it drops, -1 if there
+                                          is no legal move */
+void sunsetterStop(sunsetterEngine *engine);
+                                       /* Makes sunsetterSearch() return
+                                          its best move now */
+
+int sunsetterSetHashSize(int megabytes);
+                                       /* For all engines, waits for their
+                                          searches.  -1 if there is not 
+                                          enough memory */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
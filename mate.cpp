@@ -0,0 +1,447 @@
+/* ***************************************************************************
+ *                                Sunsetter                                  *
+ *               (c) Ben Dean-Kawamura, Georg v. Zimmermann                  *
+ *   For license terms, see the file COPYING that came with this program.    *
+ *                                                                           *
+ *  Name: mate.cpp                                                           *
+ *  Purpose: Has proveMate(), a proof number search for forced mates, and    *
+ *           startMateProof() and stopMateProof() to run it next to the      *
+ *           normal search.                                                  *
+ *                                                                           *
+ *  Comments: Crazyhouse games are often decided by long series of checks    *
+ * and checking drops.  Alpha-beta only finds those as deep as the check     *
+ * extensions take it.  proveMate() looks at nothing but checks for the side *
+ * to move and all the evasions for the other side, and always expands the   *
+ * position that is cheapest to prove or disprove (df-pn).  Proof numbers    *
+ * count how many positions still have to be proven to show the mate,        *
+ * disproof numbers how many to show there is none.                          *
+ *                                                                           *
+ * The prover runs on its own thread with its own AIBoard (see SEARCH_LOCAL) *
+ * while searchRoot() searches, and stops the search when it proves a mate.  *
+ * On Windows and in the js build it runs before the search instead.         *
+ *                                                                           *
+ *************************************************************************** */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "board.h"
+#include "brain.h"
+#include "bughouse.h"
+#include "interface.h"
+#include "variables.h"
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#define MATE_THREAD
+#include <pthread.h>
+#endif
+
+#define PROOF_TABLE_SIZE 65536       /* Must be a power of 2 */
+#define PROOF_MAX_PLY    32          /* Mates up to 16 moves deep */
+#define PROOF_INFINITY   100000000
+
+/* proofEntry is what the proof table remembers about a position.  The 
+   table is separate from the transposition table and is cleared for every
+   proveMate() */
+
+struct proofEntry {
+  qword hash;
+  duword pn;                         /* proof number */
+  duword dn;                         /* disproof number */
+  int dist;                          /* Plies to mate once proven */
+};
+
+/* mateProof is a proof started for the search of a thread */
+
+struct mateProof {
+  boardStruct board;                 /* The root, for the prover's AIBoard */
+  volatile int stop;                 /* Set to stop the prover */
+  volatile int *searchStop;          /* stopThinking of the search */
+  int proven;
+  move mateMove;
+  int mateValue;
+#ifdef MATE_THREAD
+  pthread_t thread;
+#endif
+};
+
+extern SEARCH_LOCAL volatile int stopThinking;
+
+static SEARCH_LOCAL mateProof *runningProof;
+static SEARCH_LOCAL volatile int *proofStop;	/* Makes proofMID() stop */
+
+#ifdef MATE_THREAD
+static pthread_mutex_t proofLock = PTHREAD_MUTEX_INITIALIZER;
+									/* For stopping the search */
+#endif
+
+static SEARCH_LOCAL proofEntry proofTable[PROOF_TABLE_SIZE];
+
+static SEARCH_LOCAL move proofMoves[PROOF_MAX_PLY][MAX_MOVES];
+static SEARCH_LOCAL duword proofPn[PROOF_MAX_PLY][MAX_MOVES];
+static SEARCH_LOCAL duword proofDn[PROOF_MAX_PLY][MAX_MOVES];
+static SEARCH_LOCAL int proofDist[PROOF_MAX_PLY][MAX_MOVES];
+static SEARCH_LOCAL int proofCount[PROOF_MAX_PLY];
+
+static SEARCH_LOCAL int proofNodes;
+static SEARCH_LOCAL int proofOutOfNodes;
+
+
+/* Function: proofKey
+ * Input:    None.
+ * Output:   The key of AIBoard in the proof table.
+ * Purpose:  The hash value doesn't have the side to move in it, so flip it 
+ *           when black is to move.
+ */
+
+static qword proofKey()
+{
+	qword key = AIBoard.getHashValue();
+
+	if (AIBoard.getColorOnMove() == BLACK) key = ~key;
+	return key;
+}
+
+
+/* Function: proofStore
+ * Input:    The proof and disproof number and mate distance of AIBoard.
+ * Output:   None.
+ * Purpose:  Remembers them in the proof table, always replacing.
+ */
+
+static void proofStore(duword pn, duword dn, int dist)
+{
+	qword key = proofKey();
+	proofEntry *pe = &proofTable[key & (PROOF_TABLE_SIZE - 1)];
+
+	pe->hash = key;
+	pe->pn = pn;
+	pe->dn = dn;
+	pe->dist = dist;
+}
+
+
+/* Function: proofGenerate
+ * Input:    The ply and if the attacking side is to move.
+ * Output:   The number of moves.
+ * Purpose:  Fills proofMoves[ply] with the legal checks, or with the legal
+ *           evasions, and gets what the proof table knows about the 
+ *           positions they lead to.  Unknown positions start at 1, 1.
+ */
+
+static int proofGenerate(int ply, int attacking)
+{
+	move *m = proofMoves[ply];
+	proofEntry *pe;
+	checkInfo ci;
+	qword key;
+	int n, count, legal = 0, keep;
+
+	if (attacking)
+	{
+		AIBoard.setCheckInfo(&ci);
+		count = AIBoard.captureMoves(m);
+		count += AIBoard.checkingMoves(m + count, &ci);
+	}
+	else 
+	{
+		count = AIBoard.checkEvasionCaptures(m);
+		count += AIBoard.checkEvasionOthers(m + count);
+	}
+
+	for (n = 0; n < count; n++)
+	{
+		AIBoard.changeBoard<CRAZYHOUSE>(m[n]);
+
+		/* Captures that don't check are skipped, and so are moves that
+		   leave the own king in check */
+
+		keep = !AIBoard.isInCheck(AIBoard.getColorOffMove()) &&
+			   (!attacking || AIBoard.isInCheck(AIBoard.getColorOnMove()));
+
+		if (keep)
+		{
+			key = proofKey();
+			pe = &proofTable[key & (PROOF_TABLE_SIZE - 1)];
+			if (pe->hash == key)
+			{
+				proofPn[ply][legal] = pe->pn;
+				proofDn[ply][legal] = pe->dn;
+				proofDist[ply][legal] = pe->dist;
+			}
+			else
+			{
+				proofPn[ply][legal] = proofDn[ply][legal] = 1;
+				proofDist[ply][legal] = 0;
+			}
+		}
+
+		AIBoard.unchangeBoard<CRAZYHOUSE>();
+
+		if (keep) m[legal++] = m[n];
+	}
+
+	return legal;
+}
+
+
+/* Function: proofSum
+ * Input:    The ply, if the attacking side is to move and where to put the
+ *           results.
+ * Output:   None.
+ * Purpose:  Gets the proof and disproof number of a position from the ones
+ *           of its moves.  The attacker needs one move that mates, the 
+ *           defender needs one move that doesn't.  Also finds the move to
+ *           look at next and the second best number, which is how far that
+ *           move can get before another one becomes more promising.
+ */
+
+static void proofSum(int ply, int attacking, duword *pn, duword *dn, 
+					 int *best, duword *second)
+{
+	duword *minOf = attacking ? proofPn[ply] : proofDn[ply];
+	duword *sumOf = attacking ? proofDn[ply] : proofPn[ply];
+	duword minimum = PROOF_INFINITY, sum = 0;
+	int n;
+
+	*best = 0;
+	*second = PROOF_INFINITY;
+
+	for (n = 0; n < proofCount[ply]; n++)
+	{
+		if (minOf[n] < minimum)
+		{
+			*second = minimum;
+			minimum = minOf[n];
+			*best = n;
+		}
+		else if (minOf[n] < *second) *second = minOf[n];
+
+		sum += sumOf[n];
+		if (sum > PROOF_INFINITY) sum = PROOF_INFINITY;
+	}
+
+	if (attacking) { *pn = minimum; *dn = sum; }
+	else { *pn = sum; *dn = minimum; }
+}
+
+
+/* Function: proofMID
+ * Input:    The ply, the thresholds for the proof and disproof number and 
+ *           where to put the proof and disproof number and mate distance.
+ * Output:   None.
+ * Purpose:  Expands AIBoard until its proof or disproof number reaches its
+ *           threshold.  The attacking side is to move on even plies.
+ */
+
+static void proofMID(int ply, duword thPn, duword thDn, 
+					 duword *pn, duword *dn, int *dist)
+{
+	int attacking = !(ply & 1);
+	int n, best;
+	duword second, childThPn, childThDn;
+
+	proofNodes++;
+	if (proofNodes > MATE_NODES || *proofStop) 
+	{
+		proofOutOfNodes = 1;
+		return;
+	}
+
+	proofCount[ply] = proofGenerate(ply, attacking);
+
+	/* No checks means no mate, no evasions means mate */
+
+	if (!proofCount[ply])
+	{
+		*pn = attacking ? PROOF_INFINITY : 0;
+		*dn = attacking ? 0 : PROOF_INFINITY;
+		*dist = 0;
+		proofStore(*pn, *dn, *dist);
+		return;
+	}
+
+	/* Too deep, that depends on the way we got here so don't store it */
+
+	if (ply + 1 >= PROOF_MAX_PLY)
+	{
+		*pn = PROOF_INFINITY;
+		*dn = 0;
+		return;
+	}
+
+	for (;;)
+	{
+		proofSum(ply, attacking, pn, dn, &best, &second);
+		if (*pn >= thPn || *dn >= thDn || proofOutOfNodes) break;
+
+		if (attacking)
+		{
+			childThPn = min(thPn, second + 1);
+			childThDn = thDn - *dn + proofDn[ply][best];
+		}
+		else
+		{
+			childThPn = thPn - *pn + proofPn[ply][best];
+			childThDn = min(thDn, second + 1);
+		}
+
+		AIBoard.changeBoard<CRAZYHOUSE>(proofMoves[ply][best]);
+		proofMID(ply + 1, childThPn, childThDn, 
+			&proofPn[ply][best], &proofDn[ply][best], &proofDist[ply][best]);
+		AIBoard.unchangeBoard<CRAZYHOUSE>();
+	}
+
+	/* The attacker takes the quickest mate, the defender the slowest */
+
+	*dist = 0;
+	if (!*pn)
+	{
+		*dist = attacking ? PROOF_MAX_PLY : 0;
+		for (n = 0; n < proofCount[ply]; n++)
+		{
+			if (proofPn[ply][n]) continue;
+			if (attacking) *dist = min(*dist, proofDist[ply][n] + 1);
+			else *dist = max(*dist, proofDist[ply][n] + 1);
+		}
+	}
+
+	proofStore(*pn, *dn, *dist);
+}
+
+
+/* Function: proveMate
+ * Input:    Where to put the mating move and the value of the mate.
+ * Output:   1 if a forced mate was proven, 0 otherwise.
+ * Purpose:  Runs the proof number search on AIBoard for up to MATE_NODES
+ *           positions, or until *proofStop is set.  The mate is not 
+ *           always the shortest one, so the value is a "mate in so many 
+ *           moves or less".
+ */
+
+static int proveMate(move *mateMove, int *mateValue)
+{
+	duword pn = 1, dn = 1;
+	int dist = 0, n, best;
+
+	if (!MATE_NODES || AIBoard.isInCheck(AIBoard.getColorOnMove())) return 0;
+
+	memset(proofTable, 0, sizeof(proofTable));
+	proofNodes = proofOutOfNodes = 0;
+
+	proofMID(0, PROOF_INFINITY, PROOF_INFINITY, &pn, &dn, &dist);
+
+	if (pn) return 0;
+
+	for (best = -1, n = 0; n < proofCount[0]; n++)
+	{
+		if (!proofPn[0][n] && (best < 0 || proofDist[0][n] < proofDist[0][best]))
+			best = n;
+	}
+
+	*mateMove = proofMoves[0][best];
+	*mateValue = MATE_IN_ONE - 10 * dist;
+	return 1;
+}
+
+
+#ifdef MATE_THREAD
+
+/* Function: mateProofThread
+ * Input:    The proof.
+ * Output:   NULL.
+ * Purpose:  Is the prover thread.  Proves the root of the proof and stops
+ *           the search if there is a mate, unless it is done already.
+ */
+
+static void *mateProofThread(void *data)
+{
+	mateProof *proof = (mateProof *) data;
+
+	proof->board.clone(&AIBoard);
+	proofStop = &proof->stop;
+
+	if (proveMate(&proof->mateMove, &proof->mateValue))
+	{
+		proof->proven = 1;
+
+		pthread_mutex_lock(&proofLock);
+		if (!proof->stop) *proof->searchStop = 1;
+		pthread_mutex_unlock(&proofLock);
+	}
+
+	AIBoard.freeStacks();
+	return NULL;
+}
+
+#endif
+
+
+/* Function: startMateProof
+ * Input:    None.
+ * Output:   None.
+ * Purpose:  Starts proving AIBoard for the search of this thread, called 
+ *           by searchRoot() in crazyhouse.  A mate found stops the search.
+ */
+
+void startMateProof()
+{
+	mateProof *proof;
+
+	if (!MATE_NODES || AIBoard.isInCheck(AIBoard.getColorOnMove())) return;
+
+	proof = (mateProof *) calloc(1, sizeof(mateProof));
+	if (!proof) return;
+	proof->searchStop = &stopThinking;
+
+#ifdef MATE_THREAD
+	AIBoard.clone(&proof->board);
+	if (pthread_create(&proof->thread, NULL, mateProofThread, proof))
+	{
+		proof->board.freeStacks();
+		free(proof);
+		return;
+	}
+#else
+	proofStop = &stopThinking;
+	proof->proven = proveMate(&proof->mateMove, &proof->mateValue);
+	if (proof->proven) stopThinking = 1;
+#endif
+
+	runningProof = proof;
+}
+
+
+/* Function: stopMateProof
+ * Input:    Where to put the mating move and the value of the mate.
+ * Output:   1 if a forced mate was proven, 0 otherwise.
+ * Purpose:  Stops the proof startMateProof() started and waits for it.
+ */
+
+int stopMateProof(move *mateMove, int *mateValue)
+{
+	mateProof *proof = runningProof;
+	int proven;
+
+	if (!proof) return 0;
+	runningProof = NULL;
+
+#ifdef MATE_THREAD
+	pthread_mutex_lock(&proofLock);
+	proof->stop = 1;
+	pthread_mutex_unlock(&proofLock);
+
+	pthread_join(proof->thread, NULL);
+	proof->board.freeStacks();
+#endif
+
+	proven = proof->proven;
+	if (proven)
+	{
+		*mateMove = proof->mateMove;
+		*mateValue = proof->mateValue;
+	}
+
+	free(proof);
+	return proven;
+}
@@ -8,7 +8,9 @@
  *                                                                           *
  *  Comments: moves() generates legal moves.  It uses the moves that         *
  * AIMoves() generates and adds promotion to bishops and rooks.  Then it     *
- * makes sure that none of the moves put the side in check.                  *
+ * drops the ones that leave the side in check, using the checking pieces   *
+ * and the pinned pieces found once for the position, so that only en       *
+ * passant captures have to be played to find out.                          *
  *                                                                           *
  *************************************************************************** */
 
@@ -18,36 +20,153 @@
 #include "variables.h"
 #include "board.h"
 
+#define OFF_MOVE (otherColor(onMove))
+
+/*
+ * Function: lineBlockers
+ * Input:    A king's square, the color of the pieces that might block and 
+ *           the color of the rooks, bishops and queens that might attack
+ * Output:   A bitboard of the blocking pieces
+ * Purpose:  A piece blocks if it is the first piece on a line from the
+ *           king and a rook, bishop or queen that moves along that line is 
+ *           the next one behind it.  With the king's own color these are
+ *           pinned pieces, with the other color they can give discovered 
+ *           check.
+ */
+
+bitboard boardStruct::lineBlockers(square ks, color blocker, color slider)
+   {
+   bitboard found, blockers;
+   square sq;
+
+   blockers = attacksFrom(ROOK, ks) & occupied[blocker];
+   while (blockers.hasBits()) 
+      {
+      sq = firstSquare(blockers.data);
+      blockers.unsetSquare(sq);
+      if ((attacksFrom(ROOK, sq) & squaresPast[ks][sq] & occupied[slider] &
+           (pieces[ROOK] | pieces[QUEEN])).hasBits())
+         found.setSquare(sq);
+      }
+
+   blockers = attacksFrom(BISHOP, ks) & occupied[blocker];
+   while (blockers.hasBits()) 
+      {
+      sq = firstSquare(blockers.data);
+      blockers.unsetSquare(sq);
+      if ((attacksFrom(BISHOP, sq) & squaresPast[ks][sq] & occupied[slider] &
+           (pieces[BISHOP] | pieces[QUEEN])).hasBits())
+         found.setSquare(sq);
+      }
+
+   return found;
+   }
+
 /*
  * Function: moves
  * Input:    None
  * Output:   A array of all the legal moves.
  * Purpose:  Used to generate legal moves.  It gets the move array from 
- *           aiMoves() and sees which one of those are really legal.
- *
+ *           aiMoves() and sees which one of those are really legal:
+ *           - the king can't go to an attacked square, or further along 
+ *             the line of a rook, bishop or queen that checks it.
+ *           - in double check only the king can move.
+ *           - in check the other moves have to capture the checking piece
+ *             or go between it and the king.  The drops are only made to
+ *             the squares in between.
+ *           - a pinned piece has to stay on the line to its king.
+ *           En passant can uncover a check along the rank, so those moves 
+ *           are still played and taken back.
  */
 
 int boardStruct::moves(move *m)
    {
    int n, count, i;
    move aim[MAX_MOVES];
+   bitboard checkers, checkMask, kingMask, pinned, bb;
+   square ks, sq, from, to;
+
+   ks = kingSquare[onMove];
+   checkers = attacksTo(ks) & occupied[OFF_MOVE];
+
+   /* Squares the other pieces may go to, and squares the king may not 
+      go to even if they aren't attacked now because the king itself 
+      blocks the attack */
+
+   checkMask = ~qword(0);
+   kingMask = ~qword(0);
+   bb = checkers;
+   while (bb.hasBits()) 
+      {
+      sq = firstSquare(bb.data);
+      bb.unsetSquare(sq);
+      if (directionPiece[ks][sq] != NONE && position[sq] != PAWN)
+         {
+         checkMask = squaresTo[ks][sq];
+         kingMask &= ~squaresPast[sq][ks];
+         }
+      else checkMask = BitInBB[sq];
+      }
+
+   if (checkers.moreThanOne()) 
+      {
+      /* double check, only king moves */
+
+      count = 0;
+      bb = kingAttacks[ks] & ~occupied[onMove];
+      while (bb.hasBits()) 
+         {
+         sq = firstSquare(bb.data);
+         bb.unsetSquare(sq);
+         aim[count++] = move(ks, sq, KING);
+         }
+      checkMask = qword(0);
+      }
+   else 
+      {
+      /* In check a drop can only go between the king and the checking
+         piece */
 
-  
-   count = captureMoves(aim);
-   orderCaptures(aim); 
-   count += aiMoves(aim + count);
-   count += skippedMoves(aim + count);
+      count = captureMoves(aim);
+      orderCaptures(aim); 
+      count += aiMoves(aim + count, checkMask);
+      count += skippedMoves(aim + count);
+      }
+
+   pinned = lineBlockers(ks, onMove, OFF_MOVE);
 
    i = 0;
    for (n = 0; n < count; n++) 
       {
-      changeBoard(aim[n]);
-      if (!isInCheck(otherColor(onMove))) 
+      from = aim[n].from();
+      to = aim[n].to();
+
+      if (aim[n].moved() == KING) 
+         {
+         if (attacks[OFF_MOVE][to] == 0 && kingMask.squareIsSet(to))
+            m[i++] = aim[n];
+         continue;
+         }
+
+      if (aim[n].moved() == PAWN && to == enPassant && from != IN_HAND)
          {
-         m[i++] = aim[n];
+         changeBoard(aim[n]);
+         if (!isInCheck(otherColor(onMove))) 
+            {
+            m[i++] = aim[n];
+            }
+         unchangeBoard();
+         continue;
          }
-      unchangeBoard();
+
+      if (!checkMask.squareIsSet(to)) 
+         continue;
+
+      if (from != IN_HAND && pinned.squareIsSet(from) && 
+          !(squaresTo[ks][from] | squaresPast[ks][from]).squareIsSet(to))
+         continue;
+
+      m[i++] = aim[n];
       }
    return i;
    }
-
@@ -246,7 +246,6 @@ DEP_CPP_EVALU=\
 	".\brain.h"\
 	".\bughouse.h"\
 	".\definitions.h"\
-	".\evaluate.h"\
 	".\interface.h"\
 	".\variables.h"\
 	
@@ -262,6 +261,55 @@ DEP_CPP_EVALU=\
 # End Source File
 # Begin Source File
 
+SOURCE=.\gentables.cpp
+DEP_CPP_GENTA=\
+	".\board.h"\
+	".\brain.h"\
+	".\definitions.h"\
+	".\evaluate.h"\
+	
+
+!IF  "$(CFG)" == "msvc - Win32 Release"
+
+# Begin Custom Build - Generating tables.cpp
+IntDir=.\Release
+InputPath=.\gentables.cpp
+
+"tables.cpp" : $(SOURCE) "$(INTDIR)" "$(OUTDIR)"
+	cl /nologo /D "_win32_" /Fo"$(IntDir)\\" /Fe"$(IntDir)\gentables.exe" gentables.cpp
+	"$(IntDir)\gentables.exe" tables.cpp
+
+# End Custom Build
+
+!ELSEIF  "$(CFG)" == "msvc - Win32 Debug"
+
+# Begin Custom Build - Generating tables.cpp
+IntDir=.\Debug
+InputPath=.\gentables.cpp
+
+"tables.cpp" : $(SOURCE) "$(INTDIR)" "$(OUTDIR)"
+	cl /nologo /D "_win32_" /Fo"$(IntDir)\\" /Fe"$(IntDir)\gentables.exe" gentables.cpp
+	"$(IntDir)\gentables.exe" tables.cpp
+
+# End Custom Build
+
+!ELSEIF  "$(CFG)" == "msvc - Win32 Profile"
+
+# Begin Custom Build - Generating tables.cpp
+IntDir=.\Profile
+InputPath=.\gentables.cpp
+
+"tables.cpp" : $(SOURCE) "$(INTDIR)" "$(OUTDIR)"
+	cl /nologo /D "_win32_" /Fo"$(IntDir)\\" /Fe"$(IntDir)\gentables.exe" gentables.cpp
+	"$(IntDir)\gentables.exe" tables.cpp
+
+# End Custom Build
+
+!ENDIF 
+
+# End Source File
+# Begin Source File
+
 SOURCE=interface.cpp
 DEP_CPP_INTER=\
 	".\board.h"\
@@ -293,6 +341,49 @@ DEP_CPP_MOVES=\
 	".\variables.h"\
 	
 
+!IF  "$(CFG)" == "msvc - Win32 Release"
+
+!ELSEIF  "$(CFG)" == "msvc - Win32 Debug"
+
+!ELSEIF  "$(CFG)" == "msvc - Win32 Profile"
+
+!ENDIF 
+
+# End Source File
+# Begin Source File
+
+SOURCE=.\mate.cpp
+DEP_CPP_MATE_=\
+	".\board.h"\
+	".\brain.h"\
+	".\bughouse.h"\
+	".\definitions.h"\
+	".\interface.h"\
+	".\variables.h"\
+	
+
+!IF  "$(CFG)" == "msvc - Win32 Release"
+
+!ELSEIF  "$(CFG)" == "msvc - Win32 Debug"
+
+!ELSEIF  "$(CFG)" == "msvc - Win32 Profile"
+
+!ENDIF 
+
+# End Source File
+# Begin Source File
+
+SOURCE=.\nnue.cpp
+DEP_CPP_NNUE_=\
+	".\board.h"\
+	".\brain.h"\
+	".\bughouse.h"\
+	".\definitions.h"\
+	".\interface.h"\
+	".\nnue.h"\
+	".\variables.h"\
+	
+
 !IF  "$(CFG)" == "msvc - Win32 Release"
 
 !ELSEIF  "$(CFG)" == "msvc - Win32 Debug"
@@ -403,6 +494,89 @@ DEP_CPP_SEARC=\
 	".\variables.h"\
 	
 
+!IF  "$(CFG)" == "msvc - Win32 Release"
+
+!ELSEIF  "$(CFG)" == "msvc - Win32 Debug"
+
+!ELSEIF  "$(CFG)" == "msvc - Win32 Profile"
+
+!ENDIF 
+
+# End Source File
+# Begin Source File
+
+SOURCE=.\selfplay.cpp
+DEP_CPP_SELFP=\
+	".\board.h"\
+	".\brain.h"\
+	".\bughouse.h"\
+	".\definitions.h"\
+	".\interface.h"\
+	".\notation.h"\
+	".\variables.h"\
+	
+
+!IF  "$(CFG)" == "msvc - Win32 Release"
+
+!ELSEIF  "$(CFG)" == "msvc - Win32 Debug"
+
+!ELSEIF  "$(CFG)" == "msvc - Win32 Profile"
+
+!ENDIF 
+
+# End Source File
+# Begin Source File
+
+SOURCE=.\server.cpp
+DEP_CPP_SERVE=\
+	".\board.h"\
+	".\brain.h"\
+	".\bughouse.h"\
+	".\definitions.h"\
+	".\interface.h"\
+	".\notation.h"\
+	".\variables.h"\
+	
+
+!IF  "$(CFG)" == "msvc - Win32 Release"
+
+!ELSEIF  "$(CFG)" == "msvc - Win32 Debug"
+
+!ELSEIF  "$(CFG)" == "msvc - Win32 Profile"
+
+!ENDIF 
+
+# End Source File
+# Begin Source File
+
+SOURCE=.\split.cpp
+DEP_CPP_SPLIT=\
+	".\board.h"\
+	".\brain.h"\
+	".\definitions.h"\
+	".\interface.h"\
+	".\notation.h"\
+	".\variables.h"\
+	
+
+!IF  "$(CFG)" == "msvc - Win32 Release"
+
+!ELSEIF  "$(CFG)" == "msvc - Win32 Debug"
+
+!ELSEIF  "$(CFG)" == "msvc - Win32 Profile"
+
+!ENDIF 
+
+# End Source File
+# Begin Source File
+
+SOURCE=.\tables.cpp
+DEP_CPP_TABLE=\
+	".\board.h"\
+	".\brain.h"\
+	".\definitions.h"\
+	
+
 !IF  "$(CFG)" == "msvc - Win32 Release"
 
 !ELSEIF  "$(CFG)" == "msvc - Win32 Debug"
@@ -447,6 +621,28 @@ DEP_CPP_TRANS=\
 	".\variables.h"\
 	
 
+!IF  "$(CFG)" == "msvc - Win32 Release"
+
+!ELSEIF  "$(CFG)" == "msvc - Win32 Debug"
+
+!ELSEIF  "$(CFG)" == "msvc - Win32 Profile"
+
+!ENDIF 
+
+# End Source File
+# Begin Source File
+
+SOURCE=.\tune.cpp
+DEP_CPP_TUNE_=\
+	".\board.h"\
+	".\brain.h"\
+	".\bughouse.h"\
+	".\definitions.h"\
+	".\interface.h"\
+	".\notation.h"\
+	".\variables.h"\
+	
+
 !IF  "$(CFG)" == "msvc - Win32 Release"
 
 !ELSEIF  "$(CFG)" == "msvc - Win32 Debug"
@@ -502,6 +698,10 @@ SOURCE=interface.h
 # End Source File
 # Begin Source File
 
+SOURCE=nnue.h
+# End Source File
+# Begin Source File
+
 SOURCE=notation.h
 # End Source File
 # Begin Source File
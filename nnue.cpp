@@ -0,0 +1,421 @@
+/* ***************************************************************************
+ *                                Sunsetter                                  *
+ *				 (c) Ben Dean-Kawamura, Georg v. Zimmermann                  *
+ *   For license terms, see the file COPYING that came with this program.    *
+ *                                                                           *
+ *  Name: nnue.cpp                                                           *
+ *  Purpose: Has the functions of the optional neural network eval.          *
+ *                                                                           *
+ *  Comments: See nnue.h for how the network and its file look.  The board   *
+ * keeps a stack of accumulators, one for every half-move played since the   *
+ * last nnueRefresh().  Making a move copies the top one and updates it for  *
+ * the pieces that moved, taking the move back just pops it.                 *
+ *                                                                           *
+ *************************************************************************** */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define NNUE_SSE2
+#endif
+
+#include "interface.h"
+#include "definitions.h"
+#include "board.h"
+#include "brain.h"
+#include "bughouse.h"
+#include "nnue.h"
+
+#define OFF_MOVE (otherColor(onMove))
+
+int nnueActive = 0;
+
+static sword hiddenBias[NNUE_HIDDEN];
+static sword inputWeights[NNUE_INPUTS][NNUE_HIDDEN];
+static sword outputWeights[COLORS * NNUE_HIDDEN];   /* int8 in the file */
+static sdword outputBias;
+static sdword outputScale;
+
+
+/* Function: readLittleEndian
+ * Input:    A file and how many bytes to read.
+ * Output:   The signed number read, 0 at the end of the file.
+ * Purpose:  Reads the weights file the same way on every platform.
+ */
+
+static sdword readLittleEndian(FILE *f, int bytes)
+{
+	duword value = 0;
+	int n, ch;
+
+	for (n = 0; n < bytes; n++)
+	{
+		ch = fgetc(f);
+		if (ch == EOF) ch = 0;
+		value |= ((duword) ch) << (8 * n);
+	}
+
+	/* Sign extend 8 and 16 bit numbers */
+
+	if (bytes < 4 && (value & (1 << (8 * bytes - 1))))
+		value |= ~((duword) 0) << (8 * bytes);
+
+	return (sdword) value;
+}
+
+
+/* Function: nnueLoad
+ * Input:    The name of the weights file.
+ * Output:   1 if the network was loaded, 0 if not.
+ * Purpose:  Loads the network.  The old one is kept if this fails.
+ */
+
+int nnueLoad(const char *fileName)
+{
+	static sword newWeights[NNUE_INPUTS][NNUE_HIDDEN];
+	sword newBias[NNUE_HIDDEN];
+	char magic[4];
+	FILE *f;
+	int n, i, ok;
+
+	f = fopen(fileName, "rb");
+	if (!f) return 0;
+
+	ok = (fread(magic, 1, 4, f) == 4) && !memcmp(magic, "SSNN", 4) &&
+		 (readLittleEndian(f, 4) == NNUE_VERSION) &&
+		 (readLittleEndian(f, 4) == NNUE_INPUTS) &&
+		 (readLittleEndian(f, 4) == NNUE_HIDDEN);
+
+	if (!ok) 
+	{
+		fclose(f);
+		return 0;
+	}
+
+	outputScale = readLittleEndian(f, 4);
+
+	for (i = 0; i < NNUE_HIDDEN; i++)
+		newBias[i] = (sword) readLittleEndian(f, 2);
+	for (n = 0; n < NNUE_INPUTS; n++)
+		for (i = 0; i < NNUE_HIDDEN; i++)
+			newWeights[n][i] = (sword) readLittleEndian(f, 2);
+	for (i = 0; i < COLORS * NNUE_HIDDEN; i++)
+		outputWeights[i] = (sword) readLittleEndian(f, 1);
+	outputBias = readLittleEndian(f, 4);
+
+	/* A short file would have read zeros */
+
+	ok = !feof(f);
+	fclose(f);
+	if (!ok) return 0;
+
+	memcpy(hiddenBias, newBias, sizeof(hiddenBias));
+	memcpy(inputWeights, newWeights, sizeof(inputWeights));
+	return 1;
+}
+
+
+/* Function: boardInput
+ * Input:    The color the network looks from and a piece on a square.
+ * Output:   The number of the input.
+ * Purpose:  The inputs are relative to the color looking, black sees the 
+ *           board flipped.
+ */
+
+static inline int boardInput(color view, color c, piece p, square sq)
+{
+	if (view == BLACK) sq ^= 7;        /* flip the rank */
+
+	return ((c ^ view) * (LAST_PIECE - FIRST_PIECE + 1) + p - FIRST_PIECE) 
+		* SQUARES + sq;
+}
+
+
+/* Function: handInput
+ * Input:    The color the network looks from, a piece in hand and how many
+ *           of those the hand has counting this one.
+ * Output:   The number of the input.
+ * Purpose:  Every piece in hand is an input, the second knight is a
+ *           different input than the first.
+ */
+
+static inline int handInput(color view, color c, piece p, int count)
+{
+	return NNUE_BOARD_INPUTS + 
+		(((c ^ view) * (QUEEN - PAWN + 1) + p - PAWN) * NNUE_MAX_IN_HAND) + 
+		count - 1;
+}
+
+
+/* Function: addWeights / subtractWeights
+ * Input:    The neurons of one color and the weights of an input.
+ * Output:   None.
+ * Purpose:  Turns an input on or off.
+ */
+
+static inline void addWeights(sword *v, const sword *w)
+{
+	int i;
+
+#if defined(__AVX2__)
+	for (i = 0; i < NNUE_HIDDEN; i += 16)
+		_mm256_storeu_si256((__m256i *) (v + i), _mm256_add_epi16(
+			_mm256_loadu_si256((__m256i *) (v + i)), 
+			_mm256_loadu_si256((const __m256i *) (w + i))));
+#elif defined(NNUE_SSE2)
+	for (i = 0; i < NNUE_HIDDEN; i += 8)
+		_mm_storeu_si128((__m128i *) (v + i), _mm_add_epi16(
+			_mm_loadu_si128((__m128i *) (v + i)), 
+			_mm_loadu_si128((const __m128i *) (w + i))));
+#else
+	for (i = 0; i < NNUE_HIDDEN; i++) v[i] += w[i];
+#endif
+}
+
+static inline void subtractWeights(sword *v, const sword *w)
+{
+	int i;
+
+#if defined(__AVX2__)
+	for (i = 0; i < NNUE_HIDDEN; i += 16)
+		_mm256_storeu_si256((__m256i *) (v + i), _mm256_sub_epi16(
+			_mm256_loadu_si256((__m256i *) (v + i)), 
+			_mm256_loadu_si256((const __m256i *) (w + i))));
+#elif defined(NNUE_SSE2)
+	for (i = 0; i < NNUE_HIDDEN; i += 8)
+		_mm_storeu_si128((__m128i *) (v + i), _mm_sub_epi16(
+			_mm_loadu_si128((__m128i *) (v + i)), 
+			_mm_loadu_si128((const __m128i *) (w + i))));
+#else
+	for (i = 0; i < NNUE_HIDDEN; i++) v[i] -= w[i];
+#endif
+}
+
+
+/* Function: outputLayer
+ * Input:    The neurons of one color and the output weights for them.
+ * Output:   The sum of the clipped neurons times the weights.
+ * Purpose:  The output layer, this is all eval has to compute.
+ */
+
+static inline sdword outputLayer(const sword *v, const sword *w)
+{
+	int i;
+
+#if defined(__AVX2__)
+	__m256i zero = _mm256_setzero_si256();
+	__m256i clip = _mm256_set1_epi16(NNUE_CLIP);
+	__m256i sum = _mm256_setzero_si256();
+	__m128i sum128;
+
+	for (i = 0; i < NNUE_HIDDEN; i += 16)
+	{
+		__m256i x = _mm256_min_epi16(_mm256_max_epi16(
+			_mm256_loadu_si256((const __m256i *) (v + i)), zero), clip);
+		sum = _mm256_add_epi32(sum, _mm256_madd_epi16(x, 
+			_mm256_loadu_si256((const __m256i *) (w + i))));
+	}
+	sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), 
+		_mm256_extracti128_si256(sum, 1));
+	sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0x4E));
+	sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0xB1));
+	return _mm_cvtsi128_si32(sum128);
+#elif defined(NNUE_SSE2)
+	__m128i zero = _mm_setzero_si128();
+	__m128i clip = _mm_set1_epi16(NNUE_CLIP);
+	__m128i sum = _mm_setzero_si128();
+
+	for (i = 0; i < NNUE_HIDDEN; i += 8)
+	{
+		__m128i x = _mm_min_epi16(_mm_max_epi16(
+			_mm_loadu_si128((const __m128i *) (v + i)), zero), clip);
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(x, 
+			_mm_loadu_si128((const __m128i *) (w + i))));
+	}
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+	return _mm_cvtsi128_si32(sum);
+#else
+	sdword sum = 0;
+
+	for (i = 0; i < NNUE_HIDDEN; i++)
+		sum += min(max(v[i], 0), NNUE_CLIP) * w[i];
+	return sum;
+#endif
+}
+
+
+/* Function: nnueRefresh
+ * Input:    None.
+ * Output:   None.
+ * Purpose:  Computes the accumulator from scratch, called whenever the 
+ *           position is set up other than by making moves.
+ */
+
+void boardStruct::nnueRefresh()
+{
+	if (!nnueActive) return;
+
+	if (!nnueStackSize)
+	{
+		nnueStackSize = MAX_GAME_LENGTH;
+		nnueStack = (nnueAccumulator *) 
+			malloc(nnueStackSize * sizeof(nnueAccumulator));
+		if (!nnueStack)
+		{
+			output("Not enough memory for the network\n");
+			exit(1);
+		}
+	}
+
+	nnueIndex = 0;
+	nnueCompute(&nnueStack[0]);
+}
+
+
+/* Function: nnueCompute
+ * Input:    Where to put the accumulator.
+ * Output:   None.
+ * Purpose:  Adds up the weights of all the inputs of the position.
+ */
+
+void boardStruct::nnueCompute(nnueAccumulator *acc)
+{
+	color c, view;
+	piece p;
+	square sq;
+	int n;
+
+	for (view = WHITE; view <= BLACK; view = (color) (view + 1))
+	{
+		memcpy(acc->v[view], hiddenBias, sizeof(hiddenBias));
+
+		for (sq = 0; sq < SQUARES; sq++)
+		{
+			if (position[sq] == NONE) continue;
+			c = occupied[WHITE].squareIsSet(sq) ? WHITE : BLACK;
+			addWeights(acc->v[view], 
+				inputWeights[boardInput(view, c, position[sq], sq)]);
+		}
+
+		for (c = WHITE; c <= BLACK; c = (color) (c + 1))
+			for (p = PAWN; p <= QUEEN; p = (piece) (p + 1))
+				for (n = 1; n <= min(hand[c][p], NNUE_MAX_IN_HAND); n++)
+					addWeights(acc->v[view], 
+						inputWeights[handInput(view, c, p, n)]);
+	}
+}
+
+
+/* Function: nnuePush
+ * Input:    None.
+ * Output:   None.
+ * Purpose:  Called before a move is made, the updates for the move go to
+ *           a copy of the accumulator.
+ */
+
+void boardStruct::nnuePush()
+{
+	if (nnueIndex + 1 >= nnueStackSize)
+	{
+		nnueStackSize *= 2;
+		nnueStack = (nnueAccumulator *) 
+			realloc(nnueStack, nnueStackSize * sizeof(nnueAccumulator));
+		if (!nnueStack)
+		{
+			output("Not enough memory for the network\n");
+			exit(1);
+		}
+	}
+
+	memcpy(&nnueStack[nnueIndex + 1], &nnueStack[nnueIndex], 
+		sizeof(nnueAccumulator));
+	nnueIndex++;
+}
+
+
+/* Function: nnueAddPiece / nnueRemovePiece
+ * Input:    A color, a piece and a square.
+ * Output:   None.
+ * Purpose:  Updates the accumulator when a piece comes on or leaves the
+ *           board.
+ */
+
+void boardStruct::nnueAddPiece(color c, piece p, square sq)
+{
+	nnueAccumulator *acc = &nnueStack[nnueIndex];
+
+	addWeights(acc->v[WHITE], inputWeights[boardInput(WHITE, c, p, sq)]);
+	addWeights(acc->v[BLACK], inputWeights[boardInput(BLACK, c, p, sq)]);
+}
+
+void boardStruct::nnueRemovePiece(color c, piece p, square sq)
+{
+	nnueAccumulator *acc = &nnueStack[nnueIndex];
+
+	subtractWeights(acc->v[WHITE], inputWeights[boardInput(WHITE, c, p, sq)]);
+	subtractWeights(acc->v[BLACK], inputWeights[boardInput(BLACK, c, p, sq)]);
+}
+
+
+/* Function: nnueAddToHand / nnueRemoveFromHand
+ * Input:    A color and a piece.
+ * Output:   None.
+ * Purpose:  Updates the accumulator after a piece was added to a hand, or
+ *           after one was removed from it.
+ */
+
+void boardStruct::nnueAddToHand(color c, piece p)
+{
+	nnueAccumulator *acc = &nnueStack[nnueIndex];
+
+	if (hand[c][p] > NNUE_MAX_IN_HAND) return;
+	addWeights(acc->v[WHITE], inputWeights[handInput(WHITE, c, p, hand[c][p])]);
+	addWeights(acc->v[BLACK], inputWeights[handInput(BLACK, c, p, hand[c][p])]);
+}
+
+void boardStruct::nnueRemoveFromHand(color c, piece p)
+{
+	nnueAccumulator *acc = &nnueStack[nnueIndex];
+
+	if (hand[c][p] + 1 > NNUE_MAX_IN_HAND) return;
+	subtractWeights(acc->v[WHITE], 
+		inputWeights[handInput(WHITE, c, p, hand[c][p] + 1)]);
+	subtractWeights(acc->v[BLACK], 
+		inputWeights[handInput(BLACK, c, p, hand[c][p] + 1)]);
+}
+
+
+/* Function: nnueEval
+ * Input:    None.
+ * Output:   The value of the position for the side on move.
+ * Purpose:  Runs the output layer of the network on the accumulator.
+ */
+
+int boardStruct::nnueEval()
+{
+	nnueAccumulator *acc = &nnueStack[nnueIndex];
+	sdword sum;
+
+#ifdef DEBUG_NNUE
+	nnueAccumulator fresh;
+
+	nnueCompute(&fresh);
+	if (memcmp(&fresh, acc, sizeof(nnueAccumulator)))
+	{
+		output("NNUE accumulator out of sync\n");
+		exit(1);
+	}
+#endif
+
+	sum = outputBias + 
+		outputLayer(acc->v[onMove], outputWeights) +
+		outputLayer(acc->v[OFF_MOVE], outputWeights + NNUE_HIDDEN);
+
+	return (int) ((sqword) sum * outputScale / (NNUE_CLIP * NNUE_OUTPUT_ONE));
+}
@@ -0,0 +1,55 @@
+/* ***************************************************************************
+ *                                Sunsetter                                  *
+ *				 (c) Ben Dean-Kawamura, Georg v. Zimmermann                  *
+ *   For license terms, see the file COPYING that came with this program.    *
+ *                                                                           *
+ *  Name: nnue.h                                                             *
+ *  Purpose: Has the data structures of the optional neural network eval.    *
+ *                                                                           *
+ *  Comments: The network has one input for every piece on every square     *
+ * and one for every piece in hand (the nth knight in hand is its own        *
+ * input).  They are seen from the point of view of each color, with the     *
+ * board flipped for black, and feed NNUE_HIDDEN neurons per color.  Those   *
+ * are kept up to date as pieces move (the accumulator), so eval only has    *
+ * to run the small output layer.                                            *
+ *                                                                           *
+ * The weights file (little endian) is:                                      *
+ *   "SSNN", version, inputs, hidden, scale             (4 + 4 x int32)      *
+ *   hidden bias                                        (hidden x int16)     *
+ *   input weights, input by input                      (inputs x hidden     *
+ *                                                       x int16)            *
+ *   output weights, own side first                     (2 x hidden x int8)  *
+ *   output bias                                        (int32)              *
+ * The eval is (output * scale) / (NNUE_CLIP * NNUE_OUTPUT_ONE) centipawns.  *
+ *                                                                           *
+ *************************************************************************** */
+
+#ifndef _NNUE_
+#define _NNUE_
+
+#include "board.h"
+
+#define NNUE_VERSION 1
+
+#define NNUE_HIDDEN 256           /* Neurons per color, multiple of 16 */
+#define NNUE_MAX_IN_HAND 16       /* Inputs per piece type in hand */
+
+#define NNUE_BOARD_INPUTS (COLORS * (LAST_PIECE - FIRST_PIECE + 1) * SQUARES)
+#define NNUE_HAND_INPUTS (COLORS * (QUEEN - PAWN + 1) * NNUE_MAX_IN_HAND)
+#define NNUE_INPUTS (NNUE_BOARD_INPUTS + NNUE_HAND_INPUTS)
+
+#define NNUE_CLIP 127             /* Hidden neurons are clipped to 0..127 */
+#define NNUE_OUTPUT_ONE 64        /* An output weight of 1.0 */
+
+/* nnueAccumulator has the hidden neurons of a position, seen from both
+   colors */
+
+struct nnueAccumulator {
+  sword v[COLORS][NNUE_HIDDEN];
+};
+
+extern int nnueActive;            /* If a network is loaded and used */
+
+int nnueLoad(const char *fileName);
+
+#endif
@@ -20,9 +20,9 @@
 
 
 
-qword valueToSquares [SQUARES][PIECES][COLORS][2]; 
+SEARCH_LOCAL qword valueToSquares [SQUARES][PIECES][COLORS][2]; 
 
-bitboard generateToFirst[PIECES][COLORS][2]; 
+SEARCH_LOCAL bitboard generateToFirst[PIECES][COLORS][2]; 
 
 
 /*
@@ -238,7 +238,7 @@ move *boardStruct::orderCaptures(move *m)
 		// (R should be called minor in crazyhouse) is not considered 
 		// a winning capture. 
 
-		bestCaptureGain[moveNum] = max (0, values[0]);
+		history[moveNum].bestCaptureGain = max (0, values[0]);
 
 		if (values[0] < +20) return m;
 		else return m + count;
@@ -262,7 +262,7 @@ move *boardStruct::orderCaptures(move *m)
 		}
 	} while(!done);
 
-	bestCaptureGain[moveNum] = max (0, values[0]);
+	history[moveNum].bestCaptureGain = max (0, values[0]);
 
 	if (values[0] < +20)
 		return m;
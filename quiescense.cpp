@@ -32,18 +32,18 @@
 #ifdef GAMETREE
 	extern char filename[MAX_STRING][DEPTH_LIMIT]; 
 	extern FILE *fi[DEPTH_LIMIT];
-	extern int currentDepth;
+	extern SEARCH_LOCAL int currentDepth;
 #endif
 
-extern int stats_quiescensePositionsSearched;  
-extern volatile int stopThinking;        
+extern SEARCH_LOCAL int stats_quiescensePositionsSearched;  
+extern SEARCH_LOCAL volatile int stopThinking;        
 
 
 /* Get a place to store the moves.  They used to 
    be in a local array, but that blew up the stack */
 
 
-extern move searchMoves[DEPTH_LIMIT][MAX_MOVES]; 
+extern SEARCH_LOCAL move searchMoves[DEPTH_LIMIT][MAX_MOVES]; 
 
 
 /*
@@ -55,9 +55,14 @@ extern move searchMoves[DEPTH_LIMIT][MAX_MOVES];
  *           evaluation or the evaluation after a capture has been made,
  *           whichever is better for the player to move.  It doesn't search
  *           deeper than MAX_QUIESCE_SEARCH_DEPTH
+ *           Only captures that win material by captureGain() are tried
+ *           (see orderCaptures()), and of those the ones that can't bring
+ *           the evaluation back to alpha are skipped (delta pruning).  The
+ *           captured piece counts twice since it goes to the hand.
+ *           It is instantiated for both variants, see search().
  */
 
-int quiesce(int alpha, int beta, int ply)
+template <rules R> int quiesce(int alpha, int beta, int ply)
 {
    int best, value;
    move *end, *current, *m;   
@@ -112,7 +117,7 @@ assert (ply <= DEPTH_LIMIT);
 		fclose(fi[ply]); 
 	 }
 #endif
-	 return AIBoard.eval();
+	 return AIBoard.eval<R>();
    }
 
 
@@ -148,12 +153,12 @@ assert (ply <= DEPTH_LIMIT);
 		fprintf(fi[ply],"<br>Return: no more captures or max depth<br></td></tr></table></html>\n");
 		fclose(fi[ply]); }
 #endif 
-      return AIBoard.eval();
+      return AIBoard.eval<R>();
    }
 
    stats_quiescensePositionsSearched++;
       
-   best = AIBoard.eval(); 	
+   best = AIBoard.eval<R>(); 	
 
    end = AIBoard.orderCaptures(m);
 
@@ -166,9 +171,15 @@ assert (ply <= DEPTH_LIMIT);
 
 assert (!AIBoard.badMove(*current));  
 
-		AIBoard.changeBoard(*current);
-		value = -quiesce(-beta, -alpha, ply + 1);
-		AIBoard.unchangeBoard();	
+		if ((DELTA_MARGIN) && (AIBoard.pieceOnSquare(current->to()) != NONE) &&
+			(best + 2 * pValue[AIBoard.pieceOnSquare(current->to())] + DELTA_MARGIN <= alpha))
+		{
+			continue; 
+		}
+
+		AIBoard.changeBoard<R>(*current);
+		value = -quiesce<R>(-beta, -alpha, ply + 1);
+		AIBoard.unchangeBoard<R>();	
 
 assert (value >= -INFINITY);
 assert (value <= INFINITY); 
@@ -205,3 +216,21 @@ assert (value <= INFINITY);
 	return best;
 }
 
+
+template int quiesce<BUGHOUSE>(int alpha, int beta, int ply);
+template int quiesce<CRAZYHOUSE>(int alpha, int beta, int ply);
+
+
+/*
+ * Function: quiesce
+ * Input:    alpha, beta and the current ply
+ * Output:   None
+ * Purpose:  quiesce<R>() for callers outside the search, like tune.
+ */
+
+int quiesce(int alpha, int beta, int ply)
+{
+	if (currentRules == CRAZYHOUSE) return quiesce<CRAZYHOUSE>(alpha, beta, ply);
+	return quiesce<BUGHOUSE>(alpha, beta, ply);
+}
+
@@ -28,6 +28,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 #include "board.h"
 #include "brain.h"
@@ -36,48 +37,54 @@
 #include "interface.h"
 
 
-PrincipalVariation pv;                /* The principal variation, there needs
+SEARCH_LOCAL PrincipalVariation pv;                /* The principal variation, there needs
                                          to be a separate one for each ply that
                                          is searched */
 
-move searchMoves[DEPTH_LIMIT][MAX_MOVES]; /* Where to store the moves.  They
+SEARCH_LOCAL move searchMoves[DEPTH_LIMIT][MAX_MOVES]; /* Where to store the moves.  They
                                              used to be in a local array, but
                                              that blew up the stack */
-boardStruct AIBoard;                 /* The board that the AI uses */
-volatile int stopThinking;           /* If the search should be stopped */
-volatile int reSearch;               /* If the search should be restarted */
-volatile int forceMove;              /* Make a move, even if you get mated*/
-double millisecondsPerMove;             /* How many millisecs to take on a move */
-int stats_positionsSearched;               /* # of search() done */
-int stats_quiescensePositionsSearched;     /* # of quieses() done */
-int stats_transpositionHits;               /* # of success for transposition lookups*/
-int stats_hashFillingUp; 
-int stats_hashSize;
+SEARCH_LOCAL boardStruct AIBoard;                 /* The board that the AI uses */
+SEARCH_LOCAL volatile int stopThinking;           /* If the search should be stopped */
+SEARCH_LOCAL volatile int reSearch;               /* If the search should be restarted */
+SEARCH_LOCAL volatile int forceMove;              /* Make a move, even if you get mated*/
+SEARCH_LOCAL double millisecondsPerMove;             /* How many millisecs to take on a move */
+SEARCH_LOCAL int stats_positionsSearched;               /* # of search() done */
+SEARCH_LOCAL int stats_quiescensePositionsSearched;     /* # of quieses() done */
+SEARCH_LOCAL int stats_transpositionHits;               /* # of success for transposition lookups*/
+SEARCH_LOCAL int stats_hashFillingUp; 
+SEARCH_LOCAL int stats_hashSize;
 
 const int FractionalDeep [MAX_SEARCH_DEPTH+1] = { 0, 0, ONE_PLY, ONE_PLY * 2, ONE_PLY * 3, ONE_PLY * 4, ONE_PLY * 5, ONE_PLY * 6, ONE_PLY * 7, ONE_PLY * 8, ONE_PLY * 9, ONE_PLY * 10, ONE_PLY * 11, ONE_PLY * 12, ONE_PLY * 13, ONE_PLY * 14, ONE_PLY * 15, ONE_PLY * 16, ONE_PLY * 17, ONE_PLY * 18, ONE_PLY * 19, ONE_PLY * 20, ONE_PLY * 21, ONE_PLY * 22, ONE_PLY * 23, ONE_PLY * 24, ONE_PLY * 25, ONE_PLY * 26, ONE_PLY * 27, ONE_PLY * 28, ONE_PLY * 29, ONE_PLY * 30 };
 		/* The implementation allows to experiment with fractional deepening, for example smaller steps at higher depths*/
 
 
 
-int initialTime;
-int currentDepth; 
-int movesSearched;
+SEARCH_LOCAL int initialTime;
+SEARCH_LOCAL int currentDepth; 
+SEARCH_LOCAL int movesSearched;
+
+int lmrTable[MAX_SEARCH_DEPTH][LMR_TABLE_MOVES]; /* Late move reductions in
+                                         fractions of ONE_PLY, by plies left
+                                         and quiet moves already searched */
 
 
 
 
 #ifdef DEBUG_STATS
 
-int stats_forceext, stats_checkext, stats_capext;  
-int stats_NullTries[DEPTH_LIMIT], stats_NullCuts[DEPTH_LIMIT]; 
-int stats_RazorTries, stats_Razors; 
-int stats_MakeUnmake[MOVEGEN_TYPES]; 
+SEARCH_LOCAL int stats_forceext, stats_checkext, stats_capext;  
+SEARCH_LOCAL int stats_NullTries[DEPTH_LIMIT], stats_NullCuts[DEPTH_LIMIT]; 
+SEARCH_LOCAL int stats_RazorTries, stats_Razors; 
+SEARCH_LOCAL int stats_FutilityPrunes, stats_ReverseFutilityCuts; 
+SEARCH_LOCAL int stats_Reductions, stats_ReductionResearches; 
+SEARCH_LOCAL int stats_MakeUnmake[MOVEGEN_TYPES]; 
 
 #endif
 
 /* Time */
-clock_t startClockply, startClockAnalyze; 
-clock_t startClockTime, endClockTime; 
+SEARCH_LOCAL clock_t startClockply, startClockAnalyze; 
+SEARCH_LOCAL clock_t startClockTime, endClockTime; 
 
 
 #ifdef GAMETREE
@@ -87,11 +94,58 @@ clock_t startClockTime, endClockTime;
 #endif
 
 
-move overideMove;						/* If legal, this move is played instead
+SEARCH_LOCAL move overideMove;						/* If legal, this move is played instead
                                         of what the search found */
 
-int pondering;							/* If we're pondering */
-int tryToPonder;						/* If we should be pondering */
+SEARCH_LOCAL int pondering;							/* If we're pondering */
+SEARCH_LOCAL int tryToPonder;						/* If we should be pondering */
+static SEARCH_LOCAL int newHands;					/* If the hands changed while we 
+                                           pondered or searched */
+static SEARCH_LOCAL int findingMove;					/* If findMove() is searching */
+
+/* When the hands change while findMove() searches, the search is 
+   resumed with the new hands from what searchRoot() had */
+
+static SEARCH_LOCAL int resumeDepth;
+static SEARCH_LOCAL int resumeValue;
+static SEARCH_LOCAL move resumeMoves[MAX_MOVES];
+static SEARCH_LOCAL int resumeCount;
+
+/* In analyze mode what searchRoot() found is kept for each position, so 
+   going back to a position goes on from there even if its hash table 
+   entry was overwritten */
+
+struct analysisEntry {
+  qword hash;
+  color onMove;
+  int depth;                            /* Plies */
+  int value;
+  move best;
+};
+
+#define ANALYSIS_CACHE_SIZE 1024        /* Must be a power of 2 */
+
+static SEARCH_LOCAL analysisEntry analysisCache[ANALYSIS_CACHE_SIZE];
+
+/* While we sit for a piece, the hands the partner could send us are 
+   searched and remembered here, see speculate() */
+
+struct speculation {
+  qword key;                            /* gameBoard's hash with that hand */
+  int ghosts;                           /* If it was searched with ghost 
+                                           pieces */
+  move best;
+  int value;
+};
+
+#define SPECULATIONS 6                  /* The hand we have, and with one 
+                                           more P, N, B, R or Q */
+
+static SEARCH_LOCAL speculation speculations[SPECULATIONS];
+static SEARCH_LOCAL int speculationCount;
+static SEARCH_LOCAL int speculating;                 /* If speculate() is searching */
+static SEARCH_LOCAL qword speculationHash;           /* What it started with */
+static SEARCH_LOCAL int speculationState;
 
 
 /* Function: PrincipalVariation::save
@@ -294,6 +348,12 @@ void calcTimeToSpend()
 
 
 
+	if (FIXED_TIME)
+	{
+		millisecondsPerMove = FIXED_TIME;
+		return;
+	}
+
 	if ((FIXED_DEPTH) || (analyzeMode))
 
 	{
@@ -339,6 +399,7 @@ void calcTimeToSpend()
  *           no matter how high/low it is.
  */
 
+template <rules R>
 int searchFirstMove(move m, int depth, int guess)
 {
   int learnValue; 
@@ -353,7 +414,7 @@ assert (guess >= -INFINITY);
 assert (guess <= INFINITY); 
 assert (!AIBoard.badMove(m));
 
-  AIBoard.changeBoard(m);
+  AIBoard.changeBoard<R>(m);
 
   learnValue = AIBoard.checkLearnTable(); 
   
@@ -373,9 +434,9 @@ assert (!AIBoard.badMove(m));
 #endif
 
   
-  value = learnValue -search(-beta+ learnValue, -alpha+ learnValue, depth - ONE_PLY, 1, 0);
+  value = learnValue -search<R>(-beta+ learnValue, -alpha+ learnValue, depth - ONE_PLY, 1, 0);
 
-   AIBoard.unchangeBoard();
+   AIBoard.unchangeBoard<R>();
 
    if(stopThinking) return 0;
 
@@ -387,12 +448,12 @@ assert (!AIBoard.badMove(m));
     beta = INFINITY;
 
 assert (!AIBoard.badMove(m));    
-	AIBoard.changeBoard(m);
+	AIBoard.changeBoard<R>(m);
 
 	// not -beta + learnValue, since -beta = -INFINITY and we can't allow that to get smaller !
-	value = learnValue -search(-beta, -alpha+learnValue, depth - ONE_PLY, 1, 0);
+	value = learnValue -search<R>(-beta, -alpha+learnValue, depth - ONE_PLY, 1, 0);
 
-    AIBoard.unchangeBoard();
+    AIBoard.unchangeBoard<R>();
 
     if(stopThinking) return 0;
 
@@ -406,12 +467,12 @@ assert (!AIBoard.badMove(m));
     alpha = -INFINITY; 
     
 assert (!AIBoard.badMove(m));	
-	AIBoard.changeBoard(m);
+	AIBoard.changeBoard<R>(m);
 	
 	// not -alpha + learnValue
-	value = learnValue -search(-beta+learnValue, -alpha, depth - ONE_PLY, 1, 0);
+	value = learnValue -search<R>(-beta+learnValue, -alpha, depth - ONE_PLY, 1, 0);
 
-    AIBoard.unchangeBoard();
+    AIBoard.unchangeBoard<R>();
 
     if(stopThinking) return 0;
    
@@ -435,6 +496,7 @@ assert (!AIBoard.badMove(m));
  *           since it already knows that there is a better move.  
  */
 
+template <rules R>
 int searchMove(move m, int depth, int alpha)
 {
 
@@ -453,7 +515,7 @@ assert (alpha <= INFINITY);
 assert (depth <= MAX_SEARCH_DEPTH * ONE_PLY);  
 assert (!AIBoard.badMove(m));  
   
-  AIBoard.changeBoard(m);
+  AIBoard.changeBoard<R>(m);
 
   learnValue = AIBoard.checkLearnTable(); 
   millisecondsPerMove -= learnValue *4; 
@@ -501,9 +563,9 @@ assert (!AIBoard.badMove(m));
 	  }
 
  
-  value = learnValue -search(-beta+learnValue, -alpha+learnValue, depth - ONE_PLY + razor , 1, 0);
+  value = learnValue -search<R>(-beta+learnValue, -alpha+learnValue, depth - ONE_PLY + razor , 1, 0);
 
-  AIBoard.unchangeBoard();
+  AIBoard.unchangeBoard<R>();
 
   if(stopThinking) return 0;
 
@@ -515,12 +577,12 @@ assert (!AIBoard.badMove(m));
   beta = INFINITY;
 
 assert (!AIBoard.badMove(m));
-  AIBoard.changeBoard(m);
+  AIBoard.changeBoard<R>(m);
 
   // not -beta + learnValue, since -beta = -INFINITY and we can't allow that to get smaller !
-  value = learnValue -search(-beta, -alpha+learnValue, depth - ONE_PLY + razor, 1, 0);
+  value = learnValue -search<R>(-beta, -alpha+learnValue, depth - ONE_PLY + razor, 1, 0);
 
-  AIBoard.unchangeBoard();
+  AIBoard.unchangeBoard<R>();
 
   if(stopThinking) return 0;  
 
@@ -529,6 +591,243 @@ assert (!AIBoard.badMove(m));
 }
 
 
+/* Function: searchWindow
+ * Input:    What the move is, how deep to search, alpha and beta.
+ * Output:   That value of the position after the move.
+ * Purpose:  Does one of the searches of searchMove(), with the same 
+ *           reduction for quiet moves.  beta is alpha + 1 for the null 
+ *           window or INFINITY for the search after a fail high.  Used 
+ *           for the root moves searchSplit() hands to the workers.
+ */
+
+template <rules R>
+static int searchWindow(move m, int depth, int alpha, int beta)
+{
+  int learnValue, razor, value;
+
+assert (!AIBoard.badMove(m));
+
+  AIBoard.changeBoard<R>(m);
+
+  learnValue = AIBoard.checkLearnTable(); 
+
+  if ((AIBoard.isInCheck(AIBoard.getColorOnMove())) 
+	  || (AIBoard.highestAttacked(m.to()))
+	  || (AIBoard.escapingAttack(m.from(), m.to())))
+	  razor = 0;
+  else
+	  razor = -ONE_PLY / 2;
+
+  // not -beta + learnValue if beta is INFINITY, like in searchMove()
+  value = learnValue -search<R>((beta >= INFINITY) ? -INFINITY : -beta + learnValue, 
+	  -alpha + learnValue, depth - ONE_PLY + razor, 1, 0);
+
+  AIBoard.unchangeBoard<R>();
+
+  if(stopThinking) return 0;
+
+  return value;
+}
+
+
+/* Function: readPrincipalVar
+ * Input:    A principal variation a worker sent, as text.
+ * Output:   None.
+ * Purpose:  Makes it the principal variation of AIBoard, as far as the
+ *           moves in it can be played.
+ */
+
+static void readPrincipalVar(const char *pvText)
+{
+  char buf[MAX_STRING];
+  int n, length;
+  move m;
+
+  pv.depth[0] = 0;
+  while ((pv.depth[0] < DEPTH_LIMIT) && 
+	  (sscanf(pvText, "%s%n", buf, &length) == 1))
+  {
+	  pvText += length;
+	  m = AIBoard.algebraicMoveToDBMove(buf);
+	  if (!AIBoard.isPseudoLegal(m)) break;
+
+	  pv.moves[0][pv.depth[0]++] = m;
+	  AIBoard.changeBoard(m);
+  }
+
+  for (n = 0; n < pv.depth[0]; n++) AIBoard.unchangeBoard();
+}
+
+
+/* Function: searchSplit
+ * Input:    How many root moves there are, how deep to search, the values
+ *           of the moves, the best move and its value.
+ * Output:   None.
+ * Purpose:  Does what searchRoot() does for the moves after the first one,
+ *           with the moves handed to the workers of split.cpp.  A worker 
+ *           first only sees if its move is better than the best one so far
+ *           (the null window of searchMove()).  If it is, the move is 
+ *           searched again with an open window before any new moves are
+ *           handed out.  If the best value went up while a move was 
+ *           searched and the move failed high on the old one, it's tried
+ *           again with the new one.  A worker that is done gets the next 
+ *           move, so they are all busy however long each move takes.  
+ *           If there are no workers left or one couldn't search its move,
+ *           the moves are searched here.
+ */
+
+template <rules R>
+static void searchSplit(int count, int depth, int *values, move *rightMove,
+						int *bestValue)
+{
+  int alphas[MAX_MOVES], betas[MAX_MOVES];
+  int again[MAX_MOVES];                 /* Moves to search again */
+  int againCount, next, running, worker, job, value, nodes, answer;
+  char pvText[MAX_STRING];
+
+  next = 1; 
+  againCount = running = 0;
+
+  while ((next < count) || againCount || running)
+  {
+	  // hand out the moves to search again first
+
+	  while (((worker = splitIdleWorker()) != -1) && (againCount || (next < count)))
+	  {
+		  if (againCount) job = again[--againCount];
+		  else 
+		  {
+			  job = movesSearched = next++;
+			  alphas[job] = *bestValue;
+			  betas[job] = *bestValue + 1;
+		  }
+		  splitSend(worker, job, searchMoves[0][job], depth, alphas[job], betas[job]);
+		  running++;
+	  }
+
+	  if (running)
+	  {
+		  answer = splitReceive(&job, &value, &nodes, pvText);
+
+		  if (checkInput()) checkSpeculation();
+		  if (stopThinking) break;
+
+		  if (!answer) continue;
+		  running--;
+
+		  if (answer == -1)
+		  {
+			  again[againCount++] = job;
+			  continue;
+		  }
+		  if (answer == 2)
+		  {
+			  value = searchWindow<R>(searchMoves[0][job], depth, alphas[job], betas[job]);
+			  if (stopThinking) break;
+
+			  pvText[0] = '\0';
+		  }
+		  else stats_positionsSearched += nodes;
+	  }
+	  else
+	  {
+		  // all workers are gone
+
+		  if (againCount) job = again[--againCount];
+		  else 
+		  {
+			  job = movesSearched = next++;
+			  alphas[job] = *bestValue;
+			  betas[job] = *bestValue + 1;
+		  }
+		  value = searchWindow<R>(searchMoves[0][job], depth, alphas[job], betas[job]);
+		  if (stopThinking) break;
+
+		  pvText[0] = '\0';
+	  }
+
+	  values[job] = value;
+
+	  // a fail high of the null window
+
+	  if ((value > alphas[job]) && (betas[job] < INFINITY))
+	  {
+		  if (value > *bestValue)
+		  {
+			  alphas[job] = value;
+			  betas[job] = INFINITY;
+		  }
+		  else
+		  {
+			  alphas[job] = *bestValue;
+			  betas[job] = *bestValue + 1;
+		  }
+		  again[againCount++] = job;
+		  continue;
+	  }
+
+	  //  We have a new best move, let's save it 
+
+	  if (value > *bestValue)
+	  {
+		  *rightMove = searchMoves[0][job];
+		  *bestValue = value;
+		  if (pvText[0]) readPrincipalVar(pvText);
+		  else savePrincipalVar(*rightMove, 1);
+		  printPrincipalVar(*bestValue);
+	  }
+  }
+
+  if (running) splitCancel();
+  movesSearched = count - 1;
+}
+
+
+
+/* Function: rememberAnalysis
+ * Input:    How deep AIBoard was searched, its value and the best move.
+ * Output:   None.
+ * Purpose:  Keeps what an iteration of searchRoot() found in analyze mode.
+ */
+
+static void rememberAnalysis(int depth, int value, move best)
+{
+	analysisEntry *ae;
+	
+	ae = &analysisCache[AIBoard.getHashValue() & (ANALYSIS_CACHE_SIZE - 1)];
+	ae->hash = AIBoard.getHashValue();
+	ae->onMove = AIBoard.getColorOnMove();
+	ae->depth = depth;
+	ae->value = value;
+	ae->best = best;
+}
+
+
+/* Function: recallAnalysis
+ * Input:    None.
+ * Output:   None.
+ * Purpose:  If AIBoard was analyzed before and the hash table doesn't know
+ *           that any more, it's stored there again.  searchRoot() then 
+ *           goes on one ply deeper than before.
+ */
+
+static void recallAnalysis()
+{
+	analysisEntry *ae;
+	transpositionEntry *te;
+
+	ae = &analysisCache[AIBoard.getHashValue() & (ANALYSIS_CACHE_SIZE - 1)];
+	if ((ae->hash != AIBoard.getHashValue()) || 
+		(ae->onMove != AIBoard.getColorOnMove()) || ae->best.isBad()) return;
+
+	te = AIBoard.lookup();
+	if ((te != NULL) && (te->type == EXACT) && !te->hashMove.isBad() && 
+		(te->depth >= ae->depth * ONE_PLY)) return;
+
+	AIBoard.store(ae->depth * ONE_PLY, ae->best, ae->value, -INFINITY, 
+		+INFINITY);
+}
+
 
 /* Function: searchRoot
  * Input:    How many ply to search and a pointer to a move to fill with the
@@ -540,10 +839,11 @@ assert (!AIBoard.badMove(m));
  *           gets to the maximum depth.
  */
 
+template <rules R>
 void searchRoot(int depth, move *rightMove, int *bestValue )
 {
     
-  int n, done;              /* needed for sorting moves */
+  int n, o, done;           /* needed for sorting moves */
   int bestValueEver, count, startDepth, searchedFirstMove;
   int value = -INFINITY; 
 
@@ -571,7 +871,7 @@ void searchRoot(int depth, move *rightMove, int *bestValue )
   count = AIBoard.moves(searchMoves[0]);  
   
 				// if there is only 1 legal move play it
-  if ((count == 1) && (currentRules == CRAZYHOUSE) &&  (!analyzeMode)) 
+  if ((count == 1) && (R == CRAZYHOUSE) &&  (!analyzeMode)) 
   {
     *rightMove = searchMoves[0][0];
     return;
@@ -585,7 +885,9 @@ void searchRoot(int depth, move *rightMove, int *bestValue )
 	waitForInput();
 	return; 
   }
- 
+
+  if (analyzeMode) recallAnalysis();
+
   if((te = AIBoard.lookup()) != NULL) { // We've searched this position before
                                         // and can remember some information
                                         // about it 
@@ -619,6 +921,31 @@ assert (n <= count); // this checks that the hash move we
       *bestValue = te->value;	  
     }
   } 
+
+  /* The hands changed while we searched this move.  Go on with the moves
+     in the order we had them, a few plies below where we were.  The hash
+     values have changed with the hands, so some iterations are needed 
+     to fill in hash moves again */
+
+  if (resumeDepth && !searchedFirstMove)
+  {
+	  for (n = done = 0; n < resumeCount; n++)
+	  {
+		  for (o = done; o < count; o++)
+		  {
+			  if (searchMoves[0][o] == resumeMoves[n]) break;
+		  }
+		  if (o == count) continue;
+
+		  tmp = searchMoves[0][o];
+		  searchMoves[0][o] = searchMoves[0][done];
+		  searchMoves[0][done++] = tmp;
+	  }
+	  startDepth = max(1, resumeDepth - 3);
+	  *bestValue = resumeValue;
+	  *rightMove = searchMoves[0][0];
+  }
+  resumeDepth = 0;
   
   /* this is an easy and nice repetition detection :) 
    * the current position is stored into the hash with how much we'd like a draw (not very much if we higher rated than opp) and a  depth so big it 
@@ -631,6 +958,10 @@ assert (n <= count); // this checks that the hash move we
 
   calcTimeToSpend();
 
+				// look for a forced mate by checks alone while
+				// we search
+  if ((R == CRAZYHOUSE) && (!analyzeMode)) startMateProof();
+
   // do the searches with increasing ply 
 
   for(currentDepth = startDepth;
@@ -654,7 +985,7 @@ assert (n <= count); // this checks that the hash move we
   
 #endif
 
-  if ((currentRules == CRAZYHOUSE) && (*bestValue <= -EXTREME_EVAL) && (currentDepth > 5))
+  if ((R == CRAZYHOUSE) && (*bestValue <= -EXTREME_EVAL) && (currentDepth > 5))
 
   {
 	  millisecondsPerMove *= 2; 
@@ -670,7 +1001,7 @@ assert (n <= count); // this checks that the hash move we
   
   if(!searchedFirstMove) 
   {
-	  value = searchFirstMove(searchMoves[0][0], FractionalDeep[currentDepth], *bestValue);
+	  value = searchFirstMove<R>(searchMoves[0][0], FractionalDeep[currentDepth], *bestValue);
 
 #ifdef GAMETREE
 	  DBMoveToRawAlgebraicMove(searchMoves[0][0], buf);
@@ -700,7 +1031,7 @@ assert (n <= count); // this checks that the hash move we
    * one ply deeper. We keep that move, but we allow some extra time
    * to resolve our problem */
   
-  if ((currentRules == CRAZYHOUSE) 
+  if ((R == CRAZYHOUSE) 
 	  && ((value +80) < values[1]) 
 	  && (currentDepth > 3) 
 	  && (millisecondsPerMove * 4 < gameBoard.getTime(AIBoard.getColorOnMove())) )
@@ -708,13 +1039,17 @@ assert (n <= count); // this checks that the hash move we
 	  millisecondsPerMove *= 2;
   }   
 
-  while(movesSearched < (count-1)) 
+  if (splitWorkers() && (currentDepth >= SPLIT_DEPTH) && (count > 2))
+  {
+	  searchSplit<R>(count, FractionalDeep[currentDepth], values, rightMove, bestValue);
+  }
+  else while(movesSearched < (count-1)) 
   
   {
 	  movesSearched++;
 	  
 	  
-	  value =  searchMove(searchMoves[0][movesSearched], FractionalDeep[currentDepth], *bestValue );	 	  
+	  value =  searchMove<R>(searchMoves[0][movesSearched], FractionalDeep[currentDepth], *bestValue );	 	  
 
       if(stopThinking) break;	
 
@@ -749,6 +1084,9 @@ assert (n <= count); // this checks that the hash move we
       }
     } while(!done);
 
+  if (analyzeMode && !stopThinking) 
+	  rememberAnalysis(currentDepth, *bestValue, *rightMove);
+
   if (((*bestValue > MATE) || (*bestValue < -MATE) || (values[1] < -MATE_IN_ONE + 30)) && (!analyzeMode)) stopThought();
 
   // if we mate, are mated or have only 1 move to escape a short mate, then move now in zh.
@@ -761,6 +1099,36 @@ assert (n <= count); // this checks that the hash move we
   fclose(fi[0]); 
 #endif
 
+}
+
+				// a proven mate stopped the search, play it
+if (stopMateProof(&tmp, &value) && ((value > *bestValue) || rightMove->isBad()))
+{
+	  *rightMove = tmp;
+	  *bestValue = value;
+	  sprintf(buf, "%3d  %6d %6ld%8d  ", (MATE_IN_ONE - *bestValue) / 10, 
+		  *bestValue, (getSysMilliSecs() - startClockTime) / 10, 0);
+	  output(buf);
+	  DBMoveToRawAlgebraicMove(*rightMove, buf);
+	  output(buf);
+	  output(" <proven mate>\n");
+}
+
+if (newHands && findingMove)
+
+{	// Remember how far we got for the search with the new hands
+
+		newHands = 0;
+		resumeDepth = currentDepth;
+		resumeValue = *bestValue;
+		resumeCount = 0;
+		if (!rightMove->isBad()) resumeMoves[resumeCount++] = *rightMove;
+		for (n = 0; n < count; n++)
+		{
+			if (searchMoves[0][n] != *rightMove) 
+				resumeMoves[resumeCount++] = searchMoves[0][n];
+		}
+		return;
 }
 
 if ((*bestValue <= -EXTREME_EVAL) && (! bestMoveLastPly.isBad()) && (!analyzeMode))
@@ -794,6 +1162,10 @@ if ((*bestValue <= -EXTREME_EVAL) && (! bestMoveLastPly.isBad()) && (!analyzeMod
 	output(buf);
 	sprintf(buf,"Razor     : Tries: %d Success: %d\n",stats_RazorTries,stats_Razors);
 	output(buf);
+	sprintf(buf,"Futility  : Pruned: %d Reverse Cuts: %d\n",stats_FutilityPrunes,stats_ReverseFutilityCuts);
+	output(buf);
+	sprintf(buf,"LMR       : Reduced: %d Re-searched: %d\n",stats_Reductions,stats_ReductionResearches);
+	output(buf);
 	sprintf(buf,"Make/Unm  : Hash: %d  All-Captures: %d Winning-Captures: %d \n            MateTries: %d Full: %d \n", (stats_MakeUnmake[HASH_MOVE]), (stats_MakeUnmake[ALL_CAP]), (stats_MakeUnmake[WINNING_CAP]), (stats_MakeUnmake[MATE_TRIES]), (stats_MakeUnmake[ALL_NON_CAP]) );
 	output(buf);
 
@@ -824,39 +1196,151 @@ if ((*bestValue <= -EXTREME_EVAL) && (! bestMoveLastPly.isBad()) && (!analyzeMod
 
 
 
+/* Function: ghostPieces
+ * Input:    None.
+ * Output:   1 if the search should use ghost pieces.
+ * Purpose:  In bughouse we search with one rook, knight and pawn more in 
+ *           each hand, unless the partner sits or told us to go.
+ */
+
+static int ghostPieces()
+{
+	return (currentRules == BUGHOUSE) && (!partsitting) && (!parttoldgo);
+}
+
+
+/* Function: addGhostPieces
+ * Input:    None.
+ * Output:   None.
+ * Purpose:  Puts the ghost pieces into both hands of AIBoard.
+ */
+
+static void addGhostPieces()
+{
+	AIBoard.addPieceToHand(WHITE, ROOK, 1);
+	AIBoard.addPieceToHand(BLACK, ROOK, 1);
+
+	AIBoard.addPieceToHand(WHITE, KNIGHT, 1);
+	AIBoard.addPieceToHand(BLACK, KNIGHT, 1);
+	
+	AIBoard.addPieceToHand(WHITE, PAWN, 1);
+	AIBoard.addPieceToHand(BLACK, PAWN, 1);
+}
+
+
+/* Function: ponderMoves
+ * Input:    An array to fill with moves.
+ * Output:   The number of moves.
+ * Purpose:  Sets up AIBoard for ponder() and generates the opponents 
+ *           moves.  In bughouse AIBoard gets the same ghost pieces 
+ *           findMove() uses, so the positions ponder() puts in the 
+ *           transposition table are the ones we search after his move.
+ *           His ghost piece drops aren't moves he can really make.
+ */
+
+static int ponderMoves(move *m)
+{
+	int n, count, legal = 0;
+
+	gameBoard.clone(&AIBoard);
+	AIBoard.setCheckHistory(0);
+	if (ghostPieces()) addGhostPieces();
+
+	count = AIBoard.moves(m);
+	for (n = 0; n < count; n++)
+	{
+		if ((currentRules == CRAZYHOUSE) || gameBoard.isLegal(m[n]))
+			m[legal++] = m[n];
+	}
+	return legal;
+}
+
+
+/* Function: handsChanged
+ * Input:    None.
+ * Output:   None.
+ * Purpose:  Called by parseHolding() when the hands changed.  If we're
+ *           pondering or searching our move the search is stopped, and
+ *           ponder() or findMove() go on with the new hands.  (When we
+ *           sit, checkSpeculation() takes care of it.)
+ */
+
+void handsChanged()
+{
+	if (pondering || findingMove)
+	{
+		newHands = 1;
+		stopThinking = 1;
+		if (findingMove) reSearch = 1;
+	}
+}
+
+
 /* Function: ponder
  * Input:    None.
  * Output:   None.
  * Purpose:  Called when it's the opponents move.  It just searches
  *           until the opponents move.  This doesn't generate a move, but it
  *           puts information in the transposition tables.
- *			 Only used in Crazyhouse. 
+ *           In bughouse the hands can change while we ponder, then the
+ *           search starts over with the new hands but with the moves in 
+ *           the order it had found.
  */
 
 void ponder()
 {
-	move m[MAX_MOVES], tmp;
+	move m[MAX_MOVES], fresh[MAX_MOVES], tmp;
 
-	int values[MAX_MOVES],  n, count, value, done;
+	int values[MAX_MOVES],  n, o, k, count, freshCount, value, done;
 	int extensions = 0;
 	char buf[MAX_STRING], buf2[MAX_STRING];
 
 	pondering = 1;
-	gameBoard.copy(&AIBoard);
-	AIBoard.setCheckHistory(0);
-
+	newHands = 0;
 
 	stopThinking = 0;
 	currentDepth = 1;
 	stats_hashFillingUp=stats_positionsSearched=0;
 	millisecondsPerMove = 100000000;
-	count = AIBoard.moves(m);
+	count = ponderMoves(m);
 	memset(values, 0, sizeof(values));
 	startClockAnalyze = getSysMilliSecs(); 
 
   
-	while(!stopThinking && currentDepth < MAX_SEARCH_DEPTH)
+	while(currentDepth < MAX_SEARCH_DEPTH)
 	{
+		if (stopThinking)
+		{
+			if (!newHands || !gameInProgress || forceMode ||
+				(gameBoard.getColorOnMove() == gameBoard.getDeepBugColor()))
+				break;
+
+			/* The moves we had keep their order, new drops go after 
+			   them */
+
+			freshCount = ponderMoves(fresh);
+			for (n = k = 0; n < count; n++)
+			{
+				for (o = 0; o < freshCount; o++)
+				{
+					if (fresh[o] == m[n]) break;
+				}
+				if (o == freshCount) continue;
+
+				fresh[o].makeBad();
+				m[k++] = m[n];
+			}
+			for (o = 0; o < freshCount; o++)
+			{
+				if (!fresh[o].isBad()) m[k++] = fresh[o];
+			}
+			count = k;
+			memset(values, 0, sizeof(values));
+
+			newHands = stopThinking = 0;
+			currentDepth = 1;
+		}
+
 		if (currentDepth > 5 && !xboardMode)   
 		{
 			DBMoveToRawAlgebraicMove(m[0],buf2);
@@ -876,6 +1360,8 @@ void ponder()
 
 		for(n = 0; n < count; n++) 
 		{
+			if (currentRules == BUGHOUSE) watchOpponent();
+
 			// moves that are 0.8 pawns worse than the best get searched less
 			// and if they are 1.5 pawns worse, they get even less
 			if (n && (currentDepth > 3)){
@@ -887,8 +1373,12 @@ void ponder()
 		  
 			AIBoard.changeBoard(m[n]);
 
-			values[n] = -search(-INFINITY, +INFINITY,
-				FractionalDeep[currentDepth - 1] + extensions, 1, 1);
+			if (currentRules == CRAZYHOUSE)
+				values[n] = -search<CRAZYHOUSE>(-INFINITY, +INFINITY,
+					FractionalDeep[currentDepth - 1] + extensions, 1, 1);
+			else
+				values[n] = -search<BUGHOUSE>(-INFINITY, +INFINITY,
+					FractionalDeep[currentDepth - 1] + extensions, 1, 1);
 
 			AIBoard.unchangeBoard();
 
@@ -897,7 +1387,7 @@ void ponder()
 
 
     
-		if(stopThinking) break;
+		if(stopThinking) continue;
 
 		/* Sort the moves based on the new values */
 		do {
@@ -941,6 +1431,7 @@ void ponder()
  *
  */
 
+template <rules R>
 void recursiveCheckEvasion(int *alpha, int *beta,int *bestValue, move *bestMove,int depthWithExtensions,int ply,move hashMove)
 
 {
@@ -977,13 +1468,13 @@ void recursiveCheckEvasion(int *alpha, int *beta,int *bestValue, move *bestMove,
 
 
 		assert (!AIBoard.badMove(m[n]));
-		AIBoard.changeBoard(m[n]);
+		AIBoard.changeBoard<R>(m[n]);
 	
 		// Recursive Search call 
 	
-		value = -search(-(*beta), -(*alpha), depthWithExtensions,  ply + 1, 0);
+		value = -search<R>(-(*beta), -(*alpha), depthWithExtensions,  ply + 1, 0);
 
-		AIBoard.unchangeBoard();	
+		AIBoard.unchangeBoard<R>();	
 	
 	
 #ifdef GAMETREE
@@ -1018,15 +1509,46 @@ void recursiveCheckEvasion(int *alpha, int *beta,int *bestValue, move *bestMove,
 
 }
 
+/* Function: initializeReductions
+ * Input:    None
+ * Output:   None
+ * Purpose:  Fills lmrTable[][] from LMR_DIVISOR, the reduction grows with
+ *           the log of the plies left times the log of the moves searched.
+ */
+
+void initializeReductions()
+{
+	int d, n; 
+
+	for (d = 0; d < MAX_SEARCH_DEPTH; d++)
+	{
+		for (n = 0; n < LMR_TABLE_MOVES; n++)
+		{
+			if ((d < 1) || (n < 1) || (!LMR_DIVISOR)) lmrTable[d][n] = 0; 
+			else lmrTable[d][n] = (int) (ONE_PLY * log((double) d) * log((double) n) * 100 / LMR_DIVISOR); 
+		}
+	}
+}
+
+
 /* Function: recursiveFullSearch()
  *
+ * futilityValue is -INFINITY, or eval + futility margin if that is not 
+ * above alpha. Then quiet moves that would get razored are not searched at all,
+ * they only raise bestValue to futilityValue and never become the best move.
  *
+ * Late move reductions : after the first LMR_MOVES moves, razored moves are 
+ * searched with a null window and lmrTable[][] plies less, one ply less than
+ * that if the history has not been good for the to square. If that
+ * comes back above alpha the move is searched again with the normal depth.
  */
 
-int recursiveFullSearch(int *alpha, int *beta, int *bestValue, move *bestMove, int depthWithExtensions, int  ply, move hashMove)
+template <rules R>
+int recursiveFullSearch(int *alpha, int *beta, int *bestValue, move *bestMove, int depthWithExtensions, int  ply, move hashMove, int futilityValue)
 
 {
-		int n, value, count; 
+		int n, value, count, checks, searched = 0, reduction, goodHistory, isCheck; 
+		checkInfo ci; 
 
 
 #ifdef GAMETREE
@@ -1043,15 +1565,33 @@ int recursiveFullSearch(int *alpha, int *beta, int *bestValue, move *bestMove, i
 
 		m = searchMoves[ply]; 
 		
-		count = AIBoard.aiMoves(m); 
+		// checks first, then the rest of the moves without the checks again
+
+		AIBoard.setCheckInfo(&ci); 
+		checks = AIBoard.checkingMoves(m, &ci); 
+		count = checks + AIBoard.aiMoves(m + checks); 
 
 		
 		for ( n = 0; n < count; n++)
 		{
 		if (m[n] == hashMove) continue; 
 
+		if (n < checks) isCheck = 1; 
+		else 
+		{
+			isCheck = AIBoard.givesCheck(m[n], &ci); 
+			
+			// castling is not in checkingMoves()
+			if ((isCheck) && ((m[n].moved() != KING) || (kingAttacks[m[n].from()].squareIsSet(m[n].to()))))
+				continue; 
+		}
+
 assert (!AIBoard.badMove(m[n]));
-		AIBoard.changeBoard(m[n]);	
+		goodHistory = generateToFirst[m[n].moved()][AIBoard.getColorOnMove()]
+			[m[n].from() == IN_HAND].squareIsSet(m[n].to()); 
+
+		AIBoard.changeBoard<R>(m[n]);	
+		searched++; 
 
 		// We don't razor if
 
@@ -1060,7 +1600,7 @@ assert (!AIBoard.badMove(m[n]));
 		stats_MakeUnmake[ALL_NON_CAP]++;
 		#endif
 		
-		if ( (AIBoard.isInCheck(AIBoard.getColorOnMove()))   
+		if ( (isCheck)   
 			// a) we are checking the opp
 			 ||  (AIBoard.highestAttacked(m[n].to())) 
 			// b) we are attacking something with our move thats worth more than or the same as our moved piece, or is less defended. 
@@ -1070,8 +1610,8 @@ assert (!AIBoard.badMove(m[n]));
 		{			
 
 			// Recursive Search call 
-			value = -search(-(*beta), -(*alpha), depthWithExtensions ,  ply + 1, 0);		
-			AIBoard.unchangeBoard();
+			value = -search<R>(-(*beta), -(*alpha), depthWithExtensions ,  ply + 1, 0);		
+			AIBoard.unchangeBoard<R>();
 
 #ifdef GAMETREE			
 		
@@ -1084,15 +1624,60 @@ assert (!AIBoard.badMove(m[n]));
 			}
 #endif	
 		}
+		else if (futilityValue > -INFINITY)	// futile
+		{
+			#ifdef DEBUG_STATS
+			stats_FutilityPrunes++;
+			#endif
+
+			AIBoard.unchangeBoard<R>();
+
+			// the move isn't searched, so it can't be the best move
+			*bestValue = max(*bestValue, futilityValue); 
+			continue; 
+		}
 		else	// razor
 		{			
 			#ifdef DEBUG_STATS
 			stats_Razors++;
 			#endif
 
-			// Recursive Search call 
-			value = -search(-(*beta), -(*alpha), depthWithExtensions - ONE_PLY / 2,  ply + 1, 0);		
-			AIBoard.unchangeBoard();
+			reduction = 0; 
+
+			if ((LMR_MOVES) && (searched > LMR_MOVES))
+			{
+				reduction = lmrTable[min (depthWithExtensions / ONE_PLY, MAX_SEARCH_DEPTH - 1)]
+					[min (searched, LMR_TABLE_MOVES - 1)]; 
+				if ((reduction) && (!goodHistory)) reduction += ONE_PLY; 
+
+				// don't reduce below the full width plies
+				if (depthWithExtensions - ONE_PLY / 2 - reduction < CC_DEPTH * ONE_PLY)
+					reduction = max (depthWithExtensions - ONE_PLY / 2 - CC_DEPTH * ONE_PLY, 0); 
+			}
+
+			if (reduction)
+			{
+				#ifdef DEBUG_STATS
+				stats_Reductions++;
+				#endif
+
+				value = -search<R>(-(*alpha) - 1, -(*alpha), depthWithExtensions - ONE_PLY / 2 - reduction,  ply + 1, 0);
+
+				if ((value > *alpha) && (!stopThinking))
+				{
+					#ifdef DEBUG_STATS
+					stats_ReductionResearches++;
+					#endif
+
+					value = -search<R>(-(*beta), -(*alpha), depthWithExtensions - ONE_PLY / 2,  ply + 1, 0);
+				}
+			}
+			else
+			{
+				// Recursive Search call 
+				value = -search<R>(-(*beta), -(*alpha), depthWithExtensions - ONE_PLY / 2,  ply + 1, 0);		
+			}
+			AIBoard.unchangeBoard<R>();
 
 			#ifdef GAMETREE					
 			if ((tree_positionsSaved < GAMETREE) && (currentDepth == FIXED_DEPTH - 1)) 
@@ -1129,6 +1714,7 @@ assert (!AIBoard.badMove(m[n]));
  *
  */
 
+template <rules R>
 int recursiveSearch(int *alpha, int *beta,int *bestValue, move *bestMove,int depthWithExtensions,int ply,move hashMove,int  searchType)
 
 {
@@ -1183,7 +1769,7 @@ int recursiveSearch(int *alpha, int *beta,int *bestValue, move *bestMove,int dep
 		if (m[n] == hashMove) continue; 
 
 assert (!AIBoard.badMove(m[n]));
-		AIBoard.changeBoard(m[n]);
+		AIBoard.changeBoard<R>(m[n]);
 
 
 	
@@ -1193,9 +1779,9 @@ assert (!AIBoard.badMove(m[n]));
 
 		// Recursive Search call 
 	
-		value = -search(-(*beta), -(*alpha), depthWithExtensions,  ply + 1, 0);
+		value = -search<R>(-(*beta), -(*alpha), depthWithExtensions,  ply + 1, 0);
 
-		AIBoard.unchangeBoard();	
+		AIBoard.unchangeBoard<R>();	
 	
 	
 #ifdef GAMETREE
@@ -1236,13 +1822,14 @@ assert (!AIBoard.badMove(m[n]));
  * and probably should merge this into the main search routine, seems redundant
  */
 
+template <rules R>
 int recursiveHash(int *alpha,int *beta, int *bestValue , move *bestMove,int depthWithExtensions,int ply,move  hashMove)
 
 {
 	int value; 
 
 
-	if (!hashMove.isBad() && AIBoard.isLegal(hashMove) )
+	if (!hashMove.isBad() && AIBoard.isPseudoLegal(hashMove) )
 	{
 		#ifdef GAMETREE
 		if ((tree_positionsSaved < GAMETREE) && (currentDepth == FIXED_DEPTH - 1)) 
@@ -1253,7 +1840,15 @@ int recursiveHash(int *alpha,int *beta, int *bestValue , move *bestMove,int dept
 
 assert (!AIBoard.badMove(hashMove));
 
-		AIBoard.changeBoard(hashMove);
+		AIBoard.changeBoard<R>(hashMove);
+
+		// a hash collision can give a move that leaves the king in check
+
+		if (AIBoard.isInCheck(AIBoard.getColorOffMove()))
+		{
+			AIBoard.unchangeBoard<R>();
+			return 0; 
+		}
 
 		#ifdef DEBUG_STATS
 		stats_MakeUnmake[HASH_MOVE]++;
@@ -1261,9 +1856,9 @@ assert (!AIBoard.badMove(hashMove));
 	
 		// Recursive Search call 
 	
-		value = -search(-(*beta), -(*alpha), depthWithExtensions,  ply + 1, 0);
+		value = -search<R>(-(*beta), -(*alpha), depthWithExtensions,  ply + 1, 0);
 
-		AIBoard.unchangeBoard();	
+		AIBoard.unchangeBoard<R>();	
 	
 	
 #ifdef GAMETREE
@@ -1305,6 +1900,7 @@ assert (!AIBoard.badMove(hashMove));
  *           position.
  */
  
+template <rules R>
 int search(int alpha, int beta, int depth, int ply, int wasNullMove)
 {
   int orgBeta, orgAlpha;	//  set to alpha and beta since those will be adjusted 
@@ -1312,6 +1908,8 @@ int search(int alpha, int beta, int depth, int ply, int wasNullMove)
   int bestValue = -INFINITY; 
   int NullValue;            //  NullValue of the position 
   int Currenteval;          //  Current Static evaluation      
+  int futilityMargin;
+  int futilityValue = -INFINITY;  
 
 
 
@@ -1525,7 +2123,7 @@ assert ( stats_positionsSearched < 1000000000 );  // hoping for the day when
 		#endif	 
 	}
 
-	recursiveCheckEvasion(&alpha, &beta,&bestValue, &bestMove, depth+extensions, ply, hashMove); 				 
+	recursiveCheckEvasion<R>(&alpha, &beta,&bestValue, &bestMove, depth+extensions, ply, hashMove); 				 
   }
   
   /* Not in Check */
@@ -1549,7 +2147,7 @@ assert ( stats_positionsSearched < 1000000000 );  // hoping for the day when
 		
 		
 		
-		bestValue = quiesce(alpha, beta, ply); 
+		bestValue = quiesce<R>(alpha, beta, ply); 
 
 		
 		AIBoard.store(ONE_PLY-1, bestMove, bestValue, orgAlpha, orgBeta);
@@ -1562,6 +2160,38 @@ assert ( stats_positionsSearched < 1000000000 );  // hoping for the day when
 	if (depth > CC_DEPTH * ONE_PLY)
 	{
 	
+	 /* Futility : in the last plies before the selective search a position
+	  * far away from the window won't come back with a quiet move.
+	  * Conditions : no king in danger, no mate scores, not in the middle of 
+	  * an exchange (like standpat).
+	  */
+
+	if ((FUTILITY_MARGIN) && (depth <= (CC_DEPTH + FUTILITY_DEPTH) * ONE_PLY)
+		&& (!wasNullMove) && (beta < EXTREME_EVAL) && (alpha > -EXTREME_EVAL)
+		&& (AIBoard.standpatCondition()) && (AIBoard.futilityCondition()))
+	{
+		futilityMargin = FUTILITY_MARGIN * (depth - CC_DEPTH * ONE_PLY + ONE_PLY) / ONE_PLY;
+		Currenteval = AIBoard.eval<R>();
+
+		if (Currenteval - futilityMargin >= beta)
+		{
+			#ifdef DEBUG_STATS
+			stats_ReverseFutilityCuts++;
+			#endif
+
+			#ifdef GAMETREE
+			if ((tree_positionsSaved < GAMETREE) && (currentDepth == FIXED_DEPTH - 1)) 
+			{ fprintf(fi[ply],"<br><br>Return: Reverse Futility Cut<br></td></td></tr></table></html>\n");
+			fclose(fi[ply]); }
+			#endif
+
+			AIBoard.store((max (depth, 0)), bestMove, Currenteval - futilityMargin, orgAlpha, orgBeta);
+			return Currenteval - futilityMargin;
+		}
+
+		if (Currenteval + futilityMargin <= alpha) futilityValue = Currenteval + futilityMargin;
+	}
+
 
 	 /* NullMove : passing should be worse than any other move. */
 	
@@ -1572,7 +2202,7 @@ assert ( stats_positionsSearched < 1000000000 );  // hoping for the day when
 	{
 		AIBoard.makeNullMove();
 
-		NullValue =  -search(-beta, -beta+1, depth - ((NULL_REDUCTION +1) * ONE_PLY), ply + 1, 1);	
+		NullValue =  -search<R>(-beta, -beta+1, depth - ((NULL_REDUCTION +1) * ONE_PLY), ply + 1, 1);	
 		
 		AIBoard.unmakeNullMove(); 
 	
@@ -1615,9 +2245,9 @@ assert ( stats_positionsSearched < 1000000000 );  // hoping for the day when
 	{ fprintf(fi[ply],"<br><hr><br>\n"); }
 #endif
 
-	if ( (! recursiveHash(&alpha, &beta,&bestValue, &bestMove, depth+extensions, ply, hashMove)) && 
-		 (! recursiveSearch(&alpha, &beta,&bestValue, &bestMove, depth+extensions, ply, hashMove, ALL_CAP)) )
-		 recursiveFullSearch(&alpha, &beta,&bestValue, &bestMove, depth+extensions, ply, hashMove); 
+	if ( (! recursiveHash<R>(&alpha, &beta,&bestValue, &bestMove, depth+extensions, ply, hashMove)) && 
+		 (! recursiveSearch<R>(&alpha, &beta,&bestValue, &bestMove, depth+extensions, ply, hashMove, ALL_CAP)) )
+		 recursiveFullSearch<R>(&alpha, &beta,&bestValue, &bestMove, depth+extensions, ply, hashMove, futilityValue); 
 	
 	} // End of > depth CC_DEPTH left
 	else 
@@ -1632,7 +2262,7 @@ assert ( stats_positionsSearched < 1000000000 );  // hoping for the day when
 			
 			{
 				
-				Currenteval = AIBoard.eval() ; 
+				Currenteval = AIBoard.eval<R>() ; 
 				bestValue = Currenteval; 
 				if (bestValue > alpha) alpha = bestValue; 
 
@@ -1677,9 +2307,9 @@ assert ( stats_positionsSearched < 1000000000 );  // hoping for the day when
 			
 			
 			}
-			if ( (! recursiveHash(&alpha, &beta,&bestValue, &bestMove, depth+extensions, ply, hashMove)) && 
-				 (! recursiveSearch(&alpha, &beta,&bestValue, &bestMove, depth+extensions, ply, hashMove, WINNING_CAP)) )
-				 recursiveSearch(&alpha, &beta,&bestValue,&bestMove, depth+extensions, ply, hashMove, MATE_TRIES); 				 		
+			if ( (! recursiveHash<R>(&alpha, &beta,&bestValue, &bestMove, depth+extensions, ply, hashMove)) && 
+				 (! recursiveSearch<R>(&alpha, &beta,&bestValue, &bestMove, depth+extensions, ply, hashMove, WINNING_CAP)) )
+				 recursiveSearch<R>(&alpha, &beta,&bestValue,&bestMove, depth+extensions, ply, hashMove, MATE_TRIES); 				 		
 	
 		} // End of <= depth * CC_DEPTH left
 
@@ -1691,13 +2321,13 @@ assert ( stats_positionsSearched < 1000000000 );  // hoping for the day when
 	 
 	 // None of the moves were legal.  See if it's checkmate or the person has to sit 
     
-	 if (currentRules == CRAZYHOUSE) 
+	 if (R == CRAZYHOUSE) 
 	 {
 		bestValue = -MATE_IN_ONE + 10 * ply;
 	 }
 	 else if (AIBoard.cantBlock()) 
 	 {
-		bestValue = -MATE_IN_ONE + AIBoard.bughouseMateEval();
+		bestValue = -MATE_IN_ONE + AIBoard.bughouseMateEval<R>();
 	 }
 	 else
 	 {
@@ -1706,7 +2336,7 @@ assert ( stats_positionsSearched < 1000000000 );  // hoping for the day when
   }
  
 	
-  if (currentRules == BUGHOUSE && bestValue <= -MATE) bestValue += 10;
+  if (R == BUGHOUSE && bestValue <= -MATE) bestValue += 10;
   
   // We got mated add to the score to because the mate is one ply deeper than when we assigened it that score 
 
@@ -1746,6 +2376,151 @@ assert ( stats_positionsSearched < 1000000000 );  // hoping for the day when
 
 
 
+/* Function: getSpeculationState
+ * Input:    None.
+ * Output:   Everything besides the position that decides what findMove()
+ *           does, packed into bits.
+ * Purpose:  Used to see if input while sitting changed anything.
+ */
+
+static int getSpeculationState()
+{
+	return ghostPieces() | (toldpartisit << 1) | (sitting << 2) | 
+		(forceMode << 3) | (analyzeMode << 4) | (gameInProgress << 5) | 
+		(forceMove << 6) | (gameBoard.getColorOnMove() << 7) | 
+		(gameBoard.getDeepBugColor() << 8);
+}
+
+
+/* Function: checkSpeculation
+ * Input:    None.
+ * Output:   None.
+ * Purpose:  Called after input came in.  If we're sitting and the hands, 
+ *           the position or what the partner wants changed, the searches 
+ *           of speculate() are stopped so findMove() can go on.
+ */
+
+void checkSpeculation()
+{
+	if (speculating && ((gameBoard.getHashValue() != speculationHash) || 
+		(getSpeculationState() != speculationState))) 
+	{
+		speculating = 0;
+		stopThinking = 1;
+	}
+}
+
+
+/* Function: findSpeculation
+ * Input:    The hash value of gameBoard and if ghost pieces are used.
+ * Output:   What speculate() found for that position, or NULL.
+ * Purpose:  Lets findMove() play at once when the piece we sat for comes.
+ */
+
+static speculation *findSpeculation(qword key, int ghosts)
+{
+	int n;
+
+	for (n = 0; n < speculationCount; n++)
+	{
+		if ((speculations[n].key == key) && (speculations[n].ghosts == ghosts))
+			return &speculations[n];
+	}
+	return NULL;
+}
+
+
+/* Function: speculate
+ * Input:    The hash value of gameBoard, if ghost pieces are used and the 
+ *           move and value the search found.
+ * Output:   None.
+ * Purpose:  Called instead of just waiting for input when we sit for a 
+ *           piece.  The positions with each piece the partner could send 
+ *           us are searched in turn, each for the time of a normal move, 
+ *           over and over while the TT makes every round deeper.  It stops
+ *           when input changes the position or the hands (see 
+ *           checkSpeculation()), and findMove() then plays what was found
+ *           for the new hand without searching again.
+ */
+
+static void speculate(qword key, int ghosts, move sitMove, int sitValue)
+{
+	piece pieces[SPECULATIONS];
+	color c = gameBoard.getColorOnMove();
+	speculation *sp;
+	int count, n, value, searched;
+	piece p;
+	move m;
+
+	/* The search that made us sit is the one for the hand we have */
+
+	speculationCount = 1;
+	speculations[0].key = key;
+	speculations[0].ghosts = ghosts;
+	speculations[0].best = sitMove;
+	speculations[0].value = sitValue;
+
+	/* The piece we want to drop comes first */
+
+	count = 0;
+	if ((sitMove.from() == IN_HAND) && !gameBoard.isLegal(sitMove))
+		pieces[count++] = sitMove.moved();
+	for (p = QUEEN; p >= PAWN; p = (piece) (p - 1))
+	{
+		if ((count == 0) || (p != pieces[0])) pieces[count++] = p;
+	}
+
+	speculationHash = gameBoard.getHashValue();
+	speculationState = getSpeculationState();
+	speculating = 1;
+
+	while (speculating)
+	{
+		searched = 0;
+
+		for (n = 0; (n < count) && speculating; n++)
+		{
+			gameBoard.clone(&AIBoard);
+			AIBoard.addPieceToHand(c, pieces[n], 1);
+			key = AIBoard.getHashValue();
+			ghosts = ghostPieces();
+
+			/* A mate either way won't change by searching longer */
+
+			sp = findSpeculation(key, ghosts);
+			if ((sp != NULL) && ((sp->value > MATE) || (sp->value < -MATE)))
+				continue;
+
+			if (ghosts) addGhostPieces();
+			searched = 1;
+
+			stopThinking = 0;
+			reSearch = 1;         /* Keeps searchRoot() from printing */
+			gameBoard.setLastMoveNow();
+
+			searchRoot<BUGHOUSE>(MAX_SEARCH_DEPTH, &m, &value);
+
+			if (!speculating) break;
+
+			if (sp == NULL) 
+			{
+				sp = &speculations[speculationCount++];
+				sp->key = key;
+				sp->ghosts = ghosts;
+			}
+			sp->best = m;
+			sp->value = value;
+		}
+
+		if (!searched) 
+		{
+			waitForInput();
+			checkSpeculation();
+		}
+	}
+}
+
+
 /* Function: findMove
  * Input:    A pointer to move
  * Output:   None
@@ -1755,7 +2530,9 @@ assert ( stats_positionsSearched < 1000000000 );  // hoping for the day when
 void findMove(move *rightMove)
 {
 
-  int bestValue; 
+  int bestValue, ghosts; 
+  qword key;
+  speculation *sp;
   
   char buf[MAX_STRING];
   char buf2[MAX_STRING];
@@ -1769,6 +2546,8 @@ void findMove(move *rightMove)
   
 #ifdef DEBUG_STATS
   stats_checkext = stats_forceext =  stats_capext = stats_RazorTries = stats_Razors =  0;
+  stats_FutilityPrunes = stats_ReverseFutilityCuts = 0;
+  stats_Reductions = stats_ReductionResearches = 0;
 
   int i; 
   
@@ -1794,35 +2573,47 @@ void findMove(move *rightMove)
 		initialTime =  gameBoard.getTime(BLACK);
   }	
 
+  speculationCount = 0;
+  newHands = resumeDepth = 0;
+
   do {
-		gameBoard.copy(&AIBoard);
+		gameBoard.clone(&AIBoard);
    		overideMove.makeBad();
+		key = AIBoard.getHashValue();
+		ghosts = ghostPieces();
+		sp = findSpeculation(key, ghosts);
 	
 
-	if ((currentRules == BUGHOUSE) && (!partsitting) && (!parttoldgo))
-	
-	
 	// we search with "ghost pieces" in Bughouse
 	
-	{
-
-	AIBoard.addPieceToHand(WHITE, ROOK, 1);
-	AIBoard.addPieceToHand(BLACK, ROOK, 1);
-
-    AIBoard.addPieceToHand(WHITE, KNIGHT, 1);
-	AIBoard.addPieceToHand(BLACK, KNIGHT, 1);
-	
-	AIBoard.addPieceToHand(WHITE, PAWN, 1);
-	AIBoard.addPieceToHand(BLACK, PAWN, 1);
-	
-	}
+	if (ghosts) addGhostPieces();
 	
 	stopThinking = reSearch = forceMove = 0;
     parttoldgo = 0; // he tells us to go always for 1 move only
 	
 
 
-    searchRoot(MAX_SEARCH_DEPTH, rightMove, &bestValue);
+	/* The search is compiled once for each variant, pick the one that's
+	   being played.  If we sat for this hand it was searched already. */
+
+	if (sp != NULL)
+	{
+		*rightMove = sp->best;
+		bestValue = sp->value;
+	}
+	else 
+	{
+		findingMove = 1;
+		if (currentRules == CRAZYHOUSE)
+			searchRoot<CRAZYHOUSE>(MAX_SEARCH_DEPTH, rightMove, &bestValue);
+		else
+			searchRoot<BUGHOUSE>(MAX_SEARCH_DEPTH, rightMove, &bestValue);
+		findingMove = 0;
+
+		/* The hands changed, search again before deciding anything */
+
+		if (resumeDepth) continue;
+	}
 	
 	/* Only for Bughouse */
 	if (currentRules == BUGHOUSE) 
@@ -1840,7 +2631,7 @@ void findMove(move *rightMove)
 					output(buf); 
 					toldpartisit =1; 
 					}
-					waitForInput();
+					speculate(key, ghosts, *rightMove, bestValue);
 					reSearch = 1; 
 					gameBoard.setLastMoveNow();
 
@@ -1921,6 +2712,137 @@ void findMove(move *rightMove)
   return;
 }
 
+/* Function: searchPosition
+ * Input:    A pointer to put the move in.
+ * Output:   The value of the move for the side on move.
+ * Purpose:  Searches gameBoard once, without the book, sitting or telling 
+ *           the partner anything.  Used by analyzeSearch(), which sets up 
+ *           the limits.  In bughouse the move may be a drop of a ghost 
+ *           piece.  If there is no legal move the move is bad.
+ */
+
+int searchPosition(move *rightMove)
+{
+  move list[MAX_MOVES];
+  int bestValue;
+
+  pondering = 0;
+  stats_hashFillingUp = stats_transpositionHits = 0;
+  stats_quiescensePositionsSearched = stats_positionsSearched = 0;
+
+  /* searchRoot() would wait for input if there is no move */
+
+  if (!gameBoard.moves(list))
+  {
+	  rightMove->makeBad();
+	  return gameBoard.isInCheck(gameBoard.getColorOnMove()) ? -MATE_IN_ONE : 0;
+  }
+
+  gameBoard.clone(&AIBoard);
+  overideMove.makeBad();
+  if (ghostPieces()) addGhostPieces();
+
+  stopThinking = reSearch = forceMove = 0;
+
+  if (currentRules == CRAZYHOUSE)
+	  searchRoot<CRAZYHOUSE>(MAX_SEARCH_DEPTH, rightMove, &bestValue);
+  else
+	  searchRoot<BUGHOUSE>(MAX_SEARCH_DEPTH, rightMove, &bestValue);
+
+  makeHistoryOld();
+
+  return bestValue;
+}
+
+/* Function: analyzeBoard
+ * Input:    A position and its variant.
+ * Output:   None.
+ * Purpose:  Sets up gameBoard and the globals the search looks at to 
+ *           analyze the position for libsunsetter.cpp or server.cpp.
+ *           Nothing is played, reported or sat for.
+ */
+
+void analyzeBoard(boardStruct *board, rules variant)
+{
+  board->copy(&gameBoard);
+  currentRules = variant;
+
+  gameInProgress = analyzeMode = xboardMode = 1;
+  forceMode = pondering = tryToPonder = learning = 0;
+  sitting = toldpartisit = toldparttosit = 0;
+  partsitting = parttoldgo = psittinglong = 0;
+}
+
+/* Function: analyzeSearch
+ * Input:    The depth and time limits, 0 is no limit, and room for the
+ *           move and its value.
+ * Output:   0 if the move can be played, 1 if it is a drop of a piece we
+ *           would sit for, -1 if there is no legal move.
+ * Purpose:  Searches the position analyzeBoard() set up and writes the 
+ *           best move and its value for the side on move.
+ */
+
+int analyzeSearch(int depth, int milliseconds, char *moveString, int *value)
+{
+  move m;
+
+  /* searchRoot() stops before the iteration FIXED_DEPTH, and waits for
+     input if it gets to MAX_SEARCH_DEPTH in analyze mode */
+
+  if (depth <= 0 || depth > MAX_SEARCH_DEPTH - 2) depth = MAX_SEARCH_DEPTH - 2;
+  FIXED_DEPTH = depth + 1;
+  FIXED_TIME = max(milliseconds, 0);
+
+  gameBoard.setDeepBugColor(gameBoard.getColorOnMove());
+  gameBoard.setLastMoveNow();
+
+  *value = searchPosition(&m);
+
+  FIXED_DEPTH = FIXED_TIME = 0;
+
+  if (m.isBad())
+  {
+	  moveString[0] = '\0';
+	  return -1;
+  }
+
+  DBMoveToRawAlgebraicMove(m, moveString);
+  return gameBoard.isLegal(m) ? 0 : 1;
+}
+
+/* Function: searchRootMove
+ * Input:    A move of AIBoard, how deep to search, alpha and beta, and 
+ *           room for MAX_STRING chars.
+ * Output:   The value of the move.
+ * Purpose:  Searches a move searchSplit() handed to a worker of split.cpp
+ *           and writes its principal variation.
+ */
+
+int searchRootMove(move m, int depth, int alpha, int beta, char *pvText)
+{
+  char buf[MAX_STRING];
+  int n, value;
+
+  if (currentRules == CRAZYHOUSE)
+	  value = searchWindow<CRAZYHOUSE>(m, depth, alpha, beta);
+  else
+	  value = searchWindow<BUGHOUSE>(m, depth, alpha, beta);
+
+  savePrincipalVar(m, 1);
+
+  // leave room for the rest of the answer
+
+  pvText[0] = '\0';
+  for (n = 0; n < pv.depth[0]; n++)
+  {
+	  DBMoveToRawAlgebraicMove(pv.moves[0][n], buf);
+	  if (strlen(pvText) + strlen(buf) + 1 > MAX_STRING - 64) break;
+	  strcat(pvText, buf); strcat(pvText, " ");
+  }
+
+  return value;
+}
+
 /* Function: stopThought
  * Input:    None.
  * Output:   None.
@@ -1944,6 +2866,8 @@ void stopThought()
 
 void startSearchOver()
 {
+  int n;
+
   stopThinking = 1;
   reSearch = 1;
 
@@ -1951,10 +2875,25 @@ void startSearchOver()
      the old hash values are no good */
 
   zapHashValues();
+  for (n = 0; n < ANALYSIS_CACHE_SIZE; n++) analysisCache[n] = analysisEntry();
  
 
 }
 
+/* Function: restartSearch
+ * Input:    None.
+ * Output:   None.
+ * Purpose:  Used to make Sunsetter search again when the position changed 
+ *           to another real position, like a move in analyze mode.  What 
+ *           is in the hash table is still right then, so it's kept.
+ */
+
+void restartSearch()
+{
+  stopThinking = 1;
+  reSearch = 1;
+}
+
 /* Function: sit
  * Input:    None.
  * Output:   None.
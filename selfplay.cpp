@@ -0,0 +1,701 @@
+/* ***************************************************************************
+ *                                Sunsetter                                  *
+ *               (c) Ben Dean-Kawamura, Georg v. Zimmermann                  *
+ *   For license terms, see the file COPYING that came with this program.    *
+ *                                                                           *
+ *  Name: selfplay.cpp                                                       *
+ *                                                                           *
+ *  Purpose: plays a match of crazyhouse games between two parameter sets    *
+ *           so changes to the personality / ini values can be tested        *
+ *           without setting up a tournament in a GUI.                       *
+ *                                                                           *
+ *  The Command line for selfplay() is:                                      *
+ *  "sunsetter selfplay <games> <seconds per game> <A.ini*> <B.ini*>         *
+ *                      <concurrent games*>"                                 *
+ *                                                                           *
+ *  where the ini files are optional ("-" means default values).  As many    *
+ *  games as CPUs are played at the same time if it's not given.  Every     *
+ *  opening from the book (noon.txt) is played twice with colors swapped.    *
+ *  The games are appended to selfplay.bpgn, and after each game the score,  *
+ *  the Elo difference of A over B and a SPRT log likelihood ratio for       *
+ *  H0: elo = SPRT_ELO0 against H1: elo = SPRT_ELO1 are printed.  The match  *
+ *  stops early when the SPRT accepts one of the hypotheses.                 *
+ *                                                                           *
+ *  Comments: Sunsetter keeps its boards, tables and parameters in globals,  *
+ *            so each game is played in a process forked for it.  It sends  *
+ *            the game text through a pipe and exits with the result, and    *
+ *            we write the games and the score as they finish.               *
+ *            In a game the two parameter sets each have their own           *
+ *            transposition table.  Threefold repetitions are a draw.        *
+ *                                                                           *
+ *************************************************************************** */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "board.h"
+#include "brain.h"
+#include "bughouse.h"
+#include "notation.h"
+#include "interface.h"
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#define SELFPLAY_PROCESSES
+#include <sys/types.h>
+#include <sys/select.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <signal.h>
+#endif
+
+extern FILE *findFile(const char *name, const char *mode);
+extern SEARCH_LOCAL int initialTime;
+
+/* Games longer than this are adjudicated as a draw */
+#define SELFPLAY_MAX_PLY (300)
+
+/* Book moves played before the engines take over */
+#define SELFPLAY_BOOK_PLY (8)
+
+/* SPRT bounds in Elo and the error rates alpha and beta */
+#define SPRT_ELO0 (0.0)
+#define SPRT_ELO1 (10.0)
+#define SPRT_ALPHA (0.05)
+#define SPRT_BETA (0.05)
+
+/* Most games played at the same time, and room for the text of one */
+#define SELFPLAY_MAX_PROCESSES (64)
+#define SELFPLAY_TEXT (16384)
+
+#ifdef SELFPLAY_PROCESSES
+
+/* A game that is played in a forked process */
+
+struct selfplayProcess {
+	pid_t pid;
+	int pipe;
+	int game;
+	int length;
+	char text[SELFPLAY_TEXT];
+};
+
+static selfplayProcess processes[SELFPLAY_MAX_PROCESSES];
+
+#endif
+
+/* Function: selfplayResetParameters
+ * Input:    The ini file of the side to move, or NULL for default values
+ * Output:   None
+ * Purpose:  Loads the parameter set of one engine and rebuilds the tables
+ *           that depend on it.
+ */
+
+static void selfplayResetParameters(char *iniFile)
+{
+	setDefaultValues();
+	if (iniFile) ReadIniFile(iniFile);
+	initializeEval();
+	initializeReductions();
+}
+
+/* Function: selfplayKey
+ * Input:    None
+ * Output:   A key for the position of gameBoard
+ * Purpose:  The hash value doesn't have the side to move in it, so flip it
+ *           when black is to move.
+ */
+
+static qword selfplayKey()
+{
+	qword key = gameBoard.getHashValue();
+
+	if (gameBoard.getColorOnMove() == BLACK) key = ~key;
+	return key;
+}
+
+/* Function: selfplayRebuildBoard
+ * Input:    The moves played so far and their number, and room for the key
+ *           of every position or NULL
+ * Output:   None
+ * Purpose:  Replays the game on gameBoard, so the incrementally kept material
+ *           and development use the parameters of the side to move.
+ */
+
+static void selfplayRebuildBoard(move *gameMoves, int movesInGame, qword *keys)
+{
+	int n;
+
+	gameBoard.resetBoard();
+	gameBoard.playCrazyhouse();
+	for (n = 0; n < movesInGame; n++) 
+	{
+		if (keys) keys[n] = selfplayKey();
+		gameBoard.changeBoard(gameMoves[n]);
+	}
+	if (keys) keys[movesInGame] = selfplayKey();
+}
+
+/* Function: selfplayStorePositions
+ * Input:    The moves played so far and their number
+ * Output:   None
+ * Purpose:  After zapHashValues() the positions the side to move had at 
+ *           the root before are put back in the transposition table, like 
+ *           searchRoot() stores them, so it still sees repetitions.
+ */
+
+static void selfplayStorePositions(move *gameMoves, int movesInGame)
+{
+	move none;
+	int n;
+
+	none.makeBad();
+
+	gameBoard.resetBoard();
+	gameBoard.playCrazyhouse();
+	for (n = 0; n < movesInGame; n++)
+	{
+		if (!((movesInGame - n) & 1))
+			gameBoard.store(MAX_SEARCH_DEPTH, none, -ratingDiff, -INFINITY, +INFINITY);
+		gameBoard.changeBoard(gameMoves[n]);
+	}
+}
+
+/* Function: selfplayRepetitions
+ * Input:    The keys of the positions of the game and their number
+ * Output:   How often the last position was on the board
+ * Purpose:  Finds threefold repetitions.
+ */
+
+static int selfplayRepetitions(qword *keys, int movesInGame)
+{
+	int n, count = 0;
+
+	for (n = movesInGame; n >= 0; n -= 2)
+	{
+		if (keys[n] == keys[movesInGame]) count++;
+	}
+	return count;
+}
+
+/* Function: selfplayBookLine
+ * Input:    Which book line to use, and an array to fill with its moves
+ * Output:   The number of moves filled in
+ * Purpose:  Gets the start position of a game from the opening book.  Lines
+ *           are used round robin, the line is cut at the first move that
+ *           is illegal in crazyhouse.
+ */
+
+static int selfplayBookLine(int lineNr, move *gameMoves)
+{
+	char buf[MAX_STRING], *token;
+	int lines = 0, count = 0;
+	FILE *bookFile;
+	move m;
+
+	gameBoard.resetBoard();
+	gameBoard.playCrazyhouse();
+
+	bookFile = findFile("noon.txt", "r");
+	if (!bookFile) return 0;
+
+	/* count the usable lines first, so we can wrap around */
+
+	while (fgets(buf, MAX_STRING, bookFile))
+		if (buf[0] == 'W' || buf[0] == 'B') lines++;
+
+	if (lines)
+	{
+		lineNr %= lines;
+		rewind(bookFile);
+		while (fgets(buf, MAX_STRING, bookFile))
+		{
+			if (buf[0] != 'W' && buf[0] != 'B') continue;
+			if (lineNr--) continue;
+
+			strtok(buf, "#;\n\r");
+			token = strtok(buf + 1, " \t");
+			while (token && count < SELFPLAY_BOOK_PLY)
+			{
+				m = gameBoard.algebraicMoveToDBMove(token);
+				if (m.isBad() || gameBoard.playMove(m, 0)) break;
+				gameMoves[count++] = m;
+				token = strtok(NULL, " \t");
+			}
+			break;
+		}
+	}
+
+	fclose(bookFile);
+	return count;
+}
+
+/* Function: selfplayGame
+ * Input:    The ini files of white and black, the time per side in
+ *           milliseconds, the opening line to use and the bpgn file to
+ *           append the game to
+ * Output:   1 if white won, -1 if black won, 0 for a draw
+ * Purpose:  Plays one game of Sunsetter against itself.
+ */
+
+static int selfplayGame(char *iniFile[COLORS], int msPerGame, int lineNr,
+						FILE *fout)
+{
+	move gameMoves[MAX_GAME_LENGTH], list[MAX_MOVES], m;
+	qword keys[MAX_GAME_LENGTH];
+	int timeLeft[COLORS], movesInGame, bookMoves, n, result, differ, swaps;
+	int oneTable;
+	transpositionEntry *otherTable[COLORS] = { NULL, NULL };
+	long startTime, used;
+	char buf[MAX_STRING], reason[MAX_STRING];
+	color c, tableColor;
+
+	movesInGame = bookMoves = selfplayBookLine(lineNr, gameMoves);
+	selfplayRebuildBoard(gameMoves, movesInGame, keys);
+	timeLeft[WHITE] = timeLeft[BLACK] = msPerGame;
+	result = 0;
+	strcpy(reason, "Game adjudicated as a draw");
+
+	differ = !iniFile[WHITE] != !iniFile[BLACK] ||
+		(iniFile[WHITE] && strcmp(iniFile[WHITE], iniFile[BLACK]));
+	tableColor = gameBoard.getColorOnMove();
+	swaps = oneTable = 0;
+
+	for (;;)
+	{
+		c = gameBoard.getColorOnMove();
+
+		if (movesInGame >= SELFPLAY_MAX_PLY) break;
+
+		if (selfplayRepetitions(keys, movesInGame) >= 3)
+		{
+			strcpy(reason, "Draw by repetition");
+			break;
+		}
+
+		/* Each side uses its own parameters and its own transposition 
+		   table.  If there is no memory for a second one, the table is 
+		   zapped and gets the positions of the side to move back */
+
+		if (differ)
+		{
+			selfplayResetParameters(iniFile[c]);
+			selfplayRebuildBoard(gameMoves, movesInGame, NULL);
+
+			if (!oneTable && c != tableColor)
+			{
+				if (swapTranspositionTable(otherTable)) oneTable = 1;
+				else
+				{
+					tableColor = c;
+					swaps++;
+				}
+			}
+
+			if (oneTable)
+			{
+				zapHashValues();
+				selfplayStorePositions(gameMoves, movesInGame);
+			}
+		}
+
+		if (gameBoard.moves(list) == 0)
+		{
+			if (gameBoard.isInCheck(c))
+			{
+				result = (c == WHITE) ? -1 : 1;
+				sprintf(reason, "%s checkmated", c == WHITE ? "WHITE" : "BLACK");
+			}
+			else strcpy(reason, "Stalemate");
+			break;
+		}
+
+		gameBoard.setTime(WHITE, timeLeft[WHITE]);
+		gameBoard.setTime(BLACK, timeLeft[BLACK]);
+		gameBoard.setDeepBugColor(c);
+		gameBoard.setLastMoveNow();
+		initialTime = msPerGame;
+		forceMode = analyzeMode = 0;
+		gameInProgress = 1;
+
+		startTime = getSysMilliSecs();
+		findMove(&m);
+		used = getSysMilliSecs() - startTime;
+
+		timeLeft[c] -= used;
+		if (timeLeft[c] < 0)
+		{
+			result = (c == WHITE) ? -1 : 1;
+			sprintf(reason, "%s forfeits on time", c == WHITE ? "WHITE" : "BLACK");
+			break;
+		}
+
+		if (m.isBad() || gameBoard.playMove(m, 0))
+		{
+			result = (c == WHITE) ? -1 : 1;
+			sprintf(reason, "%s played an illegal move", c == WHITE ? "WHITE" : "BLACK");
+			break;
+		}
+
+		gameMoves[movesInGame++] = m;
+		keys[movesInGame] = selfplayKey();
+	}
+
+	/* The table we started with may be shared memory, keep it */
+
+	if (swaps & 1) swapTranspositionTable(otherTable);
+	free(otherTable[WHITE]);
+	free(otherTable[BLACK]);
+
+	/* write the game */
+
+	fprintf(fout, "[Event \"Sunsetter selfplay\"]\n");
+	fprintf(fout, "[WhiteA \"%s\"]\n", iniFile[WHITE] ? iniFile[WHITE] : "default");
+	fprintf(fout, "[BlackA \"%s\"]\n", iniFile[BLACK] ? iniFile[BLACK] : "default");
+	fprintf(fout, "[TimeControl \"%d+0\"]\n", msPerGame / 1000);
+	fprintf(fout, "[Result \"%s\"]\n\n",
+		result > 0 ? "1-0" : (result < 0 ? "0-1" : "1/2-1/2"));
+
+	for (n = 0; n < movesInGame; n++)
+	{
+		DBMoveToRawAlgebraicMove(gameMoves[n], buf);
+		fprintf(fout, "%d%c. %s%s%s", n / 2 + 1, (n & 1) ? 'a' : 'A', buf,
+			n == bookMoves - 1 ? " {book}" : "", (n % 10 == 9) ? "\n" : " ");
+	}
+	fprintf(fout, "\n\n{%s} %s\n\n", reason,
+		result > 0 ? "1-0" : (result < 0 ? "0-1" : "1/2-1/2"));
+	fflush(fout);
+
+	return result;
+}
+
+/* Function: selfplayPlay
+ * Input:    The ini files of A and B, which game of the match it is, the
+ *           time per side in milliseconds and the file to write it to
+ * Output:   1 if A won, -1 if B won, 0 for a draw
+ * Purpose:  Plays a game of the match, A is white in the even ones.
+ */
+
+static int selfplayPlay(char *engineIni[2], int g, int msPerGame, FILE *fout)
+{
+	char *iniFile[COLORS];
+	int engineWhite, result;
+
+	/* every opening is played twice, with A as white and as black */
+
+	engineWhite = g & 1;
+	iniFile[WHITE] = engineIni[engineWhite];
+	iniFile[BLACK] = engineIni[1 - engineWhite];
+
+	selfplayResetParameters(iniFile[WHITE]);
+	zapHashValues();
+	initializeHistory();
+
+	result = selfplayGame(iniFile, msPerGame, g / 2, fout);
+	if (engineWhite) result = -result;
+
+	return result;
+}
+
+#ifdef SELFPLAY_PROCESSES
+
+/* Function: selfplayQuiet
+ * Input:    A string
+ * Output:   None
+ * Purpose:  Is outputHook in a game process, the games at the same time
+ *           would print over each other.
+ */
+
+static void selfplayQuiet(const char *str)
+{
+}
+
+/* Function: selfplayStart
+ * Input:    The ini files of A and B, which game of the match it is, the
+ *           time per side in milliseconds and how many games are running
+ * Output:   0, -1 if no process could be forked
+ * Purpose:  Forks a process that plays the game and sends its text back.
+ */
+
+static int selfplayStart(char *engineIni[2], int g, int msPerGame, int running)
+{
+	int fd[2], n;
+	pid_t pid;
+	FILE *fout;
+
+	/* Or the process would have what output() kept too */
+
+	flushOutput(1);
+
+	if (pipe(fd)) return -1;
+
+	pid = fork();
+	if (pid == -1)
+	{
+		close(fd[0]);
+		close(fd[1]);
+		return -1;
+	}
+
+	if (!pid)
+	{
+		for (n = 0; n < running; n++) close(processes[n].pipe);
+		close(fd[0]);
+		outputHook = selfplayQuiet;
+
+		fout = fdopen(fd[1], "w");
+		if (!fout) _exit(0);
+		n = selfplayPlay(engineIni, g, msPerGame, fout);
+		fclose(fout);
+		_exit(n + 2);
+	}
+
+	close(fd[1]);
+	processes[running].pid = pid;
+	processes[running].pipe = fd[0];
+	processes[running].game = g;
+	processes[running].length = 0;
+	return 0;
+}
+
+/* Function: selfplayFinish
+ * Input:    The number of games running, where to put the one that ended
+ *           and the file to write it to
+ * Output:   The result of the game for A, or -2 if it was lost
+ * Purpose:  Waits for a game to end and writes it to the file.  The 
+ *           process of the game is removed.
+ */
+
+static int selfplayFinish(int running, int *game, FILE *fout)
+{
+	fd_set pipes;
+	int n, got, highest, status;
+	selfplayProcess *sp;
+
+	for (;;)
+	{
+		FD_ZERO(&pipes);
+		highest = -1;
+		for (n = 0; n < running; n++)
+		{
+			FD_SET(processes[n].pipe, &pipes);
+			highest = max(highest, processes[n].pipe);
+		}
+		if (select(highest + 1, &pipes, NULL, NULL, NULL) <= 0) continue;
+
+		for (n = 0; n < running; n++)
+		{
+			if (!FD_ISSET(processes[n].pipe, &pipes)) continue;
+
+			sp = &processes[n];
+			got = read(sp->pipe, sp->text + sp->length, 
+				SELFPLAY_TEXT - 1 - sp->length);
+			if (got > 0)
+			{
+				sp->length += got;
+				if (sp->length < SELFPLAY_TEXT - 1) continue;
+			}
+
+			/* The end of the game, or more of it than it should be */
+
+			close(sp->pipe);
+			if (got > 0) kill(sp->pid, SIGKILL);
+			waitpid(sp->pid, &status, 0);
+
+			*game = sp->game;
+			if (got > 0 || !WIFEXITED(status) || WEXITSTATUS(status) < 1 ||
+				WEXITSTATUS(status) > 3) got = -2;
+			else
+			{
+				fwrite(sp->text, 1, sp->length, fout);
+				fflush(fout);
+				got = WEXITSTATUS(status) - 2;
+			}
+
+			*sp = processes[running - 1];
+			return got;
+		}
+	}
+}
+
+/* Function: selfplayStopAll
+ * Input:    The number of games running
+ * Output:   None
+ * Purpose:  Ends the games, they aren't needed once the SPRT is done.
+ */
+
+static void selfplayStopAll(int running)
+{
+	int n;
+
+	for (n = 0; n < running; n++)
+	{
+		kill(processes[n].pid, SIGKILL);
+		close(processes[n].pipe);
+		waitpid(processes[n].pid, NULL, 0);
+	}
+}
+
+#endif
+
+/* Function: eloToScore
+ * Input:    An Elo difference
+ * Output:   The expected score for it
+ * Purpose:  Used by the SPRT.
+ */
+
+static double eloToScore(double elo)
+{
+	return 1.0 / (1.0 + pow(10.0, -elo / 400.0));
+}
+
+/* Function: selfplayStats
+ * Input:    Wins, draws and losses of engine A, and where to put the LLR
+ * Output:   None
+ * Purpose:  Prints the match score with the Elo difference, its 95% error
+ *           margin and the SPRT log likelihood ratio.
+ */
+
+static void selfplayStats(int wins, int draws, int losses, double *llr)
+{
+	char buf[MAX_STRING];
+	double games, score, var, se, elo, eloLow, eloHigh, s0, s1;
+
+	games = wins + draws + losses;
+	score = (wins + draws / 2.0) / games;
+	var = (wins * (1.0 - score) * (1.0 - score) + draws * (0.5 - score) * (0.5 - score)
+		+ losses * score * score) / games;
+	se = sqrt(var / games);
+
+	elo = eloLow = eloHigh = 0;
+	if (score > 0 && score < 1) elo = -400.0 * log10(1.0 / score - 1.0);
+	if (score - 1.96 * se > 0 && score - 1.96 * se < 1)
+		eloLow = -400.0 * log10(1.0 / (score - 1.96 * se) - 1.0);
+	if (score + 1.96 * se > 0 && score + 1.96 * se < 1)
+		eloHigh = -400.0 * log10(1.0 / (score + 1.96 * se) - 1.0);
+
+	/* normal approximation of the generalized SPRT */
+
+	s0 = eloToScore(SPRT_ELO0);
+	s1 = eloToScore(SPRT_ELO1);
+	*llr = 0;
+	if (var > 0) *llr = games * (s1 - s0) * (2.0 * score - s0 - s1) / (2.0 * var);
+
+	sprintf(buf, "Selfplay: +%d =%d -%d  score %.1f%%  Elo %+.1f [%+.1f, %+.1f]  LLR %.2f [%.2f, %.2f]\n",
+		wins, draws, losses, score * 100.0, elo, eloLow, eloHigh, *llr,
+		log(SPRT_BETA / (1.0 - SPRT_ALPHA)), log((1.0 - SPRT_BETA) / SPRT_ALPHA));
+	output(buf);
+}
+
+/* Function: selfplay
+ * Input:    the arguments Sunsetter was called with
+ * Output:   0, 1 if an error occured
+ * Purpose:  Plays a match between two parameter sets, see the top of the file.
+ */
+
+int selfplay(int argc, char **argv)
+{
+	char *engineIni[2], buf[MAX_STRING];
+	int games, msPerGame, g, next, result, wins = 0, draws = 0, losses = 0;
+	int concurrency = 1, running = 0;
+	double llr;
+	FILE *fout;
+
+	if ((argc < 4) || (argc > 7)) {
+		output("Usage:\n");
+		output("sunsetter selfplay <games> <seconds per game> <A.ini*> <B.ini*> <concurrent games*>  * = optional, \"-\" for default values\n");
+		return (1);
+	}
+
+	games = atoi(argv[2]);
+	msPerGame = atoi(argv[3]) * 1000;
+	engineIni[0] = (argc > 4 && strcmp(argv[4], "-")) ? argv[4] : NULL;
+	engineIni[1] = (argc > 5 && strcmp(argv[5], "-")) ? argv[5] : NULL;
+
+#ifdef SELFPLAY_PROCESSES
+	if (argc > 6) concurrency = atoi(argv[6]);
+	else concurrency = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	concurrency = max(1, min(concurrency, SELFPLAY_MAX_PROCESSES));
+#endif
+
+	fout = fopen("selfplay.bpgn", "at");
+	if (!fout) {
+		output("Could not open selfplay.bpgn\n");
+		return (1);
+	}
+
+	/* we don't read commands while playing */
+
+	ignoreInput = 1;
+	tryToPonder = 0;
+	currentRules = CRAZYHOUSE;
+
+	for (next = 0; (next < games) || running; )
+	{
+		/* start as many games as may run, if a process can't be forked
+		   the game is played here */
+
+		g = -1;
+		while ((next < games) && (running < concurrency))
+		{
+			sprintf(buf, "\nSelfplay: game %d of %d, A plays %s\n", next + 1, 
+				games, (next & 1) ? "black" : "white");
+			output(buf);
+
+			g = next++;
+#ifdef SELFPLAY_PROCESSES
+			if (concurrency > 1 && !selfplayStart(engineIni, g, msPerGame, running))
+			{
+				running++;
+				g = -1;
+				continue;
+			}
+#endif
+			break;
+		}
+
+		if (g != -1) result = selfplayPlay(engineIni, g, msPerGame, fout);
+#ifdef SELFPLAY_PROCESSES
+		else
+		{
+			result = selfplayFinish(running--, &g, fout);
+			if (result == -2)
+			{
+				sprintf(buf, "Selfplay: game %d was lost\n", g + 1);
+				output(buf);
+				continue;
+			}
+		}
+#endif
+
+		sprintf(buf, "Selfplay: game %d ended\n", g + 1);
+		output(buf);
+
+		if (result > 0) wins++;
+		else if (result < 0) losses++;
+		else draws++;
+
+		selfplayStats(wins, draws, losses, &llr);
+
+		if (llr >= log((1.0 - SPRT_BETA) / SPRT_ALPHA))
+		{
+			output("Selfplay: SPRT accepted H1, A is stronger\n");
+			break;
+		}
+		if (llr <= log(SPRT_BETA / (1.0 - SPRT_ALPHA)))
+		{
+			output("Selfplay: SPRT accepted H0, A is not stronger\n");
+			break;
+		}
+	}
+
+#ifdef SELFPLAY_PROCESSES
+	selfplayStopAll(running);
+#endif
+
+	fclose(fout);
+	ignoreInput = 0;
+
+	return(0);
+}
@@ -0,0 +1,679 @@
+/* ***************************************************************************
+ *                                Sunsetter                                  *
+ *               (c) Ben Dean-Kawamura, Georg v. Zimmermann                  *
+ *   For license terms, see the file COPYING that came with this program.    *
+ *                                                                           *
+ *  Name: server.cpp                                                         *
+ *                                                                           *
+ *  Purpose: plays many games in one process, so they share the tables,     *
+ *           book, learn table and the transposition table.                  *
+ *                                                                           *
+ *  The Command line for server() is "sunsetter server [<threads>]".  Every  *
+ *  line on stdin is "<game> <command>", and every line Sunsetter writes     *
+ *  starts with the game it is about.  The commands are:                     *
+ *                                                                           *
+ *    new [crazyhouse|bughouse]   start a game at the start position         *
+ *    setboard <FEN>              holdings in brackets after the board       *
+ *    holding [<white>] [<black>]                                            *
+ *    move <move>                 e2e4, e7e8q or N@f3                        *
+ *    go [<depth> [<ms>]]         search, 0 is no limit.  The answer is      *
+ *                                "bestmove <move> <value>", "sit <move>     *
+ *                                <value>" for a drop we would sit for, or   *
+ *                                "nomove <value>".  The thinking lines      *
+ *                                come before it.                            *
+ *    stop                        answer the go of this game now             *
+ *    close                       forget the game                            *
+ *                                                                           *
+ *  Errors are answered with "error <text>".  "memory <MB>" and "quit" are   *
+ *  for the whole server and have no game.  "quit" stops the searches and    *
+ *  the lines before it are done first.                                      *
+ *                                                                           *
+ *  Comments: The lines of a game are done in order, a line waits while its  *
+ *            game searches.  The searches are done by <threads>             *
+ *            worker threads, one per core if it isn't given, and each has   *
+ *            its own search (see SEARCH_LOCAL), so the games are searched   *
+ *            at the same time.  "memory" and "quit" wait for all lines      *
+ *            before them.  The main thread reads the input, so "stop"       *
+ *            works right away, and writes the output.  On Windows the       *
+ *            main thread does the searches itself, one after the other.     *
+ *                                                                           *
+ *************************************************************************** */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "board.h"
+#include "brain.h"
+#include "bughouse.h"
+#include "notation.h"
+#include "interface.h"
+#include "variables.h"
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#define SERVER_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+extern SEARCH_LOCAL volatile int stopThinking;
+
+/* Most games one server plays at a time, and most worker threads */
+#define SERVER_GAMES (1024)
+#define SERVER_MAX_THREADS (64)
+
+struct serverGame {
+	char name[MAX_STRING];
+	boardStruct board;					/* The position and game history */
+	rules variant;
+	int searching;						/* If a worker searches it */
+};
+
+struct serverLine {
+	char str[MAX_STRING];
+	serverLine *next;
+};
+
+static serverGame *games[SERVER_GAMES];
+
+static serverLine *firstLine, *lastLine;	/* Lines not done yet */
+
+static int quitServer;
+
+static SEARCH_LOCAL const char *outputTag;	/* The game output() is about */
+static SEARCH_LOCAL char outputLine[MAX_STRING];
+static SEARCH_LOCAL int outputLength;
+
+#ifdef SERVER_THREADS
+
+struct serverWorker {
+	pthread_t thread;
+	serverGame *game;					/* The game it searches, or NULL */
+	int depth, milliseconds;
+	int stopped;						/* If "stop" came for the search */
+	volatile int *stop;					/* stopThinking of the thread
+										   while it searches, or NULL */
+};
+
+static serverWorker workers[SERVER_MAX_THREADS];
+static int workerCount, quitWorkers;
+
+static pthread_mutex_t serverLock = PTHREAD_MUTEX_INITIALIZER;
+										/* For workers[], the searching of
+										   the games and pendingOutput */
+static pthread_cond_t workerWake = PTHREAD_COND_INITIALIZER;
+
+static char *pendingOutput;				/* What the workers printed, the
+										   main thread writes it */
+static int pendingLength, pendingSize;
+
+#else
+
+static serverGame *searchingGame;
+
+#endif
+
+
+/* Function: serverOutput
+ * Input:    A string
+ * Output:   None
+ * Purpose:  Is outputHook.  Puts the game in front of every line, lines
+ *           that are not about a game are dropped.  The lines of the
+ *           workers wait in pendingOutput for the main thread.
+ */
+
+static void serverOutput(const char *str)
+{
+	char buf[2 * MAX_STRING];
+#ifdef SERVER_THREADS
+	char *bigger;
+	int length, size;
+#endif
+
+	for (; *str; str++)
+	{
+		if (*str == '\n' || *str == '\r')
+		{
+			outputLine[outputLength] = '\0';
+			if (outputLength && outputTag)
+			{
+				snprintf(buf, sizeof(buf), "%s %s\n", outputTag, outputLine);
+#ifdef SERVER_THREADS
+				length = strlen(buf);
+				pthread_mutex_lock(&serverLock);
+				if (pendingLength + length + 1 > pendingSize)
+				{
+					size = pendingSize ? pendingSize : 4096;
+					while (size < pendingLength + length + 1) size *= 2;
+					bigger = (char *) realloc(pendingOutput, size);
+					if (bigger)
+					{
+						pendingOutput = bigger;
+						pendingSize = size;
+					}
+				}
+				if (pendingLength + length + 1 <= pendingSize)
+				{
+					memcpy(pendingOutput + pendingLength, buf, length + 1);
+					pendingLength += length;
+				}
+				pthread_mutex_unlock(&serverLock);
+#else
+				outputToStdout(buf);
+#endif
+			}
+			outputLength = 0;
+		}
+		else if (outputLength < MAX_STRING - 1)
+		{
+			outputLine[outputLength++] = *str;
+		}
+	}
+}
+
+
+/* Function: serverInput
+ * Input:    A line
+ * Output:   None
+ * Purpose:  Is inputHook.  "stop" is done right away, all other lines
+ *           wait their turn.  A "go" that waits when its game is stopped
+ *           only searches 1 ply.
+ */
+
+static void serverInput(const char *str)
+{
+	char name[MAX_STRING], command[MAX_STRING];
+	char lineName[MAX_STRING], lineCommand[MAX_STRING];
+	serverLine *line;
+#ifdef SERVER_THREADS
+	int n;
+#endif
+
+	name[0] = command[0] = '\0';
+	sscanf(str, "%s %s", name, command);
+
+	/* Don't read past "quit" (or the end of the input), and answer the
+	   searches now */
+
+	if (!strcmp(name, "quit"))
+	{
+		ignoreInput = 1;
+#ifdef SERVER_THREADS
+		pthread_mutex_lock(&serverLock);
+		for (n = 0; n < workerCount; n++)
+		{
+			if (workers[n].game) workers[n].stopped = 1;
+			if (workers[n].stop) *workers[n].stop = 1;
+		}
+		pthread_mutex_unlock(&serverLock);
+#else
+		stopThinking = 1;
+#endif
+	}
+
+	if (!strcmp(command, "stop"))
+	{
+#ifdef SERVER_THREADS
+		pthread_mutex_lock(&serverLock);
+		for (n = 0; n < workerCount; n++)
+		{
+			if (!workers[n].game || strcmp(name, workers[n].game->name)) continue;
+			workers[n].stopped = 1;
+			if (workers[n].stop) *workers[n].stop = 1;
+		}
+		pthread_mutex_unlock(&serverLock);
+#else
+		if (searchingGame && !strcmp(name, searchingGame->name))
+			stopThinking = 1;
+#endif
+
+		for (line = firstLine; line; line = line->next)
+		{
+			lineName[0] = lineCommand[0] = '\0';
+			sscanf(line->str, "%s %s", lineName, lineCommand);
+			if (!strcmp(lineName, name) && !strcmp(lineCommand, "go"))
+				snprintf(line->str, MAX_STRING, "%s go 1", name);
+		}
+		return;
+	}
+
+	line = (serverLine *) malloc(sizeof(serverLine));
+	if (!line)
+	{
+		output("Not enough memory for the input\n");
+		exit(1);
+	}
+	strcpy(line->str, str);
+	line->next = NULL;
+
+	if (lastLine) lastLine->next = line;
+	else firstLine = line;
+	lastLine = line;
+}
+
+
+/* Function: findGame
+ * Input:    The name of a game
+ * Output:   Its slot in games[], or -1
+ * Purpose:  Looks up a game.
+ */
+
+static int findGame(const char *name)
+{
+	int n;
+
+	for (n = 0; n < SERVER_GAMES; n++)
+	{
+		if (games[n] && !strcmp(games[n]->name, name)) return n;
+	}
+	return -1;
+}
+
+
+/* Function: serverSearch
+ * Input:    A game, and the depth and time limits
+ * Output:   None
+ * Purpose:  Searches the game's position and answers with the move.
+ */
+
+static void serverSearch(serverGame *game, int depth, int milliseconds)
+{
+	char buf[2 * MAX_STRING], moveString[MAX_STRING];
+	int value, result;
+
+	outputTag = game->name;
+	analyzeBoard(&game->board, game->variant);
+
+	result = analyzeSearch(depth, milliseconds, moveString, &value);
+
+	if (result == -1) sprintf(buf, "nomove %d\n", value);
+	else sprintf(buf, "%s %s %d\n", result ? "sit" : "bestmove", moveString, value);
+	output(buf);
+
+	outputTag = NULL;
+}
+
+
+#ifdef SERVER_THREADS
+
+/* Function: serverWorkerLoop
+ * Input:    Its slot in workers[]
+ * Output:   NULL
+ * Purpose:  Is a worker thread.  Does the searches the main thread gives
+ *           it until the server quits.
+ */
+
+static void *serverWorkerLoop(void *data)
+{
+	serverWorker *worker = (serverWorker *) data;
+	serverGame *game;
+	int depth;
+
+	ignoreInput = 1;
+
+	pthread_mutex_lock(&serverLock);
+	for (;;)
+	{
+		while (!worker->game && !quitWorkers)
+			pthread_cond_wait(&workerWake, &serverLock);
+		if (!worker->game) break;
+
+		game = worker->game;
+		depth = worker->stopped ? 1 : worker->depth;
+		worker->stop = &stopThinking;
+		pthread_mutex_unlock(&serverLock);
+
+		serverSearch(game, depth, worker->milliseconds);
+
+		pthread_mutex_lock(&serverLock);
+		worker->stop = NULL;
+		worker->game = NULL;
+		worker->stopped = 0;
+		game->searching = 0;
+	}
+	pthread_mutex_unlock(&serverLock);
+
+	gameBoard.freeStacks();
+	AIBoard.freeStacks();
+
+	return NULL;
+}
+
+
+/* Function: freeWorker
+ * Input:    None
+ * Output:   A worker that doesn't search, or NULL
+ * Purpose:  Finds a worker for a "go".  Call with serverLock held.
+ */
+
+static serverWorker *freeWorker()
+{
+	int n;
+
+	for (n = 0; n < workerCount; n++)
+	{
+		if (!workers[n].game) return &workers[n];
+	}
+	return NULL;
+}
+
+
+/* Function: writePendingOutput
+ * Input:    None
+ * Output:   None
+ * Purpose:  Writes what the workers printed.
+ */
+
+static void writePendingOutput()
+{
+	pthread_mutex_lock(&serverLock);
+	if (pendingLength)
+	{
+		outputToStdout(pendingOutput);
+		pendingLength = 0;
+	}
+	pthread_mutex_unlock(&serverLock);
+}
+
+#endif
+
+
+/* Function: serverCommand
+ * Input:    A line
+ * Output:   None
+ * Purpose:  Does what a line says, see the top of the file.  A "go" is
+ *           given to a free worker.
+ */
+
+static void serverCommand(const char *str)
+{
+	char name[MAX_STRING], command[MAX_STRING], arg[MAX_STRING];
+	int n, changed, depth, milliseconds;
+	serverGame *game;
+	const char *rest;
+	move m;
+#ifdef SERVER_THREADS
+	serverWorker *worker;
+#endif
+
+	name[0] = command[0] = arg[0] = '\0';
+	sscanf(str, "%s %s %s", name, command, arg);
+	if (!name[0]) return;
+
+	if (!strcmp(name, "quit"))
+	{
+		quitServer = 1;
+		return;
+	}
+	if (!strcmp(name, "memory"))
+	{
+		if (makeTranspositionTable(atoi(command) * 1024 * 1024) == -1)
+			makeTranspositionTable(MIN_HASH_SIZE);
+		return;
+	}
+
+	/* The rest of the line after the command */
+
+	rest = str;
+	for (n = 0; n < 4; n++)
+	{
+		if (n & 1) while (*rest && *rest != ' ' && *rest != '\t') rest++;
+		else while (*rest == ' ' || *rest == '\t') rest++;
+	}
+	while (*rest == ' ' || *rest == '\t') rest++;
+
+	outputTag = name;
+	n = findGame(name);
+
+	if (!strcmp(command, "new"))
+	{
+		if (n == -1)
+		{
+			for (n = 0; n < SERVER_GAMES && games[n]; n++);
+			if (n == SERVER_GAMES ||
+				!(games[n] = (serverGame *) calloc(1, sizeof(serverGame))))
+			{
+				output("error too many games\n");
+				outputTag = NULL;
+				return;
+			}
+			strcpy(games[n]->name, name);
+		}
+		game = games[n];
+		game->variant = strcmp(arg, "bughouse") ? CRAZYHOUSE : BUGHOUSE;
+
+		/* A new game has no position to copy to gameBoard yet */
+
+		gameBoard.resetBoard();
+		if (game->variant == BUGHOUSE) gameBoard.playBughouse();
+		else gameBoard.playCrazyhouse();
+		gameBoard.copy(&game->board);
+	}
+	else if (n == -1)
+	{
+		output("error no such game\n");
+	}
+	else if (!strcmp(command, "close"))
+	{
+		games[n]->board.freeStacks();
+		free(games[n]);
+		games[n] = NULL;
+	}
+	else if (!strcmp(command, "go"))
+	{
+		game = games[n];
+		depth = milliseconds = 0;
+		sscanf(rest, "%d %d", &depth, &milliseconds);
+
+#ifdef SERVER_THREADS
+		pthread_mutex_lock(&serverLock);
+		worker = freeWorker();
+		worker->game = game;
+		worker->depth = depth;
+		worker->milliseconds = milliseconds;
+		worker->stopped = 0;
+		game->searching = 1;
+		pthread_cond_broadcast(&workerWake);
+		pthread_mutex_unlock(&serverLock);
+#else
+		searchingGame = game;
+		serverSearch(game, depth, milliseconds);
+		searchingGame = NULL;
+#endif
+	}
+	else
+	{
+		game = games[n];
+		analyzeBoard(&game->board, game->variant);
+		changed = 0;
+
+		if (!strcmp(command, "setboard"))
+		{
+			if (parseFEN(rest)) output("error bad FEN\n");
+			else changed = 1;
+		}
+		else if (!strcmp(command, "holding"))
+		{
+			parseHolding(rest);
+			changed = 1;
+		}
+		else if (!strcmp(command, "move"))
+		{
+			m = gameBoard.algebraicMoveToDBMove(arg);
+			if (m.isBad() || gameBoard.playMove(m, 0)) output("error illegal move\n");
+			else changed = 1;
+		}
+		else
+		{
+			output("error unknown command\n");
+		}
+
+		if (changed) gameBoard.copy(&game->board);
+	}
+
+	outputTag = NULL;
+}
+
+
+/* Function: nextLine
+ * Input:    None
+ * Output:   The first line that can be done now, NULL if there is none
+ * Purpose:  Takes the line out of the lines not done yet.  A line waits
+ *           for the lines of its game before it and while its game
+ *           searches, "memory" and "quit" wait for all of them, and a
+ *           "go" for a free worker.
+ */
+
+static serverLine *nextLine()
+{
+	char name[MAX_STRING], command[MAX_STRING];
+	char lineName[MAX_STRING];
+	serverLine *line, *previous, *before;
+	int wait;
+#ifdef SERVER_THREADS
+	int n;
+#endif
+
+	for (previous = NULL, line = firstLine; line;
+		previous = line, line = line->next)
+	{
+		name[0] = command[0] = '\0';
+		sscanf(line->str, "%s %s", name, command);
+
+		wait = 0;
+
+		if (!strcmp(name, "quit") || !strcmp(name, "memory"))
+		{
+			if (previous) return NULL;
+#ifdef SERVER_THREADS
+			pthread_mutex_lock(&serverLock);
+			for (n = 0; n < workerCount; n++)
+			{
+				if (workers[n].game) wait = 1;
+			}
+			pthread_mutex_unlock(&serverLock);
+			if (wait) return NULL;
+#endif
+		}
+		else
+		{
+#ifdef SERVER_THREADS
+			pthread_mutex_lock(&serverLock);
+			n = findGame(name);
+			if (n != -1 && games[n]->searching) wait = 1;
+			if (!strcmp(command, "go") && !freeWorker()) wait = 1;
+			pthread_mutex_unlock(&serverLock);
+#endif
+
+			for (before = firstLine; before != line && !wait; before = before->next)
+			{
+				lineName[0] = '\0';
+				sscanf(before->str, "%s", lineName);
+				if (!strcmp(lineName, name)) wait = 1;
+			}
+		}
+
+		if (wait) continue;
+
+		if (previous) previous->next = line->next;
+		else firstLine = line->next;
+		if (lastLine == line) lastLine = previous;
+
+		return line;
+	}
+
+	return NULL;
+}
+
+
+/* Function: server
+ * Input:    the arguments Sunsetter was called with
+ * Output:   0
+ * Purpose:  Initializes Sunsetter and plays games until "quit", see the
+ *           top of the file.
+ */
+
+int server(int argc, char **argv)
+{
+	serverLine *line;
+	int n;
+
+	/* What initialize() prints is about no game, so it is dropped */
+
+	outputHook = serverOutput;
+	initialize();
+	inputHook = serverInput;
+
+	/* The moves of one game don't make the entries of the others old */
+
+	sharedHashEngines = 1;
+
+#ifdef SERVER_THREADS
+	if (argc > 2) workerCount = atoi(argv[2]);
+	else workerCount = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	workerCount = max(1, min(workerCount, SERVER_MAX_THREADS));
+
+	for (n = 0; n < workerCount; n++)
+	{
+		if (pthread_create(&workers[n].thread, NULL, serverWorkerLoop, &workers[n]))
+		{
+			outputToStdout("Could not start the worker threads\n");
+			exit(1);
+		}
+	}
+
+	while (!quitServer)
+	{
+		while (!quitServer && (line = nextLine()))
+		{
+			serverCommand(line->str);
+			free(line);
+		}
+
+		writePendingOutput();
+		if (!checkInput()) usleep(1000);
+	}
+
+	pthread_mutex_lock(&serverLock);
+	quitWorkers = 1;
+	pthread_cond_broadcast(&workerWake);
+	pthread_mutex_unlock(&serverLock);
+
+	for (n = 0; n < workerCount; n++) pthread_join(workers[n].thread, NULL);
+	writePendingOutput();
+	free(pendingOutput);
+#else
+	while (!quitServer)
+	{
+		if (!firstLine) waitForInput();
+
+		while (!quitServer && (line = nextLine()))
+		{
+			serverCommand(line->str);
+			free(line);
+		}
+	}
+#endif
+
+	while (firstLine)
+	{
+		line = firstLine;
+		firstLine = line->next;
+		free(line);
+	}
+	lastLine = NULL;
+
+	for (n = 0; n < SERVER_GAMES; n++)
+	{
+		if (!games[n]) continue;
+		games[n]->board.freeStacks();
+		free(games[n]);
+		games[n] = NULL;
+	}
+
+	flushOutput(1);
+	outputHook = NULL;
+	inputHook = NULL;
+
+	return 0;
+}
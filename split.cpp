@@ -0,0 +1,572 @@
+/* ***************************************************************************
+ *                                Sunsetter                                  *
+ *               (c) Ben Dean-Kawamura, Georg v. Zimmermann                  *
+ *   For license terms, see the file COPYING that came with this program.    *
+ *                                                                           *
+ *  Name: split.cpp                                                          *
+ *  Purpose: Has the worker processes searchRoot() gives root moves to.      *
+ *                                                                           *
+ *  Comments: "workers <n>" forks n copies of Sunsetter, each with a Unix    *
+ * socket to us.  From the iteration SPLIT_DEPTH on, searchRoot() searches   *
+ * the first move itself and hands the others to the workers, a move to     *
+ * each worker that is free (see searchSplit() in search.cpp).  The socket   *
+ * is a worker's stdin, so it reads it with Input() like xboard commands:    *
+ *                                                                           *
+ *   search <job> <variant> <depth> <alpha> <beta> <move> <bytes>            *
+ *           followed by the bytes of AIBoard.pack(), the position with the  *
+ *           hands and ghost pieces.  The answer is                          *
+ *           "result <job> <value> <nodes> <pv>", or "stopped <job>" if    *
+ *           the worker couldn't search the move.                            *
+ *   stop    answer "stopped <job>" now.  A worker that isn't searching      *
+ *           doesn't answer, the next "search" makes it forget the stop.     *
+ *   quit    (or the end of the socket) the worker goes away.                *
+ *                                                                           *
+ *  The workers are forked from us when "workers" is given, so they have     *
+ * the options that were set before it.  With "sharedhash" before it they    *
+ * also use our transposition table, else each one has a copy of it.        *
+ *                                                                           *
+ *************************************************************************** */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "board.h"
+#include "brain.h"
+#include "interface.h"
+#include "notation.h"
+#include "variables.h"
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#define SPLIT_WORKERS
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <signal.h>
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
+extern SEARCH_LOCAL volatile int stopThinking;
+extern SEARCH_LOCAL int stats_positionsSearched;
+
+#ifdef SPLIT_WORKERS
+
+/* Most worker processes */
+#define MAX_WORKERS (64)
+
+/* How many milliseconds a worker gets to answer "stop" before it's lost */
+#define STOP_TIME (2000)
+
+struct splitWorker {
+	pid_t pid;
+	int socket;
+	int job;							/* The root move it searches, -1 if
+										   it is free */
+};
+
+static splitWorker workers[MAX_WORKERS];
+static int workerCount;
+
+/* What a worker was told to search */
+
+static char jobBoard[PACKED_BOARD_SIZE];
+static char jobMove[MAX_STRING];
+static int jobNumber, jobRules, jobDepth, jobAlpha, jobBeta;
+static int jobWaiting, quitWorker;
+
+
+/* Function: writeAll
+ * Input:    A socket, what to write and how many bytes
+ * Output:   0, -1 if the other end is gone
+ * Purpose:  write() that doesn't stop before it's done.
+ */
+
+static int writeAll(int fd, const char *buf, int bytes)
+{
+	int written;
+
+	while (bytes > 0)
+	{
+		written = send(fd, buf, bytes, MSG_NOSIGNAL);
+		if (written <= 0) return -1;
+		buf += written;
+		bytes -= written;
+	}
+	return 0;
+}
+
+
+/* Function: readAll
+ * Input:    A socket, where to read to and how many bytes
+ * Output:   0, -1 if the other end is gone
+ * Purpose:  read() that waits until it has all of the bytes.
+ */
+
+static int readAll(int fd, char *buf, int bytes)
+{
+	int got;
+
+	while (bytes > 0)
+	{
+		got = read(fd, buf, bytes);
+		if (got <= 0) return -1;
+		buf += got;
+		bytes -= got;
+	}
+	return 0;
+}
+
+
+/* Function: readLine
+ * Input:    A socket and room for MAX_STRING bytes
+ * Output:   0, -1 if the other end is gone
+ * Purpose:  Reads a line the other end wrote with one writeAll(), so it
+ *           is all there or will be in a moment.
+ */
+
+static int readLine(int fd, char *str)
+{
+	int n = 0;
+	char ch;
+
+	for (;;)
+	{
+		if (read(fd, &ch, 1) != 1) return -1;
+		if (ch == '\n') break;
+		if (n < MAX_STRING - 1) str[n++] = ch;
+	}
+	str[n] = '\0';
+	return 0;
+}
+
+
+/* Function: workerOutput
+ * Input:    A string
+ * Output:   None
+ * Purpose:  Is outputHook in a worker.  Nothing the search prints goes
+ *           anywhere, our stdout is still the one of the program that
+ *           forked us.
+ */
+
+static void workerOutput(const char *str)
+{
+}
+
+
+/* Function: workerInput
+ * Input:    A line from the socket
+ * Output:   None
+ * Purpose:  Is inputHook in a worker, see the top of the file.
+ */
+
+static void workerInput(const char *str)
+{
+	char command[MAX_STRING];
+	int bytes;
+
+	command[0] = '\0';
+	sscanf(str, "%s", command);
+
+	if (!strcmp(command, "stop"))
+	{
+		stopThinking = 1;
+	}
+	else if (!strcmp(command, "quit"))
+	{
+		quitWorker = stopThinking = 1;
+		ignoreInput = 1;
+	}
+	else if (!strcmp(command, "search"))
+	{
+		/* The board comes right after the line, Input() reads a byte at a
+		   time so it is still in the socket */
+
+		bytes = 0;
+		if (sscanf(str, "%*s %d %d %d %d %d %s %d", &jobNumber, &jobRules,
+			&jobDepth, &jobAlpha, &jobBeta, jobMove, &bytes) != 7 ||
+			bytes <= 0 || bytes > (int) PACKED_BOARD_SIZE ||
+			readAll(0, jobBoard, bytes))
+		{
+			quitWorker = stopThinking = 1;
+			ignoreInput = 1;
+			return;
+		}
+
+		/* A "stop" before this one was for the move we had, it may have
+		   come after we answered */
+
+		stopThinking = 0;
+		jobWaiting = 1;
+	}
+}
+
+
+/* Function: workerSearch
+ * Input:    None
+ * Output:   None
+ * Purpose:  Searches what the coordinator sent and answers it.
+ */
+
+static void workerSearch()
+{
+	char buf[2 * MAX_STRING], pvText[MAX_STRING];
+	move m;
+	int value;
+
+	jobWaiting = 0;
+
+	AIBoard.unpack(jobBoard);
+	currentRules = (rules) jobRules;
+
+	m = AIBoard.algebraicMoveToDBMove(jobMove);
+	if (!AIBoard.isPseudoLegal(m))
+	{
+		sprintf(buf, "stopped %d\n", jobNumber);
+		writeAll(0, buf, strlen(buf));
+		return;
+	}
+
+	/* The coordinator decides when to stop */
+
+	gameBoard.setLastMoveNow();
+	millisecondsPerMove = 1e12;
+
+	stats_positionsSearched = 0;
+
+	value = searchRootMove(m, jobDepth, jobAlpha, jobBeta, pvText);
+
+	if (stopThinking) sprintf(buf, "stopped %d\n", jobNumber);
+	else sprintf(buf, "result %d %d %d %s\n", jobNumber, value,
+		stats_positionsSearched, pvText);
+	writeAll(0, buf, strlen(buf));
+}
+
+
+/* Function: runWorker
+ * Input:    Our end of the socket
+ * Output:   None, it doesn't return
+ * Purpose:  Is what a forked worker does until "quit".
+ */
+
+static void runWorker(int fd)
+{
+	int n;
+
+	/* The sockets to the workers forked before us are the coordinator's */
+
+	for (n = 0; n < workerCount; n++) close(workers[n].socket);
+	workerCount = 0;
+
+	dup2(fd, 0);
+	close(fd);
+
+#ifdef LOG
+	logFile = NULL;
+#endif
+
+	inputHook = workerInput;
+	outputHook = workerOutput;
+	ignoreInput = 0;
+
+	analyzeMode = xboardMode = gameInProgress = 1;
+	forceMode = pondering = tryToPonder = learning = sitting = 0;
+	FIXED_DEPTH = FIXED_TIME = 0;
+
+	while (!quitWorker)
+	{
+		if (!jobWaiting) waitForInput();
+		if (jobWaiting && !quitWorker) workerSearch();
+	}
+
+	_exit(0);
+}
+
+
+/* Function: stopWorkers
+ * Input:    None
+ * Output:   None
+ * Purpose:  Tells the workers to quit and waits until they're gone.
+ */
+
+static void stopWorkers()
+{
+	int n;
+
+	for (n = 0; n < workerCount; n++)
+	{
+		writeAll(workers[n].socket, "quit\n", 5);
+		close(workers[n].socket);
+		waitpid(workers[n].pid, NULL, 0);
+	}
+	workerCount = 0;
+}
+
+
+/* Function: loseWorker
+ * Input:    A worker that doesn't answer anymore
+ * Output:   None
+ * Purpose:  Forgets the worker.
+ */
+
+static void loseWorker(int n)
+{
+	char buf[MAX_STRING];
+
+	sprintf(buf, "Lost worker %d\n", (int) workers[n].pid);
+	output(buf);
+
+	kill(workers[n].pid, SIGKILL);
+	close(workers[n].socket);
+	waitpid(workers[n].pid, NULL, 0);
+
+	workers[n] = workers[--workerCount];
+}
+
+#endif
+
+
+/* Function: startWorkers
+ * Input:    How many workers there should be
+ * Output:   How many there are
+ * Purpose:  Replaces the workers with count new ones, forked from where
+ *           we are now.
+ */
+
+int startWorkers(int count)
+{
+#ifdef SPLIT_WORKERS
+	int fd[2];
+	pid_t pid;
+
+	stopWorkers();
+
+	/* Or the workers would have what output() kept too */
+
+	flushOutput(1);
+
+	count = min(count, MAX_WORKERS);
+	while (workerCount < count)
+	{
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, fd)) break;
+
+		pid = fork();
+		if (pid == -1)
+		{
+			close(fd[0]);
+			close(fd[1]);
+			break;
+		}
+		if (!pid)
+		{
+			close(fd[0]);
+			runWorker(fd[1]);
+		}
+
+		close(fd[1]);
+		workers[workerCount].pid = pid;
+		workers[workerCount].socket = fd[0];
+		workers[workerCount].job = -1;
+		workerCount++;
+	}
+
+	return workerCount;
+#else
+	if (count) output("Workers are not supported on this system\n");
+	return 0;
+#endif
+}
+
+
+/* Function: splitWorkers
+ * Input:    None
+ * Output:   How many workers there are
+ * Purpose:  Lets searchRoot() know if it can split.
+ */
+
+int splitWorkers()
+{
+#ifdef SPLIT_WORKERS
+	return workerCount;
+#else
+	return 0;
+#endif
+}
+
+
+/* Function: splitIdleWorker
+ * Input:    None
+ * Output:   A worker that isn't searching, -1 if they all are
+ * Purpose:  Finds where the next root move can go.
+ */
+
+int splitIdleWorker()
+{
+#ifdef SPLIT_WORKERS
+	int n;
+
+	for (n = 0; n < workerCount; n++)
+	{
+		if (workers[n].job == -1) return n;
+	}
+#endif
+	return -1;
+}
+
+
+/* Function: splitSend
+ * Input:    A free worker, the number of the root move, the move, the
+ *           depth and the window
+ * Output:   None
+ * Purpose:  Has the worker search the move of AIBoard.  If the worker is
+ *           gone the answer is that it was lost, see splitReceive().
+ */
+
+void splitSend(int worker, int job, move m, int depth, int alpha, int beta)
+{
+#ifdef SPLIT_WORKERS
+	static char buf[MAX_STRING + PACKED_BOARD_SIZE];
+	char moveString[MAX_STRING];
+	int length, bytes;
+
+	DBMoveToRawAlgebraicMove(m, moveString);
+
+	bytes = AIBoard.pack(buf + MAX_STRING);
+	length = sprintf(buf, "search %d %d %d %d %d %s %d\n", job,
+		(int) currentRules, depth, alpha, beta, moveString, bytes);
+
+	memmove(buf + length, buf + MAX_STRING, bytes);
+
+	workers[worker].job = job;
+	if (writeAll(workers[worker].socket, buf, length + bytes))
+	{
+		/* splitReceive() finds it when the socket says it's closed */
+		shutdown(workers[worker].socket, SHUT_WR);
+	}
+#endif
+}
+
+
+/* Function: splitReceive
+ * Input:    Where to put the number of the root move, its value, how many
+ *           nodes it took and the principal variation
+ * Output:   1 if a worker answered, 0 if none did for 10 milliseconds,
+ *           2 if the worker couldn't search the move, -1 if the worker 
+ *           searching the move was lost
+ * Purpose:  Waits a moment for the answer of a worker.  A lost worker is
+ *           gone after this, its move has to be searched again.  One that
+ *           couldn't search its move is free again.
+ */
+
+int splitReceive(int *job, int *value, int *nodes, char *pvText)
+{
+#ifdef SPLIT_WORKERS
+	char str[MAX_STRING];
+	fd_set sockets;
+	struct timeval tv;
+	int n, highest = -1, got;
+
+	FD_ZERO(&sockets);
+	for (n = 0; n < workerCount; n++)
+	{
+		if (workers[n].job == -1) continue;
+		FD_SET(workers[n].socket, &sockets);
+		highest = max(highest, workers[n].socket);
+	}
+	if (highest == -1) return 0;
+
+	tv.tv_sec = 0; tv.tv_usec = 10000;
+	if (select(highest + 1, &sockets, NULL, NULL, &tv) <= 0) return 0;
+
+	for (n = 0; n < workerCount; n++)
+	{
+		if (workers[n].job == -1 || !FD_ISSET(workers[n].socket, &sockets))
+			continue;
+
+		*job = workers[n].job;
+		workers[n].job = -1;
+
+		pvText[0] = '\0';
+		got = 0;
+		if (readLine(workers[n].socket, str))
+		{
+			loseWorker(n);
+			return -1;
+		}
+		if (!strncmp(str, "stopped", 7)) return 2;
+		if (sscanf(str, "result %*d %d %d %n", value, nodes, &got) < 2)
+		{
+			loseWorker(n);
+			return -1;
+		}
+
+		strcpy(pvText, str + got);
+		return 1;
+	}
+#endif
+	return 0;
+}
+
+
+/* Function: splitCancel
+ * Input:    None
+ * Output:   None
+ * Purpose:  Stops the workers that search and waits for them to answer,
+ *           so they are free for the next time.  The ones that don't 
+ *           answer within STOP_TIME milliseconds are lost.
+ */
+
+void splitCancel()
+{
+#ifdef SPLIT_WORKERS
+	char str[MAX_STRING];
+	fd_set sockets;
+	struct timeval tv;
+	long stopTime, left;
+	int n, highest;
+
+	for (n = 0; n < workerCount; n++)
+	{
+		if (workers[n].job != -1)
+			writeAll(workers[n].socket, "stop\n", 5);
+	}
+
+	stopTime = getSysMilliSecs() + STOP_TIME;
+	for (;;)
+	{
+		FD_ZERO(&sockets);
+		highest = -1;
+		for (n = 0; n < workerCount; n++)
+		{
+			if (workers[n].job == -1) continue;
+			FD_SET(workers[n].socket, &sockets);
+			highest = max(highest, workers[n].socket);
+		}
+		if (highest == -1) break;
+
+		left = max(stopTime - getSysMilliSecs(), 0L);
+		tv.tv_sec = left / 1000; tv.tv_usec = (left % 1000) * 1000;
+		if (select(highest + 1, &sockets, NULL, NULL, &tv) <= 0)
+		{
+			for (n = 0; n < workerCount; n++)
+			{
+				if (workers[n].job != -1) loseWorker(n--);
+			}
+			break;
+		}
+
+		for (n = 0; n < workerCount; n++)
+		{
+			if (workers[n].job == -1 || !FD_ISSET(workers[n].socket, &sockets))
+				continue;
+
+			workers[n].job = -1;
+			if (readLine(workers[n].socket, str)) loseWorker(n--);
+		}
+	}
+#endif
+}
@@ -64,6 +64,8 @@ void nextToken(FILE *f, char *str)
 
     return;
   }
+  if(c == '*') return;            /* the result of an unfinished game, the
+                                     next token may follow right after it */
   if(fscanf(f, "%s", buf)!= EOF) strcat(str, buf);
   return;
 }
@@ -359,13 +361,13 @@ int speedtest(int argc, char **argv)
 	for (n = movesInGame; n >= 1; n--) 
 	{
 		gameBoard.unchangeBoard(); 
-		for (a = 0; a < REPEATCOUNT; a++) AIBoard.aiMoves(moves);
+		for (a = 0; a < REPEATCOUNT; a++) gameBoard.aiMoves(moves);
 	}	
 
 	for (n = 1; n <= movesInGame; n++) 
 	{
 		gameBoard.changeBoard(gameMoves[n]); 				
-		for (a = 0; a < REPEATCOUNT; a++) AIBoard.aiMoves(moves);
+		for (a = 0; a < REPEATCOUNT; a++) gameBoard.aiMoves(moves);
 	}
 
 	endClockTime = getSysMilliSecs();
@@ -376,6 +378,60 @@ int speedtest(int argc, char **argv)
 		( ((movesInGame * REPEATCOUNT *2) / (((int) (endClockTime - startClockTime)))) * 1000 ) ); 
 	output (buf); 
 
+	output ("\n\n starting legal MoveGen speed test ... \n"); 
+
+	startClockTime = getSysMilliSecs();
+
+	for (n = movesInGame; n >= 1; n--) 
+	{
+		gameBoard.unchangeBoard(); 
+		for (a = 0; a < REPEATCOUNT / 10; a++) gameBoard.moves(moves);
+	}	
+
+	for (n = 1; n <= movesInGame; n++) 
+	{
+		gameBoard.changeBoard(gameMoves[n]); 				
+		for (a = 0; a < REPEATCOUNT / 10; a++) gameBoard.moves(moves);
+	}
+
+	endClockTime = getSysMilliSecs();
+
+	sprintf (buf, "%d legal MoveGen at ", movesInGame * (REPEATCOUNT / 10) *2);
+	output (buf); 
+	sprintf (buf, "%d legal MoveGen per second. \n",
+		( ((movesInGame * (REPEATCOUNT / 10) *2) / (((int) (endClockTime - startClockTime) + 1))) * 1000 ) ); 
+	output (buf); 
+
+	/* clone() should take the same time at the start and the end of the 
+	   game, copy() gets slower as the game gets longer */
+
+	output ("\n\n starting clone speed test ... \n"); 
+
+	for (n = movesInGame; n >= 1; n--) gameBoard.unchangeBoard(); 
+
+	for (a = 0; a < 2; a++)
+	{
+		startClockTime = getSysMilliSecs();
+		for (n = 0; n < REPEATCOUNT * 10; n++) gameBoard.clone(&AIBoard);
+		endClockTime = getSysMilliSecs();
+
+		sprintf (buf, "%d clone() at move %d, %d clone per second. \n", 
+			REPEATCOUNT * 10, gameBoard.getMoveNum(), 
+			( ((REPEATCOUNT * 10) / (((int) (endClockTime - startClockTime) + 1))) * 1000 ) ); 
+		output (buf); 
+
+		startClockTime = getSysMilliSecs();
+		for (n = 0; n < REPEATCOUNT * 10; n++) gameBoard.copy(&AIBoard);
+		endClockTime = getSysMilliSecs();
+
+		sprintf (buf, "%d copy() at move %d, %d copy per second. \n", 
+			REPEATCOUNT * 10, gameBoard.getMoveNum(), 
+			( ((REPEATCOUNT * 10) / (((int) (endClockTime - startClockTime) + 1))) * 1000 ) ); 
+		output (buf); 
+
+		for (n = 1; n <= movesInGame; n++) gameBoard.changeBoard(gameMoves[n]); 
+	}
+
 	fclose(fin);
 
 	return(0);        
@@ -34,6 +34,17 @@
  *            castling posibilities and what square, if any, en passant can  *
  *            be played on.                                                  *
  *                                                                           *
+ *            The random numbers come from our own generator, not rand(),    *
+ *            so every platform gets the same keys and the learn file stays  *
+ *            usable when it is moved between machines.                      *
+ *                                                                           *
+ *            The table can be a POSIX shared memory segment ("sharedhash"), *
+ *            so engines on one machine use each other's results.  There    *
+ *            are no locks, the hash in an entry is XORed with a checksum of *
+ *            the rest of it (entryCheck()).  An entry that another process  *
+ *            was writing while we read it doesn't match any position then.  *
+ *            The search always goes through a copy of the entry.           *
+ *                                                                           *
  *************************************************************************** */
 
 #include <stdlib.h>
@@ -47,12 +58,18 @@
 #include "notation.h"
 #include "brain.h"
 
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#define SHARED_HASH
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 
-extern int stats_hashFillingUp;
-extern int stats_hashSize; 
 
-qword ssrandom64(void); 
+extern SEARCH_LOCAL int stats_hashFillingUp;
+extern SEARCH_LOCAL int stats_hashSize; 
 
 transpositionEntry *lookupTable[COLORS]={NULL,NULL};
 transpositionEntry *learnTable[COLORS]={NULL,NULL}; 
@@ -60,36 +77,16 @@ transpositionEntry *learnTable[COLORS]={NULL,NULL};
 duword lookupMask;
 duword learnMask; 
 
-/* hashNumbers is an array of random numbers for generating a hash value. */
-
-qword hashNumbers[COLORS][PIECES][64];
-qword hashHandNumbers[COLORS][PIECES][17];
-qword hashCastleNumbers[COLORS][2];
-qword hashEnPassantNumbers[66];  /* 66 to include room for OFF_BOARD */
-
-#ifdef DEBUG_HASH
-qword hashNumbersT[COLORS][PIECES][64];
-qword hashHandNumbersT[COLORS][PIECES][17];
-qword hashCastleNumbersT[COLORS][2];
-qword hashEnPassantNumbersT[66];  /* 66 to include room for OFF_BOARD */
-#endif
-
-/* Function: ssrandom64
- * Input:    None.
- * Output:   A random 64 bit number.
- * Purpose:  Used for the Zobrist hashing. 
- *
- */
-
-qword ssrandom64(void) {
-  
- 	return (((qword) (rand() & 0xFFFF)) |         
-		    ((qword) (rand() & 0xFFFF) << 16) |   
-		    ((qword) (rand() & 0xFFFF) << 32) |   
-		    ((qword) (rand() & 0xFFFF) << 48)); 
-
-}
+char sharedHashName[MAX_STRING];	/* The shared memory segment of the 
+									transposition table, "" if it's 
+									our own */
+static size_t sharedHashBytes;		/* How much of it is mapped */
+int sharedHashEngines;				/* If more engines of this process 
+									use the table, see libsunsetter.cpp
+									and server.cpp */
 
+/* The random numbers of the hash values are in tables.cpp, see
+   gentables.cpp */
 
 
 /* Function: saveLearnTableToDisk
@@ -184,6 +181,87 @@ void readLearnTableFromDisk()
 
 
 
+/* Function: attachSharedTable
+ * Input:    How many entries per color we would like.
+ * Output:   How many there are, 0 if it didn't work.
+ * Purpose:  Maps the segment sharedHashName as the transposition table.
+ *           The first process makes it as big as it likes, the others 
+ *           take it as it is.  It stays until it's removed from /dev/shm.
+ */
+
+static unsigned int attachSharedTable(unsigned int size)
+{
+#ifdef SHARED_HASH
+  char name[MAX_STRING + 1];
+  struct stat st;
+  void *table;
+  int fd, n;
+
+  sprintf(name, "%s%s", (sharedHashName[0] == '/') ? "" : "/", sharedHashName);
+
+  fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd >= 0)
+  {
+    if (ftruncate(fd, (off_t) size * 2 * sizeof(transpositionEntry)))
+    {
+      close(fd);
+      shm_unlink(name);
+      return 0;
+    }
+  }
+  else if ((fd = shm_open(name, O_RDWR, 0600)) < 0) return 0;
+
+  /* If another process just made it, it may not have its size yet */
+
+  for (n = 0; !fstat(fd, &st) && (st.st_size == 0) && (n < 100); n++) 
+	  usleep(10000);
+
+  if ((st.st_size < (off_t) MIN_HASH_SIZE) || 
+      ((table = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, 
+                     fd, 0)) == MAP_FAILED))
+  {
+    close(fd);
+    return 0;
+  }
+  close(fd);
+
+  size = (unsigned int) (st.st_size / (2 * sizeof(transpositionEntry)));
+  for (n = 1; (unsigned int) n * 2 <= size; n *= 2);
+  size = n;
+
+  sharedHashBytes = st.st_size;
+  lookupTable[WHITE] = (transpositionEntry *) table;
+  lookupTable[BLACK] = lookupTable[WHITE] + size;
+  return size;
+#else
+  return 0;
+#endif
+}
+
+
+/* Function: freeLookupTable
+ * Input:    None.
+ * Output:   None.
+ * Purpose:  Frees or unmaps the transposition table.
+ */
+
+static void freeLookupTable()
+{
+#ifdef SHARED_HASH
+  if (sharedHashBytes)
+  {
+    munmap(lookupTable[WHITE], sharedHashBytes);
+    sharedHashBytes = 0;
+    lookupTable[WHITE] = lookupTable[BLACK] = NULL;
+  }
+#endif
+
+  if(lookupTable[WHITE] != NULL) free(lookupTable[WHITE]);
+  if(lookupTable[BLACK] != NULL) free(lookupTable[BLACK]);
+  lookupTable[WHITE] = lookupTable[BLACK] = NULL;
+}
+
+
 /* Function: makeTranspositionTable
  * Input:    the size for the table.
  * Output:   0 if successfull, -1 if not.
@@ -196,8 +274,7 @@ int makeTranspositionTable(unsigned int size)
   unsigned int logOfSize, n;
   char buf[MAX_STRING];
 
-  if(lookupTable[WHITE] != NULL) free(lookupTable[WHITE]);
-  if(lookupTable[BLACK] != NULL) free(lookupTable[BLACK]);
+  freeLookupTable();
 
   if(learnTable[WHITE] != NULL) free(learnTable[WHITE]);
   if(learnTable[BLACK] != NULL) free(learnTable[BLACK]);
@@ -234,19 +311,36 @@ int makeTranspositionTable(unsigned int size)
     (transpositionEntry *) calloc(learnSize, sizeof(transpositionEntry));
   learnTable[BLACK] = 
     (transpositionEntry *) calloc(learnSize, sizeof(transpositionEntry));
-    
-  lookupTable[WHITE] = 
-    (transpositionEntry *) calloc(size, sizeof(transpositionEntry));
-  lookupTable[BLACK] = 
-    (transpositionEntry *) calloc(size, sizeof(transpositionEntry));
+
+  if (sharedHashName[0])
+  {
+    if ((n = attachSharedTable(size)) != 0) 
+    {
+      size = n;
+      lookupMask = size - 1;
+    }
+    else
+    {
+      output("Could not use the shared transposition table ");
+      output(sharedHashName);
+      output("\n");
+      sharedHashName[0] = '\0';
+    }
+  }
+
+  if (!sharedHashName[0])
+  {
+    lookupTable[WHITE] = 
+      (transpositionEntry *) calloc(size, sizeof(transpositionEntry));
+    lookupTable[BLACK] = 
+      (transpositionEntry *) calloc(size, sizeof(transpositionEntry));
+  }
   
   if(!lookupTable[WHITE] || !lookupTable[BLACK] ||
 	 !learnTable[WHITE] || !learnTable[BLACK]) 
   {
     output("Not enough memory to make the transposition tables\n");
-    if(lookupTable[WHITE]) free(lookupTable[WHITE]);
-    if(lookupTable[BLACK]) free(lookupTable[BLACK]);
-    lookupTable[WHITE] = lookupTable[BLACK] = NULL;
+    freeLookupTable();
 	if(learnTable[WHITE]) free(learnTable[WHITE]);
     if(learnTable[BLACK]) free(learnTable[BLACK]);
     learnTable[WHITE] = learnTable[BLACK] = NULL;
@@ -255,7 +349,8 @@ int makeTranspositionTable(unsigned int size)
     return -1;
   }
 
-  sprintf(buf, "Created %d byte transposition table and %d byte learn table.\n\n", 
+  sprintf(buf, "%s %d byte transposition table and %d byte learn table.\n\n", 
+	  sharedHashName[0] ? "Attached" : "Created",
 	  (int)(size * sizeof(transpositionEntry) * 2),
 	  (int)(learnSize * sizeof(transpositionEntry) * 2));
   
@@ -280,79 +375,20 @@ void boardStruct::initHash()
   int n;
   bitboard bb;
   square sq;
-  static int generatedNumbers = 0;
-
-
-  if(!generatedNumbers) {
-
-	
-	 /* Use one seed, else the simple learning can't work. */ 
-	  
-	 srand(80180);
-    
-	 /* Generate the random numbers in the hash tables */
-    
-
-    for(c = FIRST_COLOR; c <= LAST_COLOR; c = (color) (c + 1)) 
-	{
-      for(p = FIRST_PIECE; p <= LAST_PIECE; p = (piece) (p + 1)) 
-	  {
-		for(n = 0; n < 64; n++)
-		{
-		hashNumbers[c][p][n] = ssrandom64();
-
-#ifdef DEBUG_HASH
-		hashNumbersT[c][p][n] = ssrandom64();
-#endif
-		}
-      }
-    }
-	
-	for(c = FIRST_COLOR; c <= LAST_COLOR; c = (color) (c + 1)) 
-	{
-      for(p = FIRST_PIECE; p <= LAST_PIECE; p = (piece) (p + 1)) 
-	  {
-		for(n = 0; n < 17; n++)
-		{
-		hashHandNumbers[c][p][n] = ssrandom64();
-
-#ifdef DEBUG_HASH
-		hashHandNumbersT[c][p][n] = ssrandom64();
-#endif
-		}
-      }
-    }
-    
-	for(n = 0; n < 66; n++) 
-	{
-		hashEnPassantNumbers[n] = ssrandom64();
-
-#ifdef DEBUG_HASH
-		hashEnPassantNumbersT[n] = ssrandom64();
-#endif
-	}
-    
-	
-	hashCastleNumbers[WHITE][KING_SIDE] = ssrandom64();
-    hashCastleNumbers[WHITE][QUEEN_SIDE] = ssrandom64();
-    hashCastleNumbers[BLACK][KING_SIDE] = ssrandom64();
-    hashCastleNumbers[BLACK][QUEEN_SIDE] = ssrandom64();
-
-#ifdef DEBUG_HASH
-	hashCastleNumbersT[WHITE][KING_SIDE] = ssrandom64();
-    hashCastleNumbersT[WHITE][QUEEN_SIDE] = ssrandom64();
-    hashCastleNumbersT[BLACK][KING_SIDE] = ssrandom64();
-    hashCastleNumbersT[BLACK][QUEEN_SIDE] = ssrandom64();
-#endif
- 
-
-	srand(time(NULL));
-  }
 
   /* Make a hash value for the position */
 
   hashValue = qword(0);
 
+  /* The hands are not part of the hash value here, but the material 
+     table needs the key of what really is in them */
+
+  handKey = qword(0);
+  for(c = FIRST_COLOR; c <= LAST_COLOR; c = (color) (c + 1))
+    for(p = FIRST_PIECE; p <= LAST_PIECE; p = (piece) (p + 1))
+      for(n = 1; n <= hand[c][p]; n++)
+        handKey ^= hashHandNumbers[c][p][n];
+
 #ifdef DEBUG_HASH
   hashValueT = qword(0); 
 #endif
@@ -416,6 +452,11 @@ void zapHashValues()
   unsigned int n;
   int moveNrInit;
 
+  /* The other processes still need what's in a shared table.  It must not
+     be shared by engines with different parameters */
+
+  if (sharedHashName[0]) return;
+
   memset(lookupTable[WHITE], 0, stats_hashSize * sizeof(transpositionEntry));
   memset(lookupTable[BLACK], 0, stats_hashSize * sizeof(transpositionEntry));
 
@@ -441,6 +482,46 @@ void zapHashValues()
 }
 
 
+/* Function: swapTranspositionTable
+ * Input:    Where another table is kept, NULL pointers for a new one.
+ * Output:   0, -1 if there is not enough memory for a new one.
+ * Purpose:  Makes the other table the transposition table and keeps the
+ *           one we had in its place.  selfplay.cpp gives the engines with
+ *           different parameters a table each this way.  A new table is 
+ *           empty and as big as ours, the caller frees it.
+ */
+
+int swapTranspositionTable(transpositionEntry *other[COLORS])
+{
+  transpositionEntry *table;
+  color c;
+
+  if (!other[WHITE] || !other[BLACK])
+  {
+    for (c = FIRST_COLOR; c <= LAST_COLOR; c++)
+      other[c] = (transpositionEntry *) 
+        calloc(lookupMask + 1, sizeof(transpositionEntry));
+
+    if (!other[WHITE] || !other[BLACK])
+    {
+      free(other[WHITE]);
+      free(other[BLACK]);
+      other[WHITE] = other[BLACK] = NULL;
+      return -1;
+    }
+  }
+
+  for (c = FIRST_COLOR; c <= LAST_COLOR; c++)
+  {
+    table = lookupTable[c];
+    lookupTable[c] = other[c];
+    other[c] = table;
+  }
+
+  return 0;
+}
+
+
 /* Function: addToHash
  * Input:    A color, a piece and a square.
  * Output:   None.
@@ -471,6 +552,7 @@ void boardStruct::addToInHandHash(color c, piece p)
 {
     
   hashValue ^= hashHandNumbers[c][p][hand[c][p]];
+  handKey ^= hashHandNumbers[c][p][hand[c][p]];
 
 #ifdef DEBUG_HASH
   hashValueT ^= hashHandNumbersT[c][p][hand[c][p]];
@@ -489,6 +571,7 @@ void boardStruct::subtractFromInHandHash(color c, piece p)
 {
   
   hashValue ^= hashHandNumbers[c][p][hand[c][p]+1];
+  handKey ^= hashHandNumbers[c][p][hand[c][p]+1];
 
 #ifdef DEBUG_HASH
   hashValueT ^= hashHandNumbersT[c][p][hand[c][p]+1];
@@ -536,6 +619,27 @@ void boardStruct::addEnPassantHash(square sq)
 }
 
 
+/* Function: entryCheck
+ * Input:    A transposition table entry.
+ * Output:   48 bits that depend on everything in it but the hash.
+ * Purpose:  The hash of an entry is stored XORed with these.
+ */
+
+static inline qword entryCheck(transpositionEntry *entry)
+{
+  duword moveData;
+  qword data;
+
+  memcpy(&moveData, &entry->hashMove, sizeof(duword));
+
+  data = (qword) moveData | ((qword) (word) entry->value << 32) |
+         ((qword) entry->depth << 48) | ((qword) entry->type << 56) |
+         ((qword) entry->moveNr << 60);
+
+  return (data * qword(0x9E3779B97F4A7C15)) >> 16;
+}
+
+
 /* Function: store
  * Input:    How deep the search was, what the best move it found was, what it
  *           thought the value of the position was and what kind of value it
@@ -544,13 +648,16 @@ void boardStruct::addEnPassantHash(square sq)
  *			 store() was called from.
  * Output:   None.
  * Purpose:  Stores the position in the transposition table so that it can
- *           be looked up in the future.
+ *           be looked up in the future.  The entry is made in a copy and
+ *           written back as a whole.
  */
 
 void boardStruct::store(int depthSearched, move bestMove,
 			int value, int alpha, int beta)
 { 
   duword offset;
+  transpositionEntry entry;
+  int old;
 
 
 assert (depthSearched <= 128);
@@ -570,9 +677,16 @@ assert  (hashMoveCircle <= 7);
 
 
   offset = (duword) (hashValue & lookupMask);  
+  entry = lookupTable[onMove][offset];
+
+  /* The other processes or threads sharing the table count their moves 
+     themselves, so an entry of theirs isn't old because its moveNr is 
+     different */
 
+  old = !sharedHashName[0] && !sharedHashEngines && 
+        (hashMoveCircle != entry.moveNr);
   
-  if (hashMoveCircle != lookupTable[onMove][offset].moveNr) 
+  if (old) 
 
   {
 	  stats_hashFillingUp++; 
@@ -587,61 +701,54 @@ assert  (hashMoveCircle <= 7);
   // c) is a bit dubious, but only 1% are exact scores, and with a big 
   // hash table we should be ok
   
-  if ((hashMoveCircle != lookupTable[onMove][offset].moveNr) 
-	  || (depthSearched > lookupTable[onMove][offset].depth) 
-	  || ((lookupTable[onMove][offset].type != EXACT) 
+  if (old
+	  || (depthSearched > entry.depth) 
+	  || ((entry.type != EXACT) 
 	  && (((value < beta) && (value > alpha)) || (value >= MATE) || (value <= -MATE) )))
   
   {
-    lookupTable[onMove][offset].hash = hashValue >> 16;
-
 #ifdef DEBUG_HASH 
-	lookupTable[onMove][offset].hashT = hashValueT >> 16;
+	entry.hashT = hashValueT >> 16;
 #endif
 
     if((value < beta) && (value > alpha))
 	{
-      lookupTable[onMove][offset].type = EXACT;
-     
-	  lookupTable[onMove][offset].value = sword (value);
-	  lookupTable[onMove][offset].depth = byte (depthSearched);
-	  lookupTable[onMove][offset].moveNr = byte (hashMoveCircle);
+      entry.type = EXACT;
     }
     else if(value >= beta) 
 	{      
 	  if(value >= MATE) 
 	  {
-		  lookupTable[onMove][offset].type = EXACT;
+		  entry.type = EXACT;
 		  depthSearched = MAX_SEARCH_DEPTH * ONE_PLY; 
 	  }
-	  else lookupTable[onMove][offset].type = FAIL_HIGH;
-
-	  lookupTable[onMove][offset].value = sword (value);
-	  lookupTable[onMove][offset].depth = byte (depthSearched);
-	  lookupTable[onMove][offset].moveNr = byte (hashMoveCircle);
+	  else entry.type = FAIL_HIGH;
     } 
-	else if(value <= alpha) 
+	else 
 	{            
 	  if(value <= -MATE) 
 	  {  
-		  lookupTable[onMove][offset].type = EXACT;
+		  entry.type = EXACT;
 		  depthSearched = MAX_SEARCH_DEPTH * ONE_PLY; 
 	  }
-	  else lookupTable[onMove][offset].type = FAIL_LOW;
-
-	  lookupTable[onMove][offset].value = sword (value);
-	  lookupTable[onMove][offset].depth = byte (depthSearched);
-	  lookupTable[onMove][offset].moveNr = byte (hashMoveCircle);
+	  else entry.type = FAIL_LOW;
     } 
 
+	entry.value = sword (value);
+	entry.depth = byte (depthSearched);
+	entry.moveNr = byte (hashMoveCircle);
+
 	if(!bestMove.isBad()) 
 	{
-      lookupTable[onMove][offset].hashMove = bestMove;
+      entry.hashMove = bestMove;
     } 
 	else 
 	{
-      lookupTable[onMove][offset].hashMove.makeBad();
+      entry.hashMove.makeBad();
     }	
+
+    entry.hash = (hashValue >> 16) ^ entryCheck(&entry);
+    lookupTable[onMove][offset] = entry;
   }
 	
 
@@ -652,23 +759,23 @@ assert  (hashMoveCircle <= 7);
  * Input:    None.
  * Output:   The transpositionEntry that corresponds to this position (if any)
  * Purpose:  Used to find if the position was searched before and we "remember"
- *           the result.
+ *           the result.  It's a copy that is good until the next lookup().
  */
 
 transpositionEntry *boardStruct::lookup()
 {
-
-
+  static SEARCH_LOCAL transpositionEntry entry;
   duword offset;
 	
   offset = (duword) (hashValue & lookupMask);
+  entry = lookupTable[onMove][offset];
 
-  if ((lookupTable[onMove][offset].hash == hashValue >> 16)) { 
+  if (entry.hash == (((hashValue >> 16) ^ entryCheck(&entry)) & qword(0xFFFFFFFFFFFF))) { 
 
 	  
 #ifdef DEBUG_HASH
 	  
-	  if (lookupTable[onMove][offset].hashT != hashValueT >> 16)
+	  if (entry.hashT != hashValueT >> 16)
 	  { 
 		  debug_allcoll++; 	
 	  }
@@ -676,17 +783,20 @@ transpositionEntry *boardStruct::lookup()
 #endif 
 	  
 
-	  if (lookupTable[onMove][offset].moveNr != hashMoveCircle) 
+	  if (!sharedHashName[0] && !sharedHashEngines && 
+		  (entry.moveNr != hashMoveCircle)) 
 	  {
-      lookupTable[onMove][offset].moveNr = hashMoveCircle;	
+      entry.moveNr = hashMoveCircle;	
+      entry.hash = (hashValue >> 16) ^ entryCheck(&entry);
+      lookupTable[onMove][offset] = entry;
 	  }
 
 
-	  assert (lookupTable[onMove][offset].depth >= 0 );
-	  assert (lookupTable[onMove][offset].depth <= 128); 
+	  assert (entry.depth >= 0 );
+	  assert (entry.depth <= 128); 
 
 
-    return &lookupTable[onMove][offset];
+    return &entry;
   }
   else return NULL;
 }
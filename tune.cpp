@@ -0,0 +1,503 @@
+/* ***************************************************************************
+ *                                Sunsetter                                  *
+ *               (c) Ben Dean-Kawamura, Georg v. Zimmermann                  *
+ *   For license terms, see the file COPYING that came with this program.    *
+ *                                                                           *
+ *  Name: tune.cpp                                                           *
+ *                                                                           *
+ *  Purpose: fits the evaluation parameters to the results of the games in   *
+ *           a bpgn file (Texel method).                                     *
+ *                                                                           *
+ *  The Command line for tune() is:                                          *
+ *  "sunsetter tune <bpgn file to read> <ini file to write*> <processes*>"   *
+ *                                                                           *
+ *  where the ini file is optional, it defaults to ss-tuned.ini.  The        *
+ *  positions are scored by that many forked processes, one for each CPU if *
+ *  it's not given.  All quiet                                               *
+ *  positions of the games are scored with quiesce(), and the score is       *
+ *  mapped to an expected result with 1 / (1 + 10^(-K * score / 400)).  K is *
+ *  fitted first, then the parameters are changed one at a time as long as   *
+ *  the mean squared error between expected and real results goes down.     *
+ *  The parameters are written in the ini format after every improvement,    *
+ *  so the file can be given to "personality" or copied to ss-7g.ini.        *
+ *                                                                           *
+ *  Comments: The games are kept as move lists and replayed on AIBoard for   *
+ *            every pass, so material and development are always computed    *
+ *            with the parameters being tried.  Pawns stay at 100 points.    *
+ *            The development tables are tuned by a percent for each         *
+ *            piece, "pdefactor" ... "kdefactor".                            *
+ *                                                                           *
+ *************************************************************************** */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <math.h>
+
+#include "board.h"
+#include "brain.h"
+#include "bughouse.h"
+#include "notation.h"
+#include "interface.h"
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#define TUNE_PROCESSES
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+extern SEARCH_LOCAL volatile int stopThinking;
+
+void nextToken(FILE *f, char *str);
+
+/* The first moves of a game are mostly book moves, skip them */
+#define TUNE_SKIP_PLY (8)
+
+/* Positions where quiesce() and eval() differ by more than this
+   are not quiet */
+#define TUNE_QUIET_MARGIN (30)
+
+/* Most processes that score the positions */
+#define MAX_TUNE_PROCESSES (64)
+
+/* One game from the bpgn file, and which of its positions are used */
+
+struct tuneGame {
+
+  move *moves;
+  char *quiet;
+  int count;
+  int score;		/* Where its scores start in tuneScores */
+  double result;
+
+};
+
+static tuneGame *tuneGames = NULL;
+static int tuneGameCount = 0;
+static int tunePositionCount = 0;
+static int *tuneScores = NULL;
+static int tuneProcesses = 1;
+
+/* The parameters that are tuned, with the ini command to set them */
+
+static int *tuneParams[] = { &pValue[ROOK], &pValue[KNIGHT], &pValue[BISHOP],
+	&pValue[QUEEN], &BC_FACTOR, &NK_FACTOR, &DE_FACTOR, &DE_SCALE[PAWN], 
+	&DE_SCALE[ROOK], &DE_SCALE[KNIGHT], &DE_SCALE[BISHOP], &DE_SCALE[QUEEN],
+	&DE_SCALE[KING] };
+static const char *tuneNames[] = { "rvalue", "nvalue", "bvalue",
+	"qvalue", "bcfactor", "nkfactor", "defactor", "pdefactor", 
+	"rdefactor", "ndefactor", "bdefactor", "qdefactor", "kdefactor" };
+static const int tuneSteps[] = { 4, 4, 4, 8, 1, 1, 1, 10, 10, 10, 10, 10, 10 };
+
+#define TUNE_PARAMS ((int) (sizeof(tuneSteps) / sizeof(tuneSteps[0])))
+
+/* Function: tuneResetBoard
+ * Input:    None
+ * Output:   None
+ * Purpose:  Puts AIBoard in the starting position.
+ */
+
+static void tuneResetBoard()
+{
+	AIBoard.resetBoard();
+	AIBoard.playCrazyhouse();
+}
+
+/* Function: tuneQuiesce
+ * Input:    None
+ * Output:   The quiesce() value of AIBoard from white's point of view
+ * Purpose:  Scores one position.
+ */
+
+static int tuneQuiesce()
+{
+	int value;
+
+	value = quiesce(-INFINITY, INFINITY, 1);
+	if (AIBoard.getColorOnMove() == BLACK) value = -value;
+
+	return value;
+}
+
+/* Function: tuneLoadGames
+ * Input:    A bpgn file
+ * Output:   The number of positions found
+ * Purpose:  Reads all games of the file (board A only) and marks the quiet
+ *           positions.  Games without a result, that were not finished (*)
+ *           or with an illegal move are skipped.
+ */
+
+static int tuneLoadGames(FILE *fin)
+{
+	char buf[MAX_STRING], ch;
+	move m, gameMoves[MAX_GAME_LENGTH];
+	char quiet[MAX_GAME_LENGTH];
+	int count, n, i, eval, usable;
+	tuneGame *g;
+
+	for (;;)
+	{
+		tuneResetBoard();
+		count = 0;
+		usable = 1;
+
+		/* read the moves up to the result */
+
+		for (;;)
+		{
+			nextToken(fin, buf);
+			if (buf[0] == '\0') return tunePositionCount;
+
+			if (!strcmp(buf, "*"))
+			{
+				usable = 0;
+				break;
+			}
+
+			if (!strcmp(buf, "1-0") || !strcmp(buf, "0-1") ||
+				!strcmp(buf, "1/2-1/2")) break;
+
+			if (buf[0] == '[' || buf[0] == '{') continue;
+
+			ch = 0;
+			if (sscanf(buf, "%i%c", &i, &ch) != 2 || toupper(ch) != 'A') continue;
+
+			nextToken(fin, buf);
+			if (!usable) continue;
+
+			m = AIBoard.algebraicMoveToDBMove(buf);
+			if (m.isBad() || !AIBoard.isLegal(m) || count >= MAX_GAME_LENGTH - 2)
+			{
+				usable = 0;
+				continue;
+			}
+
+			/* the position before the move */
+
+			quiet[count] = 0;
+			if (count >= TUNE_SKIP_PLY && !AIBoard.isInCheck(AIBoard.getColorOnMove()))
+			{
+				eval = AIBoard.eval();
+				if (AIBoard.getColorOnMove() == BLACK) eval = -eval;
+				if (abs(tuneQuiesce() - eval) <= TUNE_QUIET_MARGIN
+					&& abs(eval) < EXTREME_EVAL) quiet[count] = 1;
+			}
+
+			AIBoard.changeBoard(m);
+			gameMoves[count++] = m;
+		}
+
+		if (!usable || !count) continue;
+
+		tuneGames = (tuneGame *) realloc(tuneGames, (tuneGameCount + 1) * sizeof(tuneGame));
+		g = &tuneGames[tuneGameCount++];
+
+		g->count = count;
+		g->score = tunePositionCount;
+		g->moves = (move *) malloc(count * sizeof(move));
+		g->quiet = (char *) malloc(count);
+		memcpy(g->moves, gameMoves, count * sizeof(move));
+		memcpy(g->quiet, quiet, count);
+
+		if (!strcmp(buf, "1-0")) g->result = 1.0;
+		else if (!strcmp(buf, "0-1")) g->result = 0.0;
+		else g->result = 0.5;
+
+		for (n = 0; n < count; n++) tunePositionCount += g->quiet[n];
+	}
+}
+
+/* Function: tuneScoreGames
+ * Input:    The first game and the one after the last
+ * Output:   None
+ * Purpose:  Scores the quiet positions of those games.
+ */
+
+static void tuneScoreGames(int first, int last)
+{
+	int g, n, p;
+
+	for (g = first; g < last; g++)
+	{
+		tuneResetBoard();
+		p = tuneGames[g].score;
+		for (n = 0; n < tuneGames[g].count; n++)
+		{
+			if (tuneGames[g].quiet[n]) tuneScores[p++] = tuneQuiesce();
+			AIBoard.changeBoard(tuneGames[g].moves[n]);
+		}
+	}
+}
+
+/* Function: tuneFirstScore
+ * Input:    A game, or tuneGameCount
+ * Output:   Where its scores start in tuneScores
+ * Purpose:  Lets a range of games be turned into a range of scores.
+ */
+
+static int tuneFirstScore(int g)
+{
+	return (g < tuneGameCount) ? tuneGames[g].score : tunePositionCount;
+}
+
+/* Function: tuneScoreAll
+ * Input:    None
+ * Output:   None
+ * Purpose:  Scores all quiet positions with the current parameters.  The
+ *           games are split into tuneProcesses parts with about as many
+ *           positions each, and each part is scored by a forked process
+ *           that sends the scores back through a pipe.  A part that
+ *           can't be forked or whose process dies is scored here.
+ */
+
+static void tuneScoreAll()
+{
+#ifdef TUNE_PROCESSES
+	int fd[MAX_TUNE_PROCESSES], bound[MAX_TUNE_PROCESSES + 1];
+	pid_t pid[MAX_TUNE_PROCESSES];
+	int pipeFd[2], n, g, bytes, got;
+	char *buf;
+#endif
+
+	initializeEval();
+	stopThinking = 0;
+
+	/* What was found so far is seen now, and the processes don't have it */
+
+	flushOutput(1);
+
+#ifdef TUNE_PROCESSES
+	if (tuneProcesses > 1)
+	{
+		for (n = g = 0; n < tuneProcesses; n++)
+		{
+			while ((g < tuneGameCount) && ((double) tuneGames[g].score * 
+				tuneProcesses < (double) n * tunePositionCount)) g++;
+			bound[n] = g;
+		}
+		bound[tuneProcesses] = tuneGameCount;
+
+		for (n = 0; n < tuneProcesses; n++)
+		{
+			pid[n] = -1;
+			if (bound[n] == bound[n + 1] || pipe(pipeFd)) continue;
+
+			pid[n] = fork();
+			if (!pid[n])
+			{
+				close(pipeFd[0]);
+				tuneScoreGames(bound[n], bound[n + 1]);
+
+				buf = (char *) &tuneScores[tuneFirstScore(bound[n])];
+				bytes = (tuneFirstScore(bound[n + 1]) - 
+					tuneFirstScore(bound[n])) * sizeof(int);
+				while (bytes > 0 && (got = write(pipeFd[1], buf, bytes)) > 0)
+				{
+					buf += got;
+					bytes -= got;
+				}
+				_exit(bytes ? 1 : 0);
+			}
+
+			close(pipeFd[1]);
+			if (pid[n] == -1) close(pipeFd[0]);
+			else fd[n] = pipeFd[0];
+		}
+
+		for (n = 0; n < tuneProcesses; n++)
+		{
+			if (pid[n] != -1)
+			{
+				buf = (char *) &tuneScores[tuneFirstScore(bound[n])];
+				bytes = (tuneFirstScore(bound[n + 1]) - 
+					tuneFirstScore(bound[n])) * sizeof(int);
+				while (bytes > 0 && (got = read(fd[n], buf, bytes)) > 0)
+				{
+					buf += got;
+					bytes -= got;
+				}
+				close(fd[n]);
+				waitpid(pid[n], NULL, 0);
+				if (!bytes) continue;
+			}
+			tuneScoreGames(bound[n], bound[n + 1]);
+		}
+		return;
+	}
+#endif
+
+	tuneScoreGames(0, tuneGameCount);
+}
+
+/* Function: tuneError
+ * Input:    The scaling constant K
+ * Output:   The mean squared error of the scored positions
+ * Purpose:  Measures how well the scores predict the game results.
+ */
+
+static double tuneError(double k)
+{
+	double error = 0, sigmoid;
+	int g, n, p;
+
+	for (p = g = 0; g < tuneGameCount; g++)
+	{
+		for (n = 0; n < tuneGames[g].count; n++)
+		{
+			if (!tuneGames[g].quiet[n]) continue;
+			sigmoid = 1.0 / (1.0 + pow(10.0, -k * tuneScores[p++] / 400.0));
+			error += (tuneGames[g].result - sigmoid) * (tuneGames[g].result - sigmoid);
+		}
+	}
+
+	return error / tunePositionCount;
+}
+
+/* Function: tuneFitK
+ * Input:    None
+ * Output:   The K with the smallest error for the current scores
+ * Purpose:  Golden section search for K.
+ */
+
+static double tuneFitK()
+{
+	double a = 0.1, b = 3.0, c, d, r = (sqrt(5.0) - 1.0) / 2.0;
+	int n;
+
+	for (n = 0; n < 40; n++)
+	{
+		c = b - r * (b - a);
+		d = a + r * (b - a);
+		if (tuneError(c) < tuneError(d)) b = d;
+		else a = c;
+	}
+
+	return (a + b) / 2.0;
+}
+
+/* Function: tuneWriteIni
+ * Input:    The file name
+ * Output:   None
+ * Purpose:  Writes the parameters so parseOption() can read them back.
+ */
+
+static void tuneWriteIni(const char *fileName)
+{
+	FILE *fout;
+	int n;
+
+	fout = fopen(fileName, "wt");
+	if (!fout) return;
+
+	for (n = 0; n < TUNE_PARAMS; n++)
+		fprintf(fout, "%s %d\n", tuneNames[n], *tuneParams[n]);
+
+	fclose(fout);
+}
+
+/* Function: tune
+ * Input:    the arguments Sunsetter was called with
+ * Output:   0, 1 if an error occured
+ * Purpose:  Tunes the eval parameters, see the top of the file.
+ */
+
+int tune(int argc, char **argv)
+{
+	char buf[MAX_STRING];
+	const char *fileName;
+	double k, best, error;
+	int n, improved, pass, dir;
+	FILE *fin;
+
+	if ((argc < 3) || (argc > 5)) {
+		output("Usage:\n");
+		output("sunsetter tune <input file> <output ini*> <processes*>  * = optional\n");
+		return (1);
+	}
+
+	fileName = (argc >= 4) ? argv[3] : "ss-tuned.ini";
+
+#ifdef TUNE_PROCESSES
+	if (argc == 5) tuneProcesses = atoi(argv[4]);
+	else tuneProcesses = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	tuneProcesses = max(1, min(tuneProcesses, MAX_TUNE_PROCESSES));
+#endif
+
+	fin = fopen(argv[2], "rt");
+	if (!fin) {
+		sprintf(buf, "failed to open file %s for tuning\n", argv[2]);
+		output(buf);
+		return (1);
+	}
+
+	ignoreInput = 1;
+	currentRules = CRAZYHOUSE;
+	stopThinking = 0;
+
+	tuneLoadGames(fin);
+	fclose(fin);
+
+	sprintf(buf, "Tune: %d games, %d quiet positions, %d processes\n", 
+		tuneGameCount, tunePositionCount, tuneProcesses);
+	output(buf);
+	if (!tunePositionCount) return (1);
+
+	tuneScores = (int *) malloc(tunePositionCount * sizeof(int));
+
+	tuneScoreAll();
+	k = tuneFitK();
+	best = tuneError(k);
+
+	sprintf(buf, "Tune: K = %.4f, error = %.6f\n", k, best);
+	output(buf);
+
+	for (pass = 1, improved = 1; improved; pass++)
+	{
+		improved = 0;
+
+		for (n = 0; n < TUNE_PARAMS; n++)
+		{
+			for (dir = 1; dir >= -1; dir -= 2)
+			{
+				/* none of the weights make sense below zero */
+
+				if (*tuneParams[n] + dir * tuneSteps[n] < 0) continue;
+
+				*tuneParams[n] += dir * tuneSteps[n];
+				tuneScoreAll();
+				error = tuneError(k);
+
+				if (error < best)
+				{
+					best = error;
+					improved = 1;
+					tuneWriteIni(fileName);
+
+					sprintf(buf, "Tune: pass %d %s %d error = %.6f\n", pass,
+						tuneNames[n], *tuneParams[n], best);
+					output(buf);
+					break;
+				}
+
+				*tuneParams[n] -= dir * tuneSteps[n];
+			}
+		}
+	}
+
+	tuneWriteIni(fileName);
+	sprintf(buf, "Tune: done, parameters written to %s\n", fileName);
+	output(buf);
+
+	for (n = 0; n < tuneGameCount; n++)
+	{
+		free(tuneGames[n].moves);
+		free(tuneGames[n].quiet);
+	}
+	free(tuneGames);
+	free(tuneScores);
+	ignoreInput = 0;
+
+	return (0);
+}
@@ -39,6 +39,123 @@ int boardStruct::isLegal(move m)
    }
 
 
+/* 
+ * Function: isPseudoLegal.
+ * Input:    A Move.
+ * Output:   Whether the move is one that moves() could generate, without 
+ *           checking that it doesn't leave the king in check.
+ * Purpose:  Used by the search to check the hash move without generating 
+ *           all moves.  The caller has to see if the king is in check
+ *           after the move is made.
+ */
+
+int boardStruct::isPseudoLegal(move m)
+   {
+   square from, to;
+   piece p;
+   bitboard unoccupied;
+
+   if (m.isBad()) 
+      return 0;
+
+   from = m.from();
+   to = m.to();
+   p = m.moved();
+
+   if (to >= SQUARES || p < FIRST_PIECE || p > LAST_PIECE) 
+      return 0;
+
+   unoccupied = ~(occupied[WHITE] | occupied[BLACK]);
+
+   /* Drops need the piece in hand and an empty square, pawns can't go to
+      the first or last rank */
+
+   if (from == IN_HAND) 
+      {
+      if (!hand[onMove][p] || m.promotion() != NONE || !unoccupied.squareIsSet(to)) 
+         return 0;
+      if (p == PAWN && (bitboard(FIRST_RANK | EIGHTH_RANK)).squareIsSet(to)) 
+         return 0;
+      return 1;
+      }
+
+   if (from >= SQUARES || position[from] != p || !occupied[onMove].squareIsSet(from) ||
+       occupied[onMove].squareIsSet(to)) 
+      return 0;
+
+   /* Pawns promote on the last rank and only there, they push to an empty 
+      square or capture, including en passant */
+
+   if (p == PAWN) 
+      {
+      if ((bitboard(FIRST_RANK | EIGHTH_RANK)).squareIsSet(to)) 
+         {
+         if (m.promotion() == NONE || m.promotion() == PAWN || m.promotion() == KING) 
+            return 0;
+         }
+      else if (m.promotion() != NONE) 
+         return 0;
+
+      if (pawnAttacksFrom(onMove, from).squareIsSet(to))
+         return occupied[otherColor(onMove)].squareIsSet(to) || 
+                (to == enPassant && enPassant != OFF_BOARD);
+
+      if (!unoccupied.squareIsSet(to)) 
+         return 0;
+
+      if (onMove == WHITE) 
+         return (to == from + ONE_RANK) || 
+                (to == from + TWO_RANKS && (bitboard(FOURTH_RANK)).squareIsSet(to) &&
+                 unoccupied.squareIsSet(from + ONE_RANK));
+      else 
+         return (to == from - ONE_RANK) || 
+                (to == from - TWO_RANKS && (bitboard(FIFTH_RANK)).squareIsSet(to) &&
+                 unoccupied.squareIsSet(from - ONE_RANK));
+      }
+
+   if (m.promotion() != NONE) 
+      return 0;
+
+   /* The king, including castling with the same tests as aiMoves() */
+
+   if (p == KING) 
+      {
+      if (kingAttacks[from].squareIsSet(to)) 
+         return 1;
+
+      if (isInCheck(onMove)) 
+         return 0;
+
+      if (onMove == WHITE && from == E1 && to == G1)
+         return canCastle[WHITE][KING_SIDE] && position[F1] == NONE && 
+                position[G1] == NONE && attacks[BLACK][F1] == 0 &&
+                attacks[BLACK][G1] == 0;
+
+      if (onMove == WHITE && from == E1 && to == C1)
+         return canCastle[WHITE][QUEEN_SIDE] && position[D1] == NONE &&
+                position[C1] == NONE && position[B1] == NONE &&
+                attacks[BLACK][D1] == 0 && attacks[BLACK][C1] == 0;
+
+      if (onMove == BLACK && from == E8 && to == G8)
+         return canCastle[BLACK][KING_SIDE] && position[F8] == NONE &&
+                position[G8] == NONE && attacks[WHITE][F8] == 0 &&
+                attacks[WHITE][G8] == 0;
+
+      if (onMove == BLACK && from == E8 && to == C8)
+         return canCastle[BLACK][QUEEN_SIDE] && position[D8] == NONE &&
+                position[C8] == NONE && position[B8] == NONE &&
+                attacks[WHITE][D8] == 0 && attacks[WHITE][C8] == 0;
+
+      return 0;
+      }
+
+   if (p == KNIGHT) 
+      return knightAttacks[from].squareIsSet(to);
+
+   return attacksFrom(p, from).squareIsSet(to);
+   }
+
+
 /*
  * Function: isInCheck.
  * Input:    A color.